@@ -0,0 +1,55 @@
+#include "Amr2UGrid.h"
+#include "Amr2UGridStream.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+using namespace std;
+using namespace Amr2Ugrid;
+
+int main(int argc, char* argv[])
+{
+  // verification du nombre minimal d'arguments
+  if( argc<2 )
+    {
+      cerr<<"Utilisation: "<<argv[0]<<" nom_du_test [-dump] [-stream memoire_Mo] [-fullnbh]"<<endl;
+      return 1;
+    }
+
+  string baseName = argv[1];
+  bool dumpFiles = false;
+  size_t streamBudget = 0;
+  // -fullnbh : ancien format .nbh, un cube de voisinage complet par noeud
+  AmrConnect<3>::Layout nbhLayout = AmrConnect<3>::OnDemand;
+  for(int i=2;i<argc;i++)
+    {
+      if( string(argv[i]) == "-dump" ) dumpFiles = true;
+      else if( string(argv[i]) == "-stream" && (i+1)<argc ) streamBudget = size_t( atof(argv[++i]) * 1024 * 1024 );
+      else if( string(argv[i]) == "-fullnbh" ) nbhLayout = AmrConnect<3>::FullCubes;
+    }
+
+  // conversion hors memoire : les fichiers intermediaires sont toujours ecrits
+  if( streamBudget > 0 )
+    {
+      Amr2UGridStream<3> amr2ugrid(baseName, streamBudget, nbhLayout);
+      if( ! amr2ugrid.run(cout) )
+	{
+	  return 1;
+	}
+      amr2ugrid.toStream(cout);
+      cout<<"Timings :"<<endl;
+      amr2ugrid.timings().toStream(cout);
+      return 0;
+    }
+
+  Amr2UGrid<3> amr2ugrid(baseName, dumpFiles, nbhLayout);
+  if( ! amr2ugrid.run(cout) )
+    {
+      return 1;
+    }
+  amr2ugrid.toStream(cout);
+  cout<<"Timings :"<<endl;
+  amr2ugrid.timings().toStream(cout);
+
+  return 0;
+}
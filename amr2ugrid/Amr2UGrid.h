@@ -0,0 +1,326 @@
+#ifndef __AMR_2_UGRID_H
+#define __AMR_2_UGRID_H
+
+#include "Vec.h"
+#include "AmrCellSize.h"
+#include "PointIds.h"
+#include "MeshInfo.h"
+#include "AmrLevels.h"
+#include "AmrTree.h"
+#include "AmrHyperCubeTree.h"
+#include "AmrConnect.h"
+#include "AmrSidePoints.h"
+#include "AmrUGrid.h"
+#include "MeshFile.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+
+namespace Amr2Ugrid
+{
+
+	using namespace hct;
+
+	/*
+	 * Per stage elapsed times
+	 */
+	struct StageTimings
+	{
+		using Clock = std::chrono::high_resolution_clock;
+
+		inline void start()
+		{
+			m_start = Clock::now();
+		}
+
+		inline void stop(const std::string& stage)
+		{
+			auto usec = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_start);
+			m_stages.push_back( std::make_pair(stage, static_cast<long long>(usec.count())) );
+		}
+
+		inline long long total() const
+		{
+			long long t = 0;
+			for(const auto& s : m_stages) t += s.second;
+			return t;
+		}
+
+		template <typename StreamT>
+		inline void toStream(StreamT& out) const
+		{
+			for(const auto& s : m_stages)
+			{
+				out<<s.first<<" : "<<s.second<<" uSec\n";
+			}
+			out<<"total : "<<total()<<" uSec\n";
+		}
+
+		std::vector< std::pair<std::string,long long> > m_stages;
+		Clock::time_point m_start;
+	};
+
+	/*
+	 * The whole amr2ugrid chain (MeshInfo, AmrLevels, AmrTree, AmrConnect, AmrSidePoints, AmrUGrid) run in a single process.
+	 * The tree is built as an hct::HyperCubeTree (m_hcTree), m_tree is its legacy view.
+	 * Each stage works on the buffers produced by the previous ones.
+	 * When dumpFiles is set, each stage also writes the files the corresponding legacy executable produces,
+	 * so that any legacy tool can be run on them.
+	 * The final unstructured grid is always written to <baseName>.ugrid.
+	 */
+	template<unsigned int _D = 3>
+	struct Amr2UGrid
+	{
+		enum { D = _D };
+		using Vec3 = hct::Vec<float,D>;
+		using CellSize = hct::AmrCellSize<float,D>;
+		using Levels = Amr2Ugrid::AmrLevels<float,D>;
+		using Connect = Amr2Ugrid::AmrConnect<D>;
+		using SidePoints = Amr2Ugrid::AmrSidePoints<D>;
+		using UGrid = Amr2Ugrid::AmrUGrid<D>;
+
+		inline Amr2UGrid(const std::string& baseName, bool dumpFiles = false, typename Connect::Layout nbhLayout = Connect::OnDemand)
+			: m_baseName(baseName), m_dumpFiles(dumpFiles), m_nbhLayout(nbhLayout) {}
+
+		inline ~Amr2UGrid()
+		{
+			if( m_indices != 0 ) delete [] m_indices;
+		}
+
+		Amr2UGrid(const Amr2UGrid&) = delete;
+		Amr2UGrid& operator = (const Amr2UGrid&) = delete;
+
+		// reads <baseName>.bin and runs all stages
+		template <typename StreamT>
+		inline bool run(StreamT& log)
+		{
+			std::string binFileName = m_baseName + ".bin";
+			log<<"<- "<<binFileName<<"\n";
+			m_timings.start();
+			if( ! readMesh() )
+			{
+				log<<"Erreur de lecture de "<<binFileName<<" : "<<m_readError<<"\n";
+				return false;
+			}
+			m_timings.stop("readMesh");
+
+			m_timings.start(); meshInfo(); m_timings.stop("MeshInfo");
+			m_timings.start(); amrLevels(); m_timings.stop("AmrLevels");
+			m_timings.start(); amrTree(); m_timings.stop("AmrTree");
+			m_timings.start(); amrConnect(); m_timings.stop("AmrConnect");
+			m_timings.start(); amrSidePoints(); m_timings.stop("AmrSidePoints");
+			m_timings.start(); amrUGrid(); m_timings.stop("AmrUGrid");
+
+			m_timings.start();
+			std::ofstream fic;
+			openDump(fic, ".ugrid", log);
+			m_ugrid.toBinaryStream(fic);
+			fic.close();
+			m_timings.stop("writeUGrid");
+
+			if( m_dumpFiles )
+			{
+				m_timings.start(); dumpFiles(log); m_timings.stop("dump");
+			}
+			return true;
+		}
+
+		// ---------------------------- stages ----------------------------
+
+		inline bool readMesh()
+		{
+			std::string binFileName = m_baseName + ".bin";
+			if( ! m_file.open(binFileName.c_str()) )
+			{
+				m_readError = m_file.error();
+				return false;
+			}
+			m_mesh.nCells = m_file.nCells();
+			m_indices = new PointIds<D>[ m_mesh.nCells ];
+			if( ! m_file.readCells(m_indices) )
+			{
+				m_readError = m_file.error();
+				return false;
+			}
+			// points and scalars stay in the mapping, m_file lives as long as the pipeline
+			m_geom.setPointsView( m_file.nPoints(), m_file.points() );
+			m_scalars = m_file.scalars();
+			return true;
+		}
+
+		inline void meshInfo()
+		{
+			m_centers.resize(m_mesh.nCells);
+			m_sizes.resize(m_mesh.nCells);
+			m_geom.computeCellInfo(m_mesh, m_indices, m_centers.data(), m_sizes.data(), m_bmin, m_bmax);
+			delete [] m_indices;
+			m_indices = 0;
+		}
+
+		inline void amrLevels()
+		{
+			int nCells = m_mesh.nCells;
+			m_depth.resize(nCells);
+			m_levels.fromCellSizes( nCells, m_sizes.data(), m_bmax - m_bmin, m_depth.data() );
+		}
+
+		inline void amrTree()
+		{
+			int nCells = m_mesh.nCells;
+			m_hcTree.initLevels( m_levels.nLevels, m_levels.levelInfo );
+			m_m2t.resize(nCells);
+			m_hcTree.insertCells( nCells, m_centers.data(), m_depth.data(), m_bmin, m_levels.levelSize, m_m2t.data() );
+			// AmrConnect and AmrSidePoints still work on the legacy layout
+			m_hcTree.toAmrTree(m_tree);
+		}
+
+		inline void amrConnect()
+		{
+			m_connect.reset( new Connect(m_tree, m_levels.levelInfo, m_nbhLayout) );
+			m_connect->connectTree();
+		}
+
+		inline void amrSidePoints()
+		{
+			m_sidePoints.init(m_tree);
+			m_sidePoints.unifyPoints( m_tree, m_levels.levelInfo, *m_connect );
+			m_sidePoints.markPointOwners( m_tree );
+			m_sidePoints.countSidePoints( m_tree, *m_connect );
+			m_sidePoints.restorePointIdMap( m_tree );
+			m_sidePoints.buildSidePointArray( m_tree, *m_connect );
+		}
+
+		inline void amrUGrid()
+		{
+			m_ugrid.build( m_tree, m_levels.levelInfo, *m_connect, m_sidePoints, m_bmin, m_bmax,
+				       m_mesh.nCells, m_m2t.data(), m_depth.data(), m_scalars );
+		}
+
+		// ------------------- intermediate files, same as legacy tools -------------------
+
+		template <typename StreamT>
+		inline void dumpFiles(StreamT& log) const
+		{
+			int nCells = m_mesh.nCells;
+			std::ofstream fic;
+
+			openDump(fic, ".scal", log);
+			fic.write( (char*)&nCells, sizeof(int) );
+			fic.write( (char*)m_scalars, sizeof(float)*nCells );
+			fic.close();
+
+			openDump(fic, ".con", log);
+			m_mesh.toBinaryStream(fic);
+			fic.close();
+
+			openDump(fic, ".geom", log);
+			m_geom.toBinaryStream(fic);
+			fic.close();
+
+			openDump(fic, ".bnd", log);
+			fic.write( (char*)&m_bmin, sizeof(Vec3) );
+			fic.write( (char*)&m_bmax, sizeof(Vec3) );
+			fic.close();
+
+			openDump(fic, ".cc", log);
+			fic.write( (char*)&nCells, sizeof(int) );
+			fic.write( (char*)m_centers.data(), sizeof(Vec3)*nCells );
+			fic.close();
+
+			openDump(fic, ".cs", log);
+			fic.write( (char*)&nCells, sizeof(int) );
+			fic.write( (char*)m_sizes.data(), sizeof(CellSize)*nCells );
+			fic.close();
+
+			openDump(fic, ".dpt", log);
+			fic.write( (char*)&nCells, sizeof(int) );
+			fic.write( (char*)m_depth.data(), sizeof(int)*nCells );
+			fic.close();
+
+			openDump(fic, ".lvl", log);
+			m_levels.toBinaryStream(fic);
+			fic.close();
+
+			openDump(fic, ".m2t", log);
+			fic.write( (char*)&nCells, sizeof(int) );
+			fic.write( (char*)m_m2t.data(), sizeof(int)*nCells );
+			fic.close();
+
+			openDump(fic, ".tree", log);
+			m_tree.toBinaryStream(fic);
+			fic.close();
+
+			openDump(fic, ".nbh", log);
+			m_connect->toBinaryStream(fic);
+			fic.close();
+		}
+
+		template <typename StreamT>
+		inline void toStream(StreamT& out) const
+		{
+			m_mesh.toStream(out);
+			m_geom.toStream(out);
+			out<<"Domain bounds : ("; m_bmin.toStream(out); out<<") - ("; m_bmax.toStream(out); out<<")\n";
+			m_levels.toStream(out);
+			m_hcTree.toStream(out);
+			m_connect->toStream(out);
+			out<<"Nb points unifiés : "<<m_sidePoints.nPointIds<<"\n";
+			out<<"Nb points de feuilles : "<<m_sidePoints.nLeaves<<"\n";
+			out<<"Nb points de mailles speciales : "<<m_sidePoints.nSpecials<<"\n";
+			out<<"Nb points de cotés : "<<m_sidePoints.nSidePoints<<"\n";
+			m_ugrid.toStream(out);
+		}
+
+		inline const StageTimings& timings() const { return m_timings; }
+
+		// ---- Data ----
+		std::string m_baseName;
+		std::string m_readError;
+		bool m_dumpFiles;
+		typename Connect::Layout m_nbhLayout;
+		StageTimings m_timings;
+
+		// MeshInfo
+		MeshConnectivity<D> m_mesh;
+		hctreader::MeshFile m_file;
+		MeshGeometry<float,D> m_geom;
+		const float* m_scalars = 0; // view on m_file
+		PointIds<D>* m_indices = 0; // input cell vertices, until MeshInfo
+		Vec3 m_bmin, m_bmax;
+		std::vector<Vec3> m_centers;
+		std::vector<CellSize> m_sizes;
+
+		// AmrLevels
+		Levels m_levels;
+		std::vector<int> m_depth;
+
+		// AmrTree
+		AmrHyperCubeTree<D> m_hcTree;
+		AmrTree m_tree;
+		std::vector<int> m_m2t;
+
+		// AmrConnect, AmrSidePoints
+		std::unique_ptr<Connect> m_connect;
+		SidePoints m_sidePoints;
+
+		// AmrUGrid
+		UGrid m_ugrid;
+
+	private:
+		template <typename StreamT>
+		inline void openDump(std::ofstream& fic, const char* ext, StreamT& log) const
+		{
+			std::string fileName = m_baseName + ext;
+			log<<"-> "<<fileName<<"\n";
+			fic.open(fileName.c_str());
+		}
+	};
+
+}; // Amr2Ugrid
+
+#endif
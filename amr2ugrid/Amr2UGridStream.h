@@ -0,0 +1,981 @@
+#ifndef __AMR_2_UGRID_STREAM_H
+#define __AMR_2_UGRID_STREAM_H
+
+#include "Vec.h"
+#include "AmrCellSize.h"
+#include "PointIds.h"
+#include "MeshInfo.h"
+#include "AmrLevels.h"
+#include "AmrTree.h"
+#include "AmrHyperCubeTree.h"
+#include "AmrConnect.h"
+#include "AmrUGrid.h"
+#include "Amr2UGrid.h"
+#include "MeshFile.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <bitset>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <climits>
+#include <utility>
+
+namespace Amr2Ugrid
+{
+
+	using namespace hct;
+
+	/*
+	 * Out of core version of the whole conversion, for meshes larger than memory.
+	 * Produces the same files as Amr2UGrid with dumpFiles (.con .geom .scal .bnd .cc .cs .lvl .dpt .m2t .tree .nbh .ugrid),
+	 * except the AmrSidePoints dumps.
+	 *
+	 * - linear passes read the mapped .bin file and write mapped outputs, memoryBudget bytes worth of cells at a time.
+	 * - mesh cells are bucketed by their ancestor at a bucket level, the coarsest level such that the largest bucket
+	 *   fits in memoryBudget. Buckets are written to a spill file.
+	 * - the tree above the bucket level stays in memory. Subtrees below bucket level cells are built one bucket at a time,
+	 *   and their cells are numbered bucket after bucket, so that each subtree is a contiguous range of each level.
+	 * - cells are renumbered in the in-memory conversion's order (see AmrHyperCubeTree::insertKeys with meshOrder),
+	 *   so that all output files are identical to the in-memory ones : point ids and cell order depend on cell numbering.
+	 * - the FullCubes connectivity is computed one subtree at a time, on the streamed numbering.
+	 * - point ids (pointPass) and cells (cellPass) are computed level by level, chunk by chunk, with the OnDemand
+	 *   neighborhood of each tree cell. Neighbor subtrees are read from the mapped .tree file.
+	 * - the .ugrid file is written piecewise from the cell records and point positions spilled by these passes.
+	 *
+	 * Tree cell data (tree nodes, renumbering, parents, point ids) lives in mapped files, not in memory.
+	 * The resident memory is one chunk of cells, the tree above bucket level, one bucket, the refined cells of a level
+	 * being renumbered (8 bytes each), and the used points bitmap of the .ugrid writer (2 bits per point).
+	 */
+	template<unsigned int _D = 3>
+	struct Amr2UGridStream
+	{
+		enum { D = _D };
+		using Vec3 = hct::Vec<float,D>;
+		using CellSize = hct::AmrCellSize<float,D>;
+		using Levels = Amr2Ugrid::AmrLevels<float,D>;
+		using Connect = Amr2Ugrid::AmrConnect<D>;
+		using Cube = typename Connect::Cube;
+		using Mesh = MeshConnectivity<D>;
+		using Geometry = MeshGeometry<float,D>;
+		using CellPointIds = hct::PointIds<D>;
+		using MappedFile = hctreader::MappedFile;
+		using UGrid = Amr2Ugrid::AmrUGrid<D>;
+		using Coord = typename UGrid::Coord;
+
+		// estimated memory per mesh cell of a bucket : subtree construction and connectivity cubes
+		static constexpr size_t BucketBytesPerCell = 64 + 2*sizeof(Cube);
+		// estimated memory per mesh cell in linear passes
+		static constexpr size_t PassBytesPerCell = 128;
+		// bucket levels with more cells than this are not considered
+		static constexpr uint64_t MaxBuckets = uint64_t(1) << 22;
+
+		struct BucketRecord
+		{
+			uint64_t key;
+			int cell;
+			int depth;
+		};
+
+		inline Amr2UGridStream(const std::string& baseName, size_t memoryBudget, typename Connect::Layout nbhLayout = Connect::OnDemand)
+			: m_baseName(baseName), m_memoryBudget(memoryBudget), m_nbhLayout(nbhLayout) {}
+
+		template <typename StreamT>
+		inline bool run(StreamT& log)
+		{
+			std::string binFileName = m_baseName + ".bin";
+			log<<"<- "<<binFileName<<"\n";
+			m_timings.start();
+			if( ! m_file.open(binFileName.c_str()) ) return fail(log, m_file.error());
+			m_nCells = m_file.nCells();
+			if( m_nCells <= 0 ) return fail(log, "empty mesh");
+			m_chunkCells = std::max<size_t>( hctreader::MeshFile::ChunkSize, (m_memoryBudget / PassBytesPerCell) / hctreader::MeshFile::ChunkSize * hctreader::MeshFile::ChunkSize );
+			m_timings.stop("open");
+
+			m_timings.start(); if( ! meshPass(log) ) return false; m_timings.stop("MeshInfo");
+			m_timings.start(); if( ! levelPass(log) ) return false; m_timings.stop("AmrLevels");
+			m_timings.start(); if( ! bucketPass(log) ) return false; m_timings.stop("buckets");
+			m_timings.start(); if( ! treePass(log) ) return false; m_timings.stop("AmrTree");
+			m_timings.start(); if( ! renumberPass(log) ) return false; m_timings.stop("renumber");
+			m_timings.start(); if( ! connectPass(log) ) return false; m_timings.stop("AmrConnect");
+			m_timings.start(); if( ! pointPass(log) ) return false; m_timings.stop("AmrSidePoints");
+			m_timings.start(); if( ! cellPass(log) ) return false; m_timings.stop("AmrUGrid");
+			m_timings.start(); if( ! writeUGrid(log) ) return false; m_timings.stop("writeUGrid");
+
+			m_connect.reset();
+			m_file.close();
+			m_cc.close();
+			m_cs.close();
+			m_dpt.close();
+			m_m2t.close();
+			m_treeFile.close();
+			m_parentFile.close();
+			m_pointIdFile.close();
+			for(const char* ext : { ".key", ".bkt", ".par", ".pid", ".ncl", ".plt", ".rec", ".csc" })
+			{
+				std::remove( tmpFileName(ext).c_str() );
+			}
+			return true;
+		}
+
+		// ---------------------------- passes ----------------------------
+
+		// cell vertices ordering, centers, sizes and bounds, chunk by chunk. Cell size buckets.
+		template <typename StreamT>
+		inline bool meshPass(StreamT& log)
+		{
+			size_t n = m_nCells;
+			int np = m_file.nPoints();
+			MappedFile con, geom, scal;
+			if( ! createOutput(con, ".con", sizeof(int) + n*sizeof(CellPointIds) + n*sizeof(bool), log) ) return false;
+			if( ! createOutput(geom, ".geom", sizeof(int) + np*sizeof(Vec3), log) ) return false;
+			if( ! createOutput(scal, ".scal", sizeof(int) + n*sizeof(float), log) ) return false;
+			if( ! createOutput(m_cc, ".cc", sizeof(int) + n*sizeof(Vec3), log) ) return false;
+			if( ! createOutput(m_cs, ".cs", sizeof(int) + n*sizeof(CellSize), log) ) return false;
+
+			writeInt( con, m_nCells );
+			writeInt( geom, np );
+			std::memcpy( geom.data() + sizeof(int), m_file.points(), np*sizeof(Vec3) );
+			writeInt( scal, m_nCells );
+			std::memcpy( scal.data() + sizeof(int), m_file.scalars(), n*sizeof(float) );
+			writeInt( m_cc, m_nCells );
+			writeInt( m_cs, m_nCells );
+
+			Vec3* centers = reinterpret_cast<Vec3*>( m_cc.data() + sizeof(int) );
+			CellSize* sizes = reinterpret_cast<CellSize*>( m_cs.data() + sizeof(int) );
+			char* conIds = con.data() + sizeof(int);
+			char* conEnabled = conIds + n*sizeof(CellPointIds);
+
+			std::vector<CellPointIds> indices( m_chunkCells );
+			for(size_t first=0; first<n; first+=m_chunkCells)
+			{
+				size_t count = std::min( m_chunkCells, n-first );
+				if( ! m_file.readCells(first, count, indices.data()) ) return fail(log, m_file.error());
+				Mesh mesh;
+				mesh.nCells = count;
+				Vec3 bmin, bmax;
+				Geometry::computeCellInfo( m_file.points(), mesh, indices.data(), centers+first, sizes+first, bmin, bmax );
+				std::memcpy( conIds + first*sizeof(CellPointIds), mesh.pointIds, count*sizeof(CellPointIds) );
+				std::memcpy( conEnabled + first*sizeof(bool), mesh.enabled, count*sizeof(bool) );
+				if( first == 0 ) { m_bmin = bmin; m_bmax = bmax; }
+				else { m_bmin = m_bmin.min(bmin); m_bmax = m_bmax.max(bmax); }
+				m_levels.addCellSizes( first, count, sizes+first );
+			}
+
+			std::ofstream fic;
+			openOutput(fic, ".bnd", log);
+			fic.write( (char*)&m_bmin, sizeof(Vec3) );
+			fic.write( (char*)&m_bmax, sizeof(Vec3) );
+			return true;
+		}
+
+		// levels, cell depths, cell path keys and number of cells per tree cell of each possible bucket level
+		template <typename StreamT>
+		inline bool levelPass(StreamT& log)
+		{
+			size_t n = m_nCells;
+			CellSize domainSize = m_bmax - m_bmin;
+			m_levels.addCellSizes( m_nCells, 1, &domainSize );
+			m_levels.fromSizeBuckets();
+
+			// cell depths from their size bucket, chunk by chunk, same results as AmrLevels::fromCellSizes
+			if( ! createOutput(m_dpt, ".dpt", sizeof(int) + n*sizeof(int), log) ) return false;
+			writeInt( m_dpt, m_nCells );
+			int* depth = reinterpret_cast<int*>( m_dpt.data() + sizeof(int) );
+			const CellSize* sizes = reinterpret_cast<const CellSize*>( m_cs.data() + sizeof(int) );
+			int nMismatch = 0;
+			for(size_t first=0; first<n; first+=m_chunkCells)
+			{
+				size_t count = std::min( m_chunkCells, n-first );
+				nMismatch += m_levels.cellDepths( count, sizes+first, depth+first );
+			}
+			if( nMismatch > 0 )
+			{
+				m_levels.fromCellSizesMap( m_nCells, sizes, domainSize, depth );
+			}
+
+			std::ofstream fic;
+			openOutput(fic, ".lvl", log);
+			m_levels.toBinaryStream(fic);
+			fic.close();
+
+			m_nLevels = m_levels.nLevels;
+			m_keyTree.initLevels( m_nLevels, m_levels.levelInfo );
+			if( ! m_keyTree.pathKeyStrides(m_keyStride) ) return fail(log, "tree paths do not fit in 64 bits, use the in-memory conversion");
+
+			if( ! m_keys.create( tmpFileName(".key").c_str(), n*sizeof(uint64_t) ) ) return fail(log, m_keys.error());
+			uint64_t* keys = reinterpret_cast<uint64_t*>( m_keys.data() );
+			const Vec3* centers = reinterpret_cast<const Vec3*>( m_cc.data() + sizeof(int) );
+
+			// number of cells going through each cell of candidate bucket levels
+			m_bucketCounts.clear();
+			for(int l=0;l<m_nLevels;l++)
+			{
+				uint64_t nBuckets = m_keyStride[0] / m_keyStride[l];
+				if( nBuckets > MaxBuckets ) break;
+				m_bucketCounts.push_back( std::vector<uint64_t>(nBuckets,0) );
+			}
+
+			for(size_t first=0; first<n; first+=m_chunkCells)
+			{
+				size_t end = std::min( first+m_chunkCells, n );
+				long b = first, e = end;
+#				pragma omp parallel for
+				for(long i=b;i<e;i++)
+				{
+					keys[i] = m_keyTree.pathKey( centers[i], depth[i], m_bmin, m_levels.levelSize, m_keyStride.data() );
+				}
+				for(size_t l=0;l<m_bucketCounts.size();l++)
+				{
+					std::vector<uint64_t>& counts = m_bucketCounts[l];
+					for(size_t i=first;i<end;i++)
+					{
+						if( depth[i] >= int(l) ) counts[ keys[i] / m_keyStride[l] ]++;
+					}
+				}
+			}
+			return true;
+		}
+
+		// bucket level choice, tree above bucket level, cells sorted by bucket in the spill file
+		template <typename StreamT>
+		inline bool bucketPass(StreamT& log)
+		{
+			size_t n = m_nCells;
+			size_t maxBucketCells = std::max<size_t>( 1, m_memoryBudget / BucketBytesPerCell );
+			m_bucketLevel = m_bucketCounts.size()-1;
+			uint64_t largest = 0;
+			for(size_t l=0;l<m_bucketCounts.size();l++)
+			{
+				largest = *std::max_element( m_bucketCounts[l].begin(), m_bucketCounts[l].end() );
+				if( largest <= maxBucketCells ) { m_bucketLevel = l; break; }
+			}
+			log<<"bucket level "<<m_bucketLevel<<", largest bucket has "<<largest<<" cells";
+			if( largest > maxBucketCells ) log<<" (exceeds memory budget)";
+			log<<"\n";
+
+			const int L = m_bucketLevel;
+			const std::vector<uint64_t>& counts = m_bucketCounts[L];
+			const int* depth = reinterpret_cast<const int*>( m_dpt.data() + sizeof(int) );
+			const uint64_t* keys = reinterpret_cast<const uint64_t*>( m_keys.data() );
+
+			// tree above bucket level : paths to non empty buckets, and cells above bucket level
+			std::vector<uint64_t> topKeys;
+			std::vector<int> topDepth, topCell;
+			m_buckets.clear();
+			for(size_t b=0;b<counts.size();b++)
+			{
+				if( counts[b] == 0 ) continue;
+				m_buckets.push_back(b);
+				topKeys.push_back(b);
+				topDepth.push_back(L);
+				topCell.push_back(-1);
+			}
+			for(size_t i=0;i<n;i++)
+			{
+				if( depth[i] >= L ) continue;
+				topKeys.push_back( keys[i] / m_keyStride[L] );
+				topDepth.push_back( depth[i] );
+				topCell.push_back( i );
+			}
+			m_topTree.initLevels( L+1, m_levels.levelInfo );
+			std::vector<uint64_t> topStride;
+			m_topTree.pathKeyStrides(topStride);
+			std::vector<int> topNode( topKeys.size() );
+			m_topTree.insertKeys( topKeys.size(), topKeys.data(), topDepth.data(), topCell.data(), topStride.data(), topNode.data(), false );
+
+			if( ! createOutput(m_m2t, ".m2t", sizeof(int) + n*sizeof(int), log) ) return false;
+			writeInt( m_m2t, m_nCells );
+			int* m2t = reinterpret_cast<int*>( m_m2t.data() + sizeof(int) );
+			m_bucketNode.assign( topNode.begin(), topNode.begin()+m_buckets.size() );
+			for(size_t i=m_buckets.size();i<topKeys.size();i++)
+			{
+				m2t[ topCell[i] ] = topNode[i];
+			}
+
+			// spill file, cells sorted by bucket
+			m_bucketOffset.assign( m_buckets.size()+1, 0 );
+			for(size_t k=0;k<m_buckets.size();k++) m_bucketOffset[k+1] = m_bucketOffset[k] + counts[ m_buckets[k] ];
+			std::vector<uint64_t> cursor( counts.size(), 0 );
+			for(size_t k=0;k<m_buckets.size();k++) cursor[ m_buckets[k] ] = m_bucketOffset[k];
+			if( ! m_spill.create( tmpFileName(".bkt").c_str(), m_bucketOffset.back()*sizeof(BucketRecord) ) ) return fail(log, m_spill.error());
+			BucketRecord* records = reinterpret_cast<BucketRecord*>( m_spill.data() );
+			for(size_t i=0;i<n;i++)
+			{
+				if( depth[i] < L ) continue;
+				records[ cursor[ keys[i] / m_keyStride[L] ]++ ] = BucketRecord{ keys[i] % m_keyStride[L], int(i), depth[i] - L };
+			}
+			m_keys.close();
+			m_bucketCounts.clear();
+			return true;
+		}
+
+		// subtrees, one bucket at a time, .m2t and .tree
+		template <typename StreamT>
+		inline bool treePass(StreamT& log)
+		{
+			const int L = m_bucketLevel;
+			const int nSubLevels = m_nLevels - L;
+			int* m2t = reinterpret_cast<int*>( m_m2t.data() + sizeof(int) );
+			const BucketRecord* records = reinterpret_cast<const BucketRecord*>( m_spill.data() );
+
+			// levels below bucket level are appended bucket after bucket to temporary files
+			std::vector<std::ofstream> levelFiles( nSubLevels );
+			for(int s=1;s<nSubLevels;s++)
+			{
+				levelFiles[s].open( tmpFileName(".level"+std::to_string(L+s)).c_str(), std::ios::binary );
+			}
+			m_levelSize.assign( m_nLevels, 0 );
+			m_subtreeFirst.assign( m_buckets.size()*nSubLevels, 0 );
+			m_subtreeSize.assign( m_buckets.size()*nSubLevels, 0 );
+			size_t nBucketNodes = m_topTree.tree->getLevelSize(L);
+			std::vector<TreeNode> bucketNodes( nBucketNodes, TreeNode{-1,0} );
+
+			std::vector<uint64_t> keys;
+			std::vector<int> depth, cells, node;
+			std::vector<TreeNode> nodes;
+			for(size_t k=0;k<m_buckets.size();k++)
+			{
+				size_t first = m_bucketOffset[k], count = m_bucketOffset[k+1] - first;
+				keys.resize(count); depth.resize(count); cells.resize(count); node.resize(count);
+				for(size_t i=0;i<count;i++)
+				{
+					keys[i] = records[first+i].key;
+					depth[i] = records[first+i].depth;
+					cells[i] = records[first+i].cell;
+				}
+				AmrHyperCubeTree<D> sub;
+				sub.initLevels( nSubLevels, m_levels.levelInfo + L );
+				sub.insertKeys( count, keys.data(), depth.data(), cells.data(), m_keyStride.data() + L, node.data(), false );
+
+				for(size_t i=0;i<count;i++)
+				{
+					m2t[ cells[i] ] = ( depth[i] == 0 ) ? m_bucketNode[k] : ( m_levelSize[L+depth[i]] + node[i] );
+				}
+				Cell root = sub.tree->rootCell();
+				TreeNode& bucketNode = bucketNodes[ m_bucketNode[k] ];
+				bucketNode.index = sub.tree->isLeaf(root) ? -1 : int( m_levelSize[L+1] + sub.tree->child(root,0).index() );
+				bucketNode.nCells = sub.meshCellCount[root];
+				for(int s=1;s<nSubLevels;s++)
+				{
+					size_t size = sub.tree->getLevelSize(s);
+					nodes.resize(size);
+					for(size_t j=0;j<size;j++)
+					{
+						Cell cell(s,j);
+						nodes[j].index = sub.tree->isLeaf(cell) ? -1 : int( m_levelSize[L+s+1] + sub.tree->child(cell,0).index() );
+						nodes[j].nCells = sub.meshCellCount[cell];
+					}
+					levelFiles[s].write( (char*)nodes.data(), size*sizeof(TreeNode) );
+					m_subtreeFirst[k*nSubLevels+s] = m_levelSize[L+s];
+					m_subtreeSize[k*nSubLevels+s] = size;
+					m_levelSize[L+s] += size;
+				}
+			}
+			for(int s=1;s<nSubLevels;s++) levelFiles[s].close();
+			m_spill.close();
+
+			// tree in the streamed numbering : levels above bucket level from the top tree, then subtree levels
+			for(int l=0;l<=L;l++) m_levelSize[l] = m_topTree.tree->getLevelSize(l);
+			m_totalSize = 0;
+			for(int l=0;l<m_nLevels;l++) m_totalSize += m_levelSize[l];
+			if( ! m_streamTree.create( tmpFileName(".stree").c_str(), sizeof(int)*(1+m_nLevels) + m_totalSize*sizeof(TreeNode) ) ) return fail(log, m_streamTree.error());
+			int* header = reinterpret_cast<int*>( m_streamTree.data() );
+			header[0] = m_nLevels;
+			for(int l=0;l<m_nLevels;l++) header[1+l] = m_levelSize[l];
+			TreeNode* ptr = reinterpret_cast<TreeNode*>( header + 1 + m_nLevels );
+			for(int l=0;l<=L;l++)
+			{
+				for(size_t j=0;j<m_levelSize[l];j++)
+				{
+					Cell cell(l,j);
+					if( l == L ) ptr[j] = bucketNodes[j];
+					else ptr[j] = TreeNode{ m_topTree.tree->isLeaf(cell) ? -1 : int(m_topTree.tree->child(cell,0).index()), m_topTree.meshCellCount[cell] };
+				}
+				ptr += m_levelSize[l];
+			}
+			for(int s=1;s<nSubLevels;s++)
+			{
+				std::string levelFileName = tmpFileName(".level"+std::to_string(L+s));
+				std::ifstream in( levelFileName.c_str(), std::ios::binary );
+				in.read( (char*)ptr, m_levelSize[L+s]*sizeof(TreeNode) );
+				in.close();
+				std::remove( levelFileName.c_str() );
+				ptr += m_levelSize[L+s];
+			}
+			return true;
+		}
+
+		/*
+		 * Renumbering of tree cells, .tree and .m2t, in the order of the in-memory conversion :
+		 * refined cells of a level are sorted by the first mesh cell (lowest index) below them,
+		 * and get their children blocks in that order. The .tree file is written from the streamed tree.
+		 */
+		template <typename StreamT>
+		inline bool renumberPass(StreamT& log)
+		{
+			size_t n = m_nCells;
+			const int* depth = reinterpret_cast<const int*>( m_dpt.data() + sizeof(int) );
+			int* m2t = reinterpret_cast<int*>( m_m2t.data() + sizeof(int) );
+			std::vector<TreeNode*> nodes = levelArrays( treeNodes(m_streamTree) );
+
+			// first mesh cell at or below each tree cell
+			if( ! m_newIndexFile.create( tmpFileName(".idx").c_str(), m_totalSize*sizeof(int) ) ) return fail(log, m_newIndexFile.error());
+			std::vector<int*>& index = m_newIndex;
+			index = levelArrays( reinterpret_cast<int*>( m_newIndexFile.data() ) );
+			std::fill( index[0], index[0]+m_totalSize, INT_MAX );
+			for(size_t i=0;i<n;i++)
+			{
+				int& first = index[ depth[i] ][ m2t[i] ];
+				first = std::min( first, int(i) );
+			}
+			for(int l=m_nLevels-2;l>=0;l--)
+			{
+				int g = m_levels.levelInfo[l].grid.gridSize();
+				for(size_t j=0;j<m_levelSize[l];j++)
+				{
+					int c = nodes[l][j].index;
+					if( c == -1 ) continue;
+					for(int b=0;b<g;b++) index[l][j] = std::min( index[l][j], index[l+1][c+b] );
+				}
+			}
+
+			// top down, first mesh cells below level l are replaced by new indices once level l is sorted
+			MappedFile sortFile; // first mesh cell below level l, cell
+			size_t maxLevelSize = *std::max_element( m_levelSize.begin(), m_levelSize.end() );
+			if( ! sortFile.create( tmpFileName(".srt").c_str(), maxLevelSize*sizeof(std::pair<int,int>) ) ) return fail(log, sortFile.error());
+			std::pair<int,int>* refined = reinterpret_cast< std::pair<int,int>* >( sortFile.data() );
+			index[0][0] = 0;
+			for(int l=0;l<(m_nLevels-1);l++)
+			{
+				int g = m_levels.levelInfo[l].grid.gridSize();
+				size_t nRefined = 0;
+				for(size_t j=0;j<m_levelSize[l];j++)
+				{
+					int c = nodes[l][j].index;
+					if( c == -1 ) continue;
+					int first = INT_MAX;
+					for(int b=0;b<g;b++) first = std::min( first, index[l+1][c+b] );
+					refined[nRefined++] = std::make_pair(first,int(j));
+				}
+				std::sort( refined, refined+nRefined );
+				for(size_t r=0;r<nRefined;r++)
+				{
+					int c = nodes[l][ refined[r].second ].index;
+					for(int b=0;b<g;b++) index[l+1][c+b] = r*g + b;
+				}
+			}
+			sortFile.close();
+			std::remove( tmpFileName(".srt").c_str() );
+
+			// cell j of level l moves to index[l][j], child indices follow
+			if( ! createOutput(m_treeFile, ".tree", m_streamTree.size(), log) ) return false;
+			std::memcpy( m_treeFile.data(), m_streamTree.data(), sizeof(int)*(1+m_nLevels) );
+			std::vector<TreeNode*> newNodes = levelArrays( treeNodes(m_treeFile) );
+			for(int l=0;l<m_nLevels;l++)
+			{
+				for(size_t j=0;j<m_levelSize[l];j++)
+				{
+					TreeNode node = nodes[l][j];
+					if( node.index != -1 ) node.index = index[l+1][node.index];
+					newNodes[l][ index[l][j] ] = node;
+				}
+			}
+			for(size_t i=0;i<n;i++) m2t[i] = index[ depth[i] ][ m2t[i] ];
+
+			// FullCubes connectivity is computed on the streamed numbering (subtree windows)
+			if( m_nbhLayout == Connect::OnDemand ) releaseStreamTree();
+			return true;
+		}
+
+		// connectivity. The OnDemand layout only needs the parent of each tree cell, written from the mapped .tree.
+		// FullCubes : levels above bucket level first, then one subtree at a time.
+		template <typename StreamT>
+		inline bool connectPass(StreamT& log)
+		{
+			const int L = m_bucketLevel;
+			const int nSubLevels = m_nLevels - L;
+			MappedFile nbh;
+
+			if( m_nbhLayout == Connect::OnDemand )
+			{
+				AmrTree tree;
+				tree.fromBuffer( m_treeFile.data() );
+				if( ! createOutput(nbh, ".nbh", sizeof(int)*(1+m_nLevels) + m_totalSize*sizeof(int), log) ) return false;
+				int* header = reinterpret_cast<int*>( nbh.data() );
+				header[0] = -m_nLevels;
+				for(int l=0;l<m_nLevels;l++) header[1+l] = m_levelSize[l];
+				std::vector<int*> parents = levelArrays( header + 1 + m_nLevels );
+				Connect connect( tree, m_levels.levelInfo, parents.data() );
+				connect.connectParents();
+				return true;
+			}
+
+			std::vector<size_t> levelOffset( m_nLevels );
+			size_t offset = sizeof(int)*(1+m_nLevels);
+			for(int l=0;l<m_nLevels;l++)
+			{
+				levelOffset[l] = offset;
+				offset += m_levelSize[l]*sizeof(Cube);
+			}
+			if( ! createOutput(nbh, ".nbh", offset, log) ) return false;
+			int* header = reinterpret_cast<int*>( nbh.data() );
+			header[0] = m_nLevels;
+			for(int l=0;l<m_nLevels;l++) header[1+l] = m_levelSize[l];
+
+			AmrTree skeleton;
+			skeleton.fromBuffer( m_streamTree.data() );
+			Connect connect( skeleton, m_levels.levelInfo, L );
+			connect.connectTree();
+			connect.connectLevels = m_nLevels;
+			for(size_t k=0;k<m_buckets.size();k++)
+			{
+				for(int s=1;s<nSubLevels;s++)
+				{
+					connect.setWindow( L+s, m_subtreeFirst[k*nSubLevels+s], m_subtreeSize[k*nSubLevels+s] );
+				}
+				connect.connectTree( L, m_bucketNode[k] );
+				for(int s=1;s<nSubLevels;s++)
+				{
+					writeCubes( nbh.data() + levelOffset[L+s], L+s, m_subtreeFirst[k*nSubLevels+s], m_subtreeSize[k*nSubLevels+s], connect.cubes[L+s] );
+				}
+			}
+			for(int l=0;l<=L;l++)
+			{
+				writeCubes( nbh.data() + levelOffset[l], l, 0, m_levelSize[l], connect.cubes[l] );
+			}
+			releaseStreamTree();
+			return true;
+		}
+
+		/*
+		 * Unified point ids, same as AmrSidePoints::unifyPoints : the id of a point is given by its first occurrence
+		 * in level, cell, corner order. A corner of a cell is either a corner of its parent, or shared only with
+		 * same level neighbors, the lowest numbered one owning it. Cells are processed level by level, chunk by chunk :
+		 * sharing is found in parallel, owned points are numbered in order, then ids are copied from owners.
+		 * Lattice positions of points are appended in id order to a temporary file.
+		 */
+		template <typename StreamT>
+		inline bool pointPass(StreamT& log)
+		{
+			m_tree.fromBuffer( m_treeFile.data() );
+			if( ! m_parentFile.create( tmpFileName(".par").c_str(), m_totalSize*sizeof(int) ) ) return fail(log, m_parentFile.error());
+			if( ! m_pointIdFile.create( tmpFileName(".pid").c_str(), m_totalSize*sizeof(CellPointIds) ) ) return fail(log, m_pointIdFile.error());
+			m_parents = levelArrays( reinterpret_cast<int*>( m_parentFile.data() ) );
+			m_pointIds = levelArrays( reinterpret_cast<CellPointIds*>( m_pointIdFile.data() ) );
+			m_connect.reset( new Connect( m_tree, m_levels.levelInfo, m_parents.data() ) );
+			m_connect->connectParents();
+			m_ugrid.initCells( m_tree, m_levels.levelInfo, *m_connect, m_pointIds.data() );
+
+			std::ofstream lattice( tmpFileName(".plt").c_str(), std::ios::binary );
+			std::vector<CellPointIds> source;
+			std::vector<int> firstId;
+			std::vector<Coord> position, points;
+			m_nPointIds = 0;
+			for(int l=0;l<m_nLevels;l++)
+			{
+				long size = m_levelSize[l];
+				for(long first=0; first<size; first+=m_chunkCells)
+				{
+					long count = std::min<long>( m_chunkCells, size-first );
+					source.resize(count);
+					firstId.resize(count);
+					position.resize(count);
+#					pragma omp parallel for schedule(static)
+					for(long j=0;j<count;j++)
+					{
+						position[j] = nodePosition( l, first+j );
+						cornerSources( l, first+j, source[j] );
+					}
+					points.clear();
+					for(long j=0;j<count;j++)
+					{
+						firstId[j] = m_nPointIds;
+						for(int k=0;k<CellPointIds::Size;k++)
+						{
+							if( source[j][k] != Owner ) continue;
+							points.push_back( m_ugrid.corner( position[j], l, k ) );
+							m_nPointIds++;
+						}
+					}
+					lattice.write( (char*)points.data(), points.size()*sizeof(Coord) );
+#					pragma omp parallel for schedule(static)
+					for(long j=0;j<count;j++)
+					{
+						CellPointIds& ids = m_pointIds[l][first+j];
+						int owned = 0;
+						for(int k=0;k<CellPointIds::Size;k++)
+						{
+							int s = source[j][k];
+							if( s == Owner ) ids[k] = firstId[j] + owned++;
+							else if( s < Owner ) ids[k] = m_pointIds[l-1][ m_parents[l][first+j] ][ Owner-1-s ];
+							else
+							{
+								long m = s / CellPointIds::Size;
+								int c = s % CellPointIds::Size;
+								ids[k] = ( m < first ) ? m_pointIds[l][m][c] : firstId[m-first] + ownedBefore( source[m-first], c );
+							}
+						}
+					}
+				}
+			}
+			return true;
+		}
+
+		// cell records with unified point ids, and cell scalars, appended to temporary files. Marks used points.
+		template <typename StreamT>
+		inline bool cellPass(StreamT& log)
+		{
+			// first mesh cell of each tree cell
+			size_t n = m_nCells;
+			if( ! m_nodeCellFile.create( tmpFileName(".ncl").c_str(), m_totalSize*sizeof(int) ) ) return fail(log, m_nodeCellFile.error());
+			std::vector<int*> nodeCell = levelArrays( reinterpret_cast<int*>( m_nodeCellFile.data() ) );
+			std::fill( nodeCell[0], nodeCell[0]+m_totalSize, -1 );
+			const int* depth = reinterpret_cast<const int*>( m_dpt.data() + sizeof(int) );
+			const int* m2t = reinterpret_cast<const int*>( m_m2t.data() + sizeof(int) );
+			for(size_t i=0;i<n;i++)
+			{
+				int& cell = nodeCell[ depth[i] ][ m2t[i] ];
+				if( cell == -1 ) cell = i;
+			}
+
+			std::ofstream records( tmpFileName(".rec").c_str(), std::ios::binary );
+			std::ofstream cellScalars( tmpFileName(".csc").c_str(), std::ios::binary );
+			const float* scalars = m_file.scalars();
+			m_usedPoints.assign( m_nPointIds/64 + 1, 0 );
+			m_nUGridCells = m_nHexahedra = m_nPolyhedra = 0;
+			int maxThreads = 1;
+#			ifdef _OPENMP
+			maxThreads = omp_get_max_threads();
+#			endif
+			std::vector< std::vector<int> > threadRecords( maxThreads );
+			std::vector< std::vector<int> > threadCells( maxThreads ); // node, then record start, of each cell
+			std::vector<float> values;
+			for(int l=0;l<m_nLevels;l++)
+			{
+				long size = m_levelSize[l];
+				for(long first=0; first<size; first+=m_chunkCells)
+				{
+					long end = std::min<long>( first+m_chunkCells, size );
+#					pragma omp parallel
+					{
+						int thread = 0;
+#						ifdef _OPENMP
+						thread = omp_get_thread_num();
+#						endif
+						std::vector<int>& rec = threadRecords[thread];
+						std::vector<int>& cells = threadCells[thread];
+						rec.clear();
+						cells.clear();
+						typename UGrid::Scratch tmp;
+						// static schedule : contiguous chunks of cells, in thread order
+#						pragma omp for schedule(static)
+						for(long j=first;j<end;j++)
+						{
+							if( ! m_tree.isLeaf(l,j) || nodeCell[l][j] == -1 ) continue;
+							cells.push_back( j );
+							cells.push_back( rec.size() );
+							m_ugrid.buildCell( l, j, nodePosition(l,j), m_connect->neighborhood(l,j), rec, tmp );
+						}
+					}
+					values.clear();
+					for(int t=0;t<maxThreads;t++)
+					{
+						for(size_t c=0;c<threadCells[t].size();c+=2)
+						{
+							int* rec = threadRecords[t].data() + threadCells[t][c+1];
+							values.push_back( scalars[ nodeCell[l][ threadCells[t][c] ] ] );
+							if( rec[0] == CellPointIds::Size ) m_nHexahedra++;
+							else m_nPolyhedra++;
+							UGrid::forEachRecordPoint( rec, [this](int p) { m_usedPoints[p/64] |= uint64_t(1) << (p%64); } );
+						}
+						records.write( (char*)threadRecords[t].data(), threadRecords[t].size()*sizeof(int) );
+					}
+					cellScalars.write( (char*)values.data(), values.size()*sizeof(float) );
+					m_nUGridCells += values.size();
+				}
+			}
+			m_nodeCellFile.close();
+			return true;
+		}
+
+		/*
+		 * .ugrid file, from the spilled cell records, point positions and scalars.
+		 * Used point ids are renumbered in id order : the index of a point is the number of used ids before it,
+		 * counted per 64 ids word of the used points bitmap.
+		 */
+		template <typename StreamT>
+		inline bool writeUGrid(StreamT& log)
+		{
+			std::vector<int> usedBefore( m_usedPoints.size()+1, 0 );
+			for(size_t w=0;w<m_usedPoints.size();w++)
+			{
+				usedBefore[w+1] = usedBefore[w] + std::bitset<64>( m_usedPoints[w] ).count();
+			}
+			m_nUGridPoints = usedBefore.back();
+
+			MappedFile records, lattice, cellScalars;
+			if( ! records.open( tmpFileName(".rec").c_str() ) ) return fail(log, records.error());
+			if( ! lattice.open( tmpFileName(".plt").c_str() ) ) return fail(log, lattice.error());
+			if( ! cellScalars.open( tmpFileName(".csc").c_str() ) ) return fail(log, cellScalars.error());
+
+			std::ofstream fic;
+			openOutput(fic, ".ugrid", log);
+			fic.write( (char*)&m_nUGridCells, sizeof(int) );
+			fic.write( (char*)&m_nUGridPoints, sizeof(int) );
+
+			// records, point ids replaced by point indices
+			std::vector<int> buffer;
+			const int* rec = reinterpret_cast<const int*>( records.data() );
+			const int* recEnd = rec + records.size()/sizeof(int);
+			while( rec != recEnd )
+			{
+				size_t start = buffer.size();
+				buffer.insert( buffer.end(), rec, rec + 1 + rec[0] );
+				rec += 1 + rec[0];
+				UGrid::forEachRecordPoint( buffer.data()+start, [this,&usedBefore](int& p)
+					{
+						uint64_t below = m_usedPoints[p/64] & ( ( uint64_t(1) << (p%64) ) - 1 );
+						p = usedBefore[p/64] + std::bitset<64>( below ).count();
+					} );
+				if( buffer.size() >= m_chunkCells || rec == recEnd )
+				{
+					fic.write( (char*)buffer.data(), buffer.size()*sizeof(int) );
+					buffer.clear();
+				}
+			}
+
+			// used points, same positions as AmrUGrid::build
+			const Coord* pointLattice = reinterpret_cast<const Coord*>( lattice.data() );
+			Vec3 step = ( m_bmax - m_bmin ) / Vec3( m_ugrid.latticeResolution() );
+			std::vector<Vec3> points;
+			for(int p=0;p<m_nPointIds;p++)
+			{
+				if( ( m_usedPoints[p/64] >> (p%64) ) & 1 ) points.push_back( m_bmin + Vec3( pointLattice[p] ) * step );
+				if( points.size() >= m_chunkCells || p == m_nPointIds-1 )
+				{
+					fic.write( (char*)points.data(), points.size()*sizeof(Vec3) );
+					points.clear();
+				}
+			}
+
+			fic.write( cellScalars.data(), cellScalars.size() );
+			m_usedPoints.clear();
+			return true;
+		}
+
+		template <typename StreamT>
+		inline void toStream(StreamT& out) const
+		{
+			out<<m_nCells<<" cells\n";
+			out<<"Domain bounds : ("; m_bmin.toStream(out); out<<") - ("; m_bmax.toStream(out); out<<")\n";
+			m_levels.toStream(out);
+			for(int l=0;l<m_nLevels;l++)
+			{
+				out<<l<<" : size="<<m_levelSize[l]<<"\n";
+			}
+			out<<m_buckets.size()<<" buckets at level "<<m_bucketLevel<<"\n";
+			out<<"Nb points unifies : "<<m_nPointIds<<"\n";
+			out<<"Maillage final : "<<m_nUGridCells<<" mailles ("<<m_nHexahedra<<" hexaedres, "<<m_nPolyhedra<<" polyedres), "<<m_nUGridPoints<<" points\n";
+		}
+
+		inline const StageTimings& timings() const { return m_timings; }
+
+		// ---- Data ----
+		std::string m_baseName;
+		size_t m_memoryBudget;
+		typename Connect::Layout m_nbhLayout;
+		size_t m_chunkCells = 0;
+		StageTimings m_timings;
+
+		hctreader::MeshFile m_file;
+		int m_nCells = 0;
+		Vec3 m_bmin, m_bmax;
+		MappedFile m_cc, m_cs, m_dpt, m_m2t, m_keys, m_spill, m_streamTree, m_treeFile;
+
+		Levels m_levels;
+		int m_nLevels = 0;
+		AmrHyperCubeTree<D> m_keyTree; // levels only, for path keys
+		std::vector<uint64_t> m_keyStride;
+
+		std::vector< std::vector<uint64_t> > m_bucketCounts; // per candidate bucket level
+		int m_bucketLevel = 0;
+		AmrHyperCubeTree<D> m_topTree;
+		std::vector<uint64_t> m_buckets; // non empty buckets, by path
+		std::vector<int> m_bucketNode; // bucket tree cell index at bucket level
+		std::vector<uint64_t> m_bucketOffset; // first cell of each bucket in the spill file
+		std::vector<size_t> m_levelSize;
+		size_t m_totalSize = 0; // tree cells
+		std::vector<int> m_subtreeFirst, m_subtreeSize; // per bucket and level below bucket level
+		MappedFile m_newIndexFile;
+		std::vector<int*> m_newIndex; // streamed to in-memory cell numbering, per level
+
+		// point ids and cells, on the mapped .tree
+		AmrTree m_tree;
+		MappedFile m_parentFile, m_pointIdFile, m_nodeCellFile;
+		std::vector<int*> m_parents;
+		std::vector<CellPointIds*> m_pointIds;
+		std::unique_ptr<Connect> m_connect;
+		UGrid m_ugrid; // cell generation only
+		int m_nPointIds = 0;
+		std::vector<uint64_t> m_usedPoints; // bitmap
+		int m_nUGridCells = 0, m_nUGridPoints = 0, m_nHexahedra = 0, m_nPolyhedra = 0;
+
+	private:
+		using Cell = hct::HyperCubeTreeCell;
+		using ElementInfo = typename Connect::ElementInfo;
+
+		struct RenumberElements
+		{
+			const std::vector<int*>& index;
+			template<typename Mask> inline void processComponent( CubeEnum<ElementInfo,0,Mask>& c )
+			{
+				if( c.value.node >= 0 ) c.value.node = index[c.value.level][c.value.node];
+			}
+		};
+
+		// corner source in cornerSources : owned by the cell itself
+		static constexpr int Owner = -1;
+
+		// owner of each corner of a cell met in its neighborhood : same level neighbor m with its corner c (m*8+c), lowest m first
+		struct SharedCorners
+		{
+			struct Corner
+			{
+				int neighbor;
+				size_t def;
+				CellPointIds& source;
+				template<typename Point> inline void operator () ( Point )
+				{
+					int& s = source[Point::BITFIELD];
+					int candidate = neighbor*CellPointIds::Size + ( Point::BITFIELD ^ def );
+					if( s == Owner || candidate < s ) s = candidate;
+				}
+			};
+			int level, node;
+			CellPointIds& source;
+			template<typename M> inline void processComponent( const CubeEnum<ElementInfo,0,M>& c )
+			{
+				using Mask = typename CubeEnum<ElementInfo,0,M>::Mask;
+				if( c.value.node == -1 || c.value.level != level || c.value.node >= node ) return;
+				Mask::enumerate( Corner{ c.value.node, Mask::DEF_BITFIELD, source } );
+			}
+		};
+
+		// for each corner : Owner, m*8+c for corner c of a lower numbered same level cell m, or Owner-1-c for corner c of the parent
+		inline void cornerSources( int level, int node, CellPointIds& source ) const
+		{
+			source = CellPointIds( Owner );
+			SharedCorners shared{ level, node, source };
+			m_connect->neighborhood(level,node).forEachComponent( shared );
+			if( level == 0 ) return;
+			Coord grid = m_levels.levelInfo[level-1].grid;
+			Coord branch = m_connect->branchCoord[level-1][ node - m_tree.nodeLevels[level-1].nodes[ m_parents[level][node] ].index ];
+			for(int k=0;k<CellPointIds::Size;k++)
+			{
+				Coord c = branch + Coord::fromBitfield(k);
+				Coord p = c / grid;
+				if( ! ( p * grid == c ).reduce_and() ) continue;
+				int pk = 0;
+				while( ! ( Coord::fromBitfield(pk) == p ).reduce_and() ) pk++;
+				source[k] = Owner - 1 - pk;
+			}
+		}
+
+		static inline int ownedBefore( const CellPointIds& source, int corner )
+		{
+			int n = 0;
+			for(int k=0;k<corner;k++) if( source[k] == Owner ) n++;
+			return n;
+		}
+
+		// lattice position of a tree cell, in its level's units
+		inline Coord nodePosition( int level, int node ) const
+		{
+			if( level == 0 ) return Coord(0u);
+			int p = m_parents[level][node];
+			int branch = node - m_tree.nodeLevels[level-1].nodes[p].index;
+			return nodePosition( level-1, p ) * m_levels.levelInfo[level-1].grid + m_connect->branchCoord[level-1][branch];
+		}
+
+		// nodes of a mapped tree file
+		inline TreeNode* treeNodes( MappedFile& treeFile ) const
+		{
+			return reinterpret_cast<TreeNode*>( reinterpret_cast<int*>( treeFile.data() ) + 1 + m_nLevels );
+		}
+
+		// per level pointers in an array of all tree cells
+		template<typename T>
+		inline std::vector<T*> levelArrays( T* first ) const
+		{
+			std::vector<T*> levels( m_nLevels );
+			levels[0] = first;
+			for(int l=1;l<m_nLevels;l++) levels[l] = levels[l-1] + m_levelSize[l-1];
+			return levels;
+		}
+
+		inline void releaseStreamTree()
+		{
+			m_streamTree.close();
+			m_newIndexFile.close();
+			m_newIndex.clear();
+			std::remove( tmpFileName(".stree").c_str() );
+			std::remove( tmpFileName(".idx").c_str() );
+		}
+
+		// cubes of streamed cells [first;first+count[ of a level, written at their in-memory index
+		inline void writeCubes( char* levelCubes, int level, size_t first, size_t count, const Cube* cubes ) const
+		{
+			RenumberElements renumber{ m_newIndex };
+			for(size_t j=0;j<count;j++)
+			{
+				Cube cube;
+				std::memcpy( &cube, cubes+j, sizeof(Cube) );
+				cube.forEachComponent( renumber );
+				std::memcpy( levelCubes + m_newIndex[level][first+j]*sizeof(Cube), &cube, sizeof(Cube) );
+			}
+		}
+
+		inline std::string tmpFileName(const std::string& ext) const
+		{
+			return m_baseName + ".tmp" + ext;
+		}
+
+		template <typename StreamT>
+		inline bool fail(StreamT& log, const std::string& message)
+		{
+			log<<"Erreur : "<<message<<"\n";
+			return false;
+		}
+
+		template <typename StreamT>
+		inline bool createOutput(MappedFile& file, const char* ext, size_t size, StreamT& log)
+		{
+			std::string fileName = m_baseName + ext;
+			log<<"-> "<<fileName<<"\n";
+			if( ! file.create(fileName.c_str(), size) ) return fail(log, file.error());
+			return true;
+		}
+
+		template <typename StreamT>
+		inline void openOutput(std::ofstream& fic, const char* ext, StreamT& log) const
+		{
+			std::string fileName = m_baseName + ext;
+			log<<"-> "<<fileName<<"\n";
+			fic.open(fileName.c_str(), std::ios::binary);
+		}
+
+		static inline void writeInt(MappedFile& file, int n)
+		{
+			std::memcpy( file.data(), &n, sizeof(int) );
+		}
+	};
+
+}; // Amr2Ugrid
+
+#endif
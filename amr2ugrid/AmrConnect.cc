@@ -11,10 +11,16 @@ int main(int argc, char* argv[])
   // verification du nombre minimal d'arguments
   if( argc<2 )
     {
-      cerr<<"Utilisation: "<<argv[0]<<" nom_du_test"<<endl;
+      cerr<<"Utilisation: "<<argv[0]<<" nom_du_test [-full]"<<endl;
       return 1;
     }
   string baseName = argv[1];
+  // -full : ancien format .nbh, un cube de voisinage complet par noeud
+  AmrConnect<3>::Layout layout = AmrConnect<3>::OnDemand;
+  for(int i=2;i<argc;i++)
+    {
+      if( string(argv[i]) == "-full" ) layout = AmrConnect<3>::FullCubes;
+    }
   string levelFileName = baseName+".lvl";
   string treeFileName = baseName+".tree";
   string nbhFileName = baseName+".nbh";
@@ -43,7 +49,7 @@ int main(int argc, char* argv[])
   fic_tree.close();
   tree.toStream(cout); cout<<endl;
 
-  AmrConnect<3> amrConnect(tree,levels.levelInfo);
+  AmrConnect<3> amrConnect(tree,levels.levelInfo,layout);
   amrConnect.connectTree();
   amrConnect.toStream(cout);
 
@@ -9,6 +9,10 @@
 #include "GridEnum.h"
 #include "GridDimension.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace Amr2Ugrid
 {
 
@@ -41,40 +45,93 @@ namespace Amr2Ugrid
       int _x;
     };
 
-    inline AmrConnect( const AmrTree& t, const LevelInfo<D>* l )
-      : tree(t), levelInfo(l)
-    {
-      CubeInitialize cubeInitialize;
+    /*
+     * FullCubes : one Cube per tree node, computed by connectTree() (legacy .nbh layout, 3^D ElementInfo per node).
+     * OnDemand : only the parent of each node is stored, neighborhood() computes a node's Cube from its ancestors',
+     * keeping the last computed Cube of each level. Nodes visited level by level, in index order,
+     * cost one dig each, like connectTree(), for 4 bytes per node instead of sizeof(Cube).
+     */
+    enum Layout { FullCubes, OnDemand };
 
-      cubes = new Cube*[ tree.nLevels ];
-      for(int i=0;i<tree.nLevels;i++)
+    inline AmrConnect( const AmrTree& t, const LevelInfo<D>* l, Layout lay = FullCubes )
+      : tree(t), levelInfo(l), connectLevels(t.nLevels), layout(lay)
+    {
+      allocate();
+      if( layout == FullCubes )
 	{
-	  int ncubes = tree.nodeLevels[i].size;
-	  cubes[i] = new Cube[ ncubes ];
-	  for(int j=0;j<ncubes;j++)
+	  for(int i=0;i<tree.nLevels;i++)
 	    {
-	      cubes[i][j].forEachComponent( cubeInitialize );
-	      cubes[i][j].self().level = i;
-	      cubes[i][j].self().node = j;
+	      setWindow( i, 0, tree.nodeLevels[i].size );
 	    }
 	}
     }
 
-    inline ~AmrConnect()
+    /*
+     * Out of core connectivity : only levels up to topLevel are allocated and connected by connectTree().
+     * Deeper levels are connected one subtree at a time, with setWindow() and connectTree(topLevel,node).
+     */
+    inline AmrConnect( const AmrTree& t, const LevelInfo<D>* l, int topLevel )
+      : tree(t), levelInfo(l), connectLevels(topLevel+1), layout(FullCubes)
+    {
+      allocate();
+      for(int i=0;i<=topLevel;i++)
+	{
+	  setWindow( i, 0, tree.nodeLevels[i].size );
+	}
+    }
+
+    /*
+     * OnDemand layout on parent arrays owned by the caller (a mapped file for instance), filled by connectParents().
+     */
+    inline AmrConnect( const AmrTree& t, const LevelInfo<D>* l, int* const* parents )
+      : tree(t), levelInfo(l), connectLevels(t.nLevels), layout(OnDemand), externalParents(true)
     {
+      allocate();
       for(int i=0;i<tree.nLevels;i++)
 	{
-	  delete [] cubes[i];
-	}      
+	  parent[i] = parents[i];
+	}
+    }
+
+    inline ~AmrConnect()
+    {
+      release();
+      for(int i=0;i<(tree.nLevels-1);i++)
+	{
+	  delete [] branchCoord[i];
+	}
+      delete [] branchCoord;
       delete [] cubes;
+      delete [] parent;
+      delete [] firstNode;
+      delete [] cache;
+      delete [] cacheNode;
+    }
+
+    AmrConnect(const AmrConnect&) = delete;
+    AmrConnect& operator = (const AmrConnect&) = delete;
+
+    // (re)allocates cubes of nodes [first;first+size[ at a level
+    inline void setWindow( int level, int first, int size )
+    {
+      delete [] cubes[level];
+      cubes[level] = new Cube[ size ];
+      firstNode[level] = first;
+      for(int j=0;j<size;j++)
+	{
+	  initCube( cubes[level][j], level, first + j );
+	}
     }
 
+    inline Cube& cube( int level, int node ) { return cubes[level][ node - firstNode[level] ]; }
+    inline const Cube& cube( int level, int node ) const { return cubes[level][ node - firstNode[level] ]; }
+
     // Operateur de connexion entre une extremite d'un cube et l'extremite correspondante d'un cube voisin
     template <unsigned int __D>
     struct PopulateCube
     {
       enum { D = __D };
-      inline PopulateCube(AmrConnect& s) : self(s) {}
+      inline PopulateCube(const AmrConnect& s) : self(s) {}
 
       // "parent" est le cube parent dont le fils a la coordonee "coord" est le voisin "child",
       // du noeud enfant destination
@@ -109,7 +166,7 @@ namespace Amr2Ugrid
 	  }
       }
 
-      AmrConnect& self;
+      const AmrConnect& self;
     };
     
     
@@ -123,14 +180,14 @@ namespace Amr2Ugrid
       {
 	int branch = self.levelInfo[level].grid.branch( coord );
 	int subNode = self.tree.subNode(level,node,branch);
-	if(subNode != -1)
+	if(subNode != -1 && (level+1) < self.connectLevels)
 	  {
 	    PopulateCube<D> connector(self);
 	    Nbh<ElementInfo,D>::dig(
 			self.levelInfo[level].grid, // taille de la grille du niveau courant
 			connector, // operateur de connection d'un parent vers le voisin d'un noeud inferieur
-			self.cubes[level][node], // parent
-			self.cubes[level+1][subNode], // fils
+			self.cube(level,node), // parent
+			self.cube(level+1,subNode), // fils
 			coord // coordonee a laquelle on "creuse" vers le nieveau inferieur
 		     );
 	    self.connectTree( level+1, subNode );
@@ -143,10 +200,63 @@ namespace Amr2Ugrid
 
     inline void connectTree( int level=0, int nodeId=0 )
     {
+      if( layout == OnDemand )
+	{
+	  connectParents();
+	  return;
+	}
       ForEachPieceOfGrid<D> gridParser(*this,level,nodeId);
       gridEnum( levelInfo[level].grid , gridParser  );
     }
 
+    // OnDemand layout : parent of each node
+    inline void connectParents()
+    {
+      for(int i=0;i<tree.nLevels;i++)
+	{
+	  for(int j=0;j<tree.nodeLevels[i].size;j++) parent[i][j] = -1;
+	}
+      for(int i=0;i<(tree.nLevels-1);i++)
+	{
+	  int nChildren = levelInfo[i].grid.gridSize();
+	  for(int j=0;j<tree.nodeLevels[i].size;j++)
+	    {
+	      int index = tree.nodeLevels[i].nodes[j].index;
+	      if( index == -1 ) continue;
+	      for(int k=0;k<nChildren;k++) parent[i+1][index+k] = j;
+	    }
+	}
+      resetCache();
+    }
+
+    // Cube of a node, whatever the layout. With OnDemand, the returned Cube is valid until the next call
+    // from the same thread (each thread has its own cache)
+    inline const Cube& neighborhood( int level, int node ) const
+    {
+      if( layout == FullCubes ) return cube(level,node);
+      int thread = 0;
+#     ifdef _OPENMP
+      thread = omp_get_thread_num();
+#     endif
+      assert( thread < nCaches );
+      Cube& c = cache[ thread*tree.nLevels + level ];
+      int& cachedNode = cacheNode[ thread*tree.nLevels + level ];
+      if( cachedNode != node )
+	{
+	  initCube( c, level, node );
+	  if( level > 0 )
+	    {
+	      int p = parent[level][node];
+	      const Cube& pc = neighborhood( level-1, p );
+	      PopulateCube<D> connector(*this);
+	      int branch = node - tree.nodeLevels[level-1].nodes[p].index;
+	      Nbh<ElementInfo,D>::dig( levelInfo[level-1].grid, connector, pc, c, branchCoord[level-1][branch] );
+	    }
+	  cachedNode = node;
+	}
+      return c;
+    }
+
 
     struct CubeStats
     {
@@ -175,7 +285,7 @@ namespace Amr2Ugrid
 		  leaves++;
 		  int s=0;
 		  CubeStats stat(s);
-		  cubes[i][j].forEachComponent( stat );
+		  neighborhood(i,j).forEachComponent( stat );
 		  if(s!=0) slide++;
 		}
 	    }
@@ -183,50 +293,131 @@ namespace Amr2Ugrid
 	}
     }
 
+    // FullCubes : nLevels, level sizes, Cubes. OnDemand : -nLevels, level sizes, parents
     template <typename StreamT> inline 
     void toBinaryStream(StreamT & out) const
     {
-      out.write( (char*)&(tree.nLevels) , sizeof(int) );
+      int header = ( layout == FullCubes ) ? tree.nLevels : -tree.nLevels;
+      out.write( (char*)&header , sizeof(int) );
       for(int i=0;i<tree.nLevels;i++)
 	{
 	  out.write( (char*)&(tree.nodeLevels[i].size) , sizeof(int) );
 	}
       for(int i=0;i<tree.nLevels;i++)
 	{
-	  out.write( (char*)(cubes[i]) , tree.nodeLevels[i].size*sizeof(Cube) );
+	  if( layout == FullCubes ) out.write( (char*)(cubes[i]) , tree.nodeLevels[i].size*sizeof(Cube) );
+	  else out.write( (char*)(parent[i]) , tree.nodeLevels[i].size*sizeof(int) );
 	}
     }
 
+    // reads either layout
     template <typename StreamT> inline 
     void fromBinaryStream(StreamT & in)
     {
-      int nLevels = 0;
-      in.read( (char*)&nLevels , sizeof(int) );
-      assert( nLevels == tree.nLevels );
-      cubes = new Cube*[tree.nLevels];
+      int header = 0;
+      in.read( (char*)&header , sizeof(int) );
+      layout = ( header < 0 ) ? OnDemand : FullCubes;
+      assert( ( header < 0 ? -header : header ) == tree.nLevels );
+      release();
 
-      int totalSize = 0;
       for(int i=0;i<tree.nLevels;i++)
 	{
 	  int size = 0;
 	  in.read( (char*)&size , sizeof(int) );
 	  assert( size == tree.nodeLevels[i].size );
-	  totalSize += size;
 	}
-      //Cube* ptr = new Cube[totalSize];
       for(int i=0;i<tree.nLevels;i++)
 	{
-	  //cubes[i] = ptr;
-	  cubes[i] = new Cube[ tree.nodeLevels[i].size ];
-	  in.read( (char*)(cubes[i]) , tree.nodeLevels[i].size*sizeof(Cube) );
-	  //ptr += tree.nodeLevels[i].size;
+	  int size = tree.nodeLevels[i].size;
+	  firstNode[i] = 0;
+	  if( layout == FullCubes )
+	    {
+	      cubes[i] = new Cube[ size ];
+	      in.read( (char*)(cubes[i]) , size*sizeof(Cube) );
+	    }
+	  else
+	    {
+	      parent[i] = new int[ size ];
+	      in.read( (char*)(parent[i]) , size*sizeof(int) );
+	    }
 	}
+      resetCache();
     }
 
     // ---- Data ----
     const AmrTree& tree;
     const LevelInfo<D>* levelInfo;
     Cube** cubes;
+    int* firstNode; // node of cubes[level][0]
+    int connectLevels; // connectTree stops at this level
+    Layout layout;
+    int** parent; // OnDemand layout
+    bool externalParents = false; // parent arrays are not owned
+    Coord** branchCoord; // grid coordinates of each branch, per level
+
+  private:
+    inline void initCube( Cube& c, int level, int node ) const
+    {
+      CubeInitialize cubeInitialize;
+      c.forEachComponent( cubeInitialize );
+      c.self().level = level;
+      c.self().node = node;
+    }
+
+    struct BranchCoord
+    {
+      inline void operator () (const Coord& coord) { table[ grid.branch(coord) ] = coord; }
+      GridDimension<D> grid;
+      Coord* table;
+    };
+
+    inline void allocate()
+    {
+      cubes = new Cube*[ tree.nLevels ];
+      parent = new int*[ tree.nLevels ];
+      firstNode = new int[ tree.nLevels ];
+      nCaches = 1;
+#     ifdef _OPENMP
+      nCaches = omp_get_max_threads();
+#     endif
+      cache = new Cube[ nCaches*tree.nLevels ];
+      cacheNode = new int[ nCaches*tree.nLevels ];
+      resetCache();
+      for(int i=0;i<tree.nLevels;i++)
+	{
+	  cubes[i] = 0;
+	  firstNode[i] = 0;
+	  parent[i] = ( layout == OnDemand && !externalParents ) ? new int[ tree.nodeLevels[i].size ] : 0;
+	}
+      branchCoord = new Coord*[ tree.nLevels ];
+      for(int i=0;i<(tree.nLevels-1);i++)
+	{
+	  BranchCoord bc;
+	  bc.grid = levelInfo[i].grid;
+	  bc.table = branchCoord[i] = new Coord[ bc.grid.gridSize() ];
+	  gridEnum( bc.grid, bc );
+	}
+    }
+
+    inline void resetCache()
+    {
+      for(int i=0;i<nCaches*tree.nLevels;i++) cacheNode[i] = -1;
+    }
+
+    inline void release()
+    {
+      for(int i=0;i<tree.nLevels;i++)
+	{
+	  delete [] cubes[i];
+	  if( !externalParents ) delete [] parent[i];
+	  cubes[i] = 0;
+	  parent[i] = 0;
+	}
+    }
+
+    mutable Cube* cache; // last Cube computed by neighborhood(), per thread and level
+    mutable int* cacheNode;
+    int nCaches;
   };
 
 
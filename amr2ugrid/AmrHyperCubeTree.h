@@ -0,0 +1,345 @@
+#ifndef __AMR_HYPER_CUBE_TREE_H
+#define __AMR_HYPER_CUBE_TREE_H
+
+#include "Vec.h"
+#include "AmrCellSize.h"
+#include "AmrLevels.h"
+#include "AmrTree.h"
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "SimpleSubdivisionScheme.h"
+#include "TreeLevelArray.h"
+#include "RadixSort.h"
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <assert.h>
+
+namespace Amr2Ugrid
+{
+
+	using namespace hct;
+
+	/*
+	 * Unstructured mesh to tree conversion, built directly into an hct::HyperCubeTree.
+	 * Subdivision grids are the ones found by AmrLevels.
+	 * Each tree cell knows the mesh cell inserted at its place (MeshCell, -1 if none)
+	 * and how many mesh cells were inserted there (MeshCellCount, more than 1 means duplicated cells).
+	 * Cells are inserted in the same order as the legacy AmrTree would, so that tree cell indices are identical.
+	 */
+	template<unsigned int _D>
+	struct AmrHyperCubeTree
+	{
+		enum { D = _D };
+		using SubdivisionScheme = hct::SimpleSubdivisionScheme<D>;
+		using Tree = hct::HyperCubeTree<D, SubdivisionScheme>;
+		using Cell = hct::HyperCubeTreeCell;
+
+		inline void initLevels(int nLevels, const LevelInfo<D>* levels)
+		{
+			assert( nLevels >= 1 );
+			SubdivisionScheme subdivisions;
+			for(int i=0;i<(nLevels-1);i++)
+			{
+				subdivisions.addLevelSubdivision( levels[i].grid );
+			}
+			tree.reset( new Tree(subdivisions) );
+			meshCell.setName("MeshCell");
+			meshCellCount.setName("MeshCellCount");
+			tree->addArray(&meshCell);
+			tree->addArray(&meshCellCount);
+			meshCell[ tree->rootCell() ] = -1;
+			meshCellCount[ tree->rootCell() ] = 0;
+		}
+
+		/*
+		 * Insert a mesh cell, given its center and its depth in the tree.
+		 * Missing cells along the path are created.
+		 */
+		template <typename T>
+		inline Cell insertCell(
+			Vec<T,D> cellCenter,
+			int cellDepth,
+			Vec<T,D> origin,
+			const AmrCellSize<T,D>* levelSize,
+			int meshCellId )
+		{
+			Cell cell = tree->rootCell();
+			for(int depth=0; depth<cellDepth; depth++)
+			{
+				AmrCellSize<T,D> cellSize = levelSize[depth+1];
+				Vec<unsigned int,D> cellPos = ( cellCenter - origin ) / cellSize ;
+				origin += ( cellSize * cellPos );
+				if( tree->isLeaf(cell) )
+				{
+					refine(cell);
+				}
+				cell = tree->child( cell, cellPos );
+			}
+			if( meshCell[cell] == -1 ) meshCell[cell] = meshCellId;
+			meshCellCount[cell]++;
+			return cell;
+		}
+
+		/*
+		 * Bulk insertion of nCells mesh cells, tree cell indices are written to m2t.
+		 * Each cell gets a path key (see pathKey), computed in parallel, then cells are inserted with insertKeys.
+		 * Falls back to insertCell when path keys do not fit in 64 bits.
+		 */
+		template <typename T>
+		inline void insertCells(
+			int nCells,
+			const Vec<T,D>* cellCenters,
+			const int* cellDepth,
+			Vec<T,D> origin,
+			const AmrCellSize<T,D>* levelSize,
+			int* m2t,
+			bool meshOrder = true )
+		{
+			std::vector<uint64_t> keyStride;
+			if( ! pathKeyStrides(keyStride) )
+			{
+				for(int i=0;i<nCells;i++)
+				{
+					m2t[i] = insertCell( cellCenters[i], cellDepth[i], origin, levelSize, i ).index();
+				}
+				return;
+			}
+
+			std::vector<uint64_t> keys(nCells);
+#			pragma omp parallel for
+			for(int i=0;i<nCells;i++)
+			{
+				keys[i] = pathKey( cellCenters[i], cellDepth[i], origin, levelSize, keyStride.data() );
+			}
+			insertKeys( nCells, keys.data(), cellDepth, 0, keyStride.data(), m2t, meshOrder );
+		}
+
+		// keyStride[d] = number of distinct paths below a cell of level d. false if path keys do not fit in 64 bits
+		inline bool pathKeyStrides(std::vector<uint64_t>& keyStride) const
+		{
+			int nSubdivisions = tree->getNumberOfLevels() - 1;
+			keyStride.assign(nSubdivisions+1, 1);
+			for(int d=nSubdivisions-1; d>=0; d--)
+			{
+				uint64_t gridSize = tree->getLevelSubdivisionGrid(d).gridSize();
+				if( keyStride[d+1] > UINT64_MAX / gridSize ) return false;
+				keyStride[d] = keyStride[d+1] * gridSize;
+			}
+			return true;
+		}
+
+		/*
+		 * Path key of a cell : branch indices from the root, most significant first, shorter paths padded with 0.
+		 * Same descent as insertCell.
+		 */
+		template <typename T>
+		inline uint64_t pathKey(
+			Vec<T,D> cellCenter,
+			int cellDepth,
+			Vec<T,D> origin,
+			const AmrCellSize<T,D>* levelSize,
+			const uint64_t* keyStride ) const
+		{
+			uint64_t key = 0;
+			for(int depth=0; depth<cellDepth; depth++)
+			{
+				AmrCellSize<T,D> cellSize = levelSize[depth+1];
+				Vec<unsigned int,D> cellPos = ( cellCenter - origin ) / cellSize ;
+				origin += ( cellSize * cellPos );
+				key += keyStride[depth+1] * tree->getLevelSubdivisionGrid(depth).branch(cellPos);
+			}
+			return key;
+		}
+
+		/*
+		 * Inserts n entries given by their path key and depth, tree cell indices are written to m2t.
+		 * cellId gives the mesh cell of each entry (entry index if null). Entries with a negative cellId
+		 * only create their path, they are not counted as mesh cells.
+		 * Entries are radix sorted by key, so that entries going through the same tree cell are contiguous,
+		 * then the tree is built level by level, with one linear pass over sorted entries per level.
+		 * With meshOrder, cells of a level are refined in the order insertCell would refine them
+		 * (order of the first entry going through them), giving the exact same tree numbering.
+		 * Otherwise they are refined in path order, which stores neighbor cells close to each other,
+		 * but legacy tools (AmrSidePoints) do not give the exact same results with this numbering.
+		 */
+		inline void insertKeys(
+			int n,
+			const uint64_t* pathKeys,
+			const int* depth,
+			const int* cellId,
+			const uint64_t* keyStride,
+			int* m2t,
+			bool meshOrder = true )
+		{
+			int nSubdivisions = tree->getNumberOfLevels() - 1;
+			std::vector<uint64_t> keys( pathKeys, pathKeys+n );
+			std::vector<int> entries(n);
+			for(int i=0;i<n;i++) entries[i] = i;
+			radixSort( keys, entries, radixSortKeyBits(keyStride[0]) );
+
+			// node[i] : index, in its current level, of the cell reached by the i-th sorted entry
+			std::vector<size_t> node(n, 0);
+			std::vector<uint64_t> firstEntry;
+			std::vector<size_t> refined;
+			for(int d=0; d<nSubdivisions; d++)
+			{
+				// cells of level d to refine, with the first entry going through each of them
+				firstEntry.clear();
+				refined.clear();
+				for(int i=0;i<n;i++)
+				{
+					if( depth[entries[i]] <= d ) continue;
+					if( refined.empty() || refined.back() != node[i] )
+					{
+						refined.push_back( node[i] );
+						firstEntry.push_back( entries[i] );
+					}
+					else if( static_cast<uint64_t>(entries[i]) < firstEntry.back() )
+					{
+						firstEntry.back() = entries[i];
+					}
+				}
+				if( meshOrder )
+				{
+					radixSort( firstEntry, refined, radixSortKeyBits(n) );
+				}
+				for(size_t c : refined)
+				{
+					refine( Cell(d,c) );
+				}
+				size_t gridSize = tree->getLevelSubdivisionGrid(d).gridSize();
+#				pragma omp parallel for
+				for(int i=0;i<n;i++)
+				{
+					if( depth[entries[i]] > d )
+					{
+						size_t branch = ( keys[i] / keyStride[d+1] ) % gridSize;
+						node[i] = tree->child( Cell(d,node[i]), branch ).index();
+					}
+				}
+			}
+
+			// sort is stable : among duplicated cells, the first entry is met first
+			for(int i=0;i<n;i++)
+			{
+				int e = entries[i];
+				int id = ( cellId != 0 ) ? cellId[e] : e;
+				if( id >= 0 )
+				{
+					Cell cell( depth[e], node[i] );
+					if( meshCell[cell] == -1 ) meshCell[cell] = id;
+					meshCellCount[cell]++;
+				}
+				m2t[e] = node[i];
+			}
+		}
+
+		/*
+		 * Legacy tree layout, for tools that still work on AmrTree (AmrConnect, AmrSidePoints, .tree files)
+		 */
+		inline void toAmrTree(AmrTree& amrTree) const
+		{
+			int nLevels = tree->getNumberOfLevels();
+			amrTree.nLevels = nLevels;
+			amrTree.nodeLevels = new NodeLevel[nLevels];
+			size_t totalSize = 0;
+			for(int i=0;i<nLevels;i++)
+			{
+				totalSize += tree->getLevelSize(i);
+			}
+			TreeNode* ptr = amrTree.allNodes = new TreeNode[totalSize];
+			for(int i=0;i<nLevels;i++)
+			{
+				int size = tree->getLevelSize(i);
+				amrTree.nodeLevels[i].capacity = 0;
+				amrTree.nodeLevels[i].size = size;
+				amrTree.nodeLevels[i].nodes = ptr;
+				for(int j=0;j<size;j++)
+				{
+					Cell cell(i,j);
+					ptr[j].index = tree->isLeaf(cell) ? -1 : tree->child(cell,0).index();
+					ptr[j].nCells = meshCellCount[cell];
+				}
+				ptr += size;
+			}
+		}
+
+		/*
+		 * Tree read back from the legacy layout (.tree files), with the same cell indices.
+		 * Children blocks of a level are allocated in increasing index order.
+		 */
+		inline void fromAmrTree(const AmrTree& amrTree, const LevelInfo<D>* levels)
+		{
+			int nLevels = amrTree.nLevels;
+			initLevels(nLevels, levels);
+			meshCellCount[ tree->rootCell() ] = amrTree.nodeLevels[0].nodes[0].nCells;
+			std::vector< std::pair<int,int> > refined; // first child, node
+			for(int i=0;i<(nLevels-1);i++)
+			{
+				refined.clear();
+				for(int j=0;j<amrTree.nodeLevels[i].size;j++)
+				{
+					int index = amrTree.nodeLevels[i].nodes[j].index;
+					if( index != -1 ) refined.push_back( std::make_pair(index,j) );
+				}
+				std::sort( refined.begin(), refined.end() );
+				for(const auto& r : refined)
+				{
+					assert( tree->getLevelSize(i+1) == static_cast<size_t>(r.first) );
+					refine( Cell(i,r.second) );
+				}
+				assert( tree->getLevelSize(i+1) == static_cast<size_t>(amrTree.nodeLevels[i+1].size) );
+				for(int j=0;j<amrTree.nodeLevels[i+1].size;j++)
+				{
+					meshCellCount[ Cell(i+1,j) ] = amrTree.nodeLevels[i+1].nodes[j].nCells;
+				}
+			}
+		}
+
+		template <typename StreamT> inline
+		void toStream(StreamT & out) const
+		{
+			int nLevels = tree->getNumberOfLevels();
+			for(int i=0;i<nLevels;i++)
+			{
+				int size = tree->getLevelSize(i);
+				int leaves=0;
+				int uniques=0;
+				for(int j=0;j<size;j++)
+				{
+					Cell cell(i,j);
+					if( tree->isLeaf(cell) )
+					{
+						leaves++;
+						if( meshCellCount[cell] == 1 ) uniques++;
+					}
+				}
+				out<<i<<" : size="<<size<<", "<<leaves<<" leaves, "<<uniques<<" singles\n";
+			}
+		}
+
+		std::unique_ptr<Tree> tree;
+		TreeLevelArray<int> meshCell;
+		TreeLevelArray<int> meshCellCount;
+
+	private:
+		inline void refine(Cell cell)
+		{
+			tree->refine(cell);
+			size_t nChildren = tree->getLevelSubdivisionGrid(cell.level()).gridSize();
+			for(size_t i=0;i<nChildren;i++)
+			{
+				Cell child = tree->child(cell,i);
+				meshCell[child] = -1;
+				meshCellCount[child] = 0;
+			}
+		}
+	};
+
+}; // Amr2Ugrid
+
+#endif
@@ -37,15 +37,6 @@ int main(int argc, char* argv[])
   fic_sizes.read( (char*)cellSizes, sizeof(AmrCellSize<float,3>)*nCells );
   fic_sizes.close();
 
-  // construction des niveaux
-  AmrLevels<float,3> levels;
-  AmrLevels<float,3>::LevelMap levelMap;
-
-  for(int i=0;i<nCells;i++)
-    {
-      levelMap[ cellSizes[i] ].nCells++;
-    }
-
   cout<<"<- "<<boundsFileName<<endl;
   Vec<float,3> bmin,bmax;
   ifstream fic_bounds(boundsFileName.c_str());
@@ -58,17 +49,12 @@ int main(int argc, char* argv[])
   fic_bounds.read( (char*)&bmax, sizeof(Vec<float,3>) );
   fic_bounds.close();
 
-  // finalisation des niveaux
-  levelMap[ bmax - bmin ].nCells++;
-  levels.fromMap(levelMap);
+  // construction des niveaux et recuperation de la profondeur en fonction de la taille
+  AmrLevels<float,3> levels;
+  int * depth = new int [nCells];
+  levels.fromCellSizes( nCells, cellSizes, bmax - bmin, depth );
   levels.toStream(cout);
 
-  // recuperation de la profondeur en fonction de la taille
-  int * depth = new int [nCells];
-  for(int i=0;i<nCells;i++)
-    {
-      depth[i] = levelMap[ cellSizes[i] ].depth;
-    }
   delete [] cellSizes;
   cout<<"-> "<<depthFileName<<endl;
   ofstream fic_depth(depthFileName.c_str());
@@ -81,7 +67,6 @@ int main(int argc, char* argv[])
   fic_depth.write( (char*)depth, sizeof(int)*nCells );
   fic_depth.close();
   delete [] depth;
-  levelMap.clear();
 
   cout<<"-> "<<levelsFileName<<endl;
   ofstream fic_lvl(levelsFileName.c_str());
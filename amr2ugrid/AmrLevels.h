@@ -6,6 +6,15 @@
 #include "GridDimension.h"
 
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace Amr2Ugrid
 {
@@ -80,6 +89,8 @@ namespace Amr2Ugrid
 	levelMap = normalizedLevelMap;
 
 	nLevels = levelMap.size();
+	if( levelInfo != 0 ) delete [] levelInfo;
+	if( levelSize != 0 ) delete [] levelSize;
 	levelInfo = new LevelInfo[nLevels];
 	levelSize = new AmrCellSize[nLevels];
 	int i=0;
@@ -91,6 +102,138 @@ namespace Amr2Ugrid
 	  }
       }
 
+      // same equivalence as the one LevelMap uses
+      static inline bool sameLevel( const AmrCellSize& a, const AmrCellSize& b )
+      {
+	return !( a < b ) && !( b < a );
+      }
+
+      /*
+       * Level detection from cell sizes : builds levels from sizes of all cells plus the domain size,
+       * and writes the depth of each cell.
+       * Sizes are quantized to log2 buckets in a parallel pass, then buckets are merged into levels
+       * with the LevelMap equivalence. Only one size per level (the first one met, as LevelMap keeps it) is inserted in the LevelMap.
+       * A second parallel pass finds cell depths and checks each cell is equivalent to its level size.
+       * Results are the same as inserting every cell size in a LevelMap. If a cell does not match its level
+       * (sizes not well separated), falls back to fromCellSizesMap.
+       * The three steps (addCellSizes, fromSizeBuckets, cellDepths) can also be run chunk by chunk.
+       */
+      inline void fromCellSizes( int nCells, const AmrCellSize* cellSizes, const AmrCellSize& domainSize, int* depth )
+      {
+	sizeBuckets.clear();
+	// the domain is handled as an extra cell, after mesh cells
+	addCellSizes( 0, nCells, cellSizes );
+	addCellSizes( nCells, 1, &domainSize );
+	fromSizeBuckets();
+	if( cellDepths( nCells, cellSizes, depth ) > 0 )
+	  {
+	    fromCellSizesMap( nCells, cellSizes, domainSize, depth );
+	  }
+      }
+
+      // quantizes sizes of cells [first;first+count[ to log2 buckets, merged with buckets of previous calls
+      inline void addCellSizes( int first, int count, const AmrCellSize* cellSizes )
+      {
+	int maxThreads = 1;
+#	ifdef _OPENMP
+	maxThreads = omp_get_max_threads();
+#	endif
+	std::vector< std::vector<SizeBucket> > threadBuckets(maxThreads);
+
+#	pragma omp parallel
+	{
+	  int thread = 0;
+#	  ifdef _OPENMP
+	  thread = omp_get_thread_num();
+#	  endif
+	  std::vector<SizeBucket>& buckets = threadBuckets[thread];
+	  size_t last = 0;
+#	  pragma omp for schedule(static)
+	  for(int i=0;i<count;i++)
+	    {
+	      uint64_t key = bucketKey( cellSizes[i] );
+	      // consecutive cells often have the same size
+	      if( last < buckets.size() && buckets[last].key == key ) { buckets[last].nCells++; continue; }
+	      auto it = std::find_if( buckets.begin(), buckets.end(), [key](const SizeBucket& b){ return b.key==key; } );
+	      if( it == buckets.end() ) { it = buckets.insert( buckets.end(), SizeBucket{key,first+i,1,cellSizes[i]} ); }
+	      else it->nCells++;
+	      last = it - buckets.begin();
+	    }
+	}
+
+	// merge per thread buckets, a bucket keeps the size of its first cell
+	for(const auto& tb : threadBuckets)
+	  {
+	    for(const SizeBucket& b : tb)
+	      {
+		auto it = std::find_if( sizeBuckets.begin(), sizeBuckets.end(), [&b](const SizeBucket& x){ return x.key==b.key; } );
+		if( it == sizeBuckets.end() ) sizeBuckets.push_back(b);
+		else
+		  {
+		    it->nCells += b.nCells;
+		    if( b.first < it->first ) { it->first = b.first; it->size = b.size; }
+		  }
+	      }
+	  }
+      }
+
+      // buckets to levels, in first occurrence order : sizes close to a power of 2 may be split between two buckets
+      inline void fromSizeBuckets()
+      {
+	std::sort( sizeBuckets.begin(), sizeBuckets.end(), [](const SizeBucket& a, const SizeBucket& b){ return a.first < b.first; } );
+	LevelMap levelMap;
+	bucketLevel.resize( sizeBuckets.size() );
+	for(size_t b=0;b<sizeBuckets.size();b++)
+	  {
+	    bucketLevel[b] = sizeBuckets[b].size;
+	    for(size_t p=0;p<b;p++)
+	      {
+		if( sameLevel( bucketLevel[p], bucketLevel[b] ) ) { bucketLevel[b] = bucketLevel[p]; break; }
+	      }
+	    levelMap[ bucketLevel[b] ].nCells += sizeBuckets[b].nCells;
+	  }
+	fromMap(levelMap);
+
+	bucketDepth.resize( sizeBuckets.size() );
+	for(size_t b=0;b<sizeBuckets.size();b++)
+	  {
+	    bucketDepth[b] = levelMap[ bucketLevel[b] ].depth;
+	  }
+      }
+
+      // depth of count cells, one bucket lookup per cell. Returns the number of cells not equivalent to their level size.
+      inline int cellDepths( int count, const AmrCellSize* cellSizes, int* depth ) const
+      {
+	int nMismatch = 0;
+#	pragma omp parallel for schedule(static) reduction(+:nMismatch)
+	for(int i=0;i<count;i++)
+	  {
+	    uint64_t key = bucketKey( cellSizes[i] );
+	    size_t b = 0;
+	    while( b < sizeBuckets.size() && sizeBuckets[b].key != key ) b++;
+	    int d = ( b < sizeBuckets.size() ) ? bucketDepth[b] : -1;
+	    if( d < 0 || ! sameLevel( cellSizes[i], bucketLevel[b] ) || ! sameLevel( cellSizes[i], levelSize[d] ) ) nMismatch++;
+	    depth[i] = d;
+	  }
+	return nMismatch;
+      }
+
+      // reference level detection, one LevelMap access per cell
+      inline void fromCellSizesMap( int nCells, const AmrCellSize* cellSizes, const AmrCellSize& domainSize, int* depth )
+      {
+	LevelMap levelMap;
+	for(int i=0;i<nCells;i++)
+	  {
+	    levelMap[ cellSizes[i] ].nCells++;
+	  }
+	levelMap[ domainSize ].nCells++;
+	fromMap(levelMap);
+	for(int i=0;i<nCells;i++)
+	  {
+	    depth[i] = levelMap[ cellSizes[i] ].depth;
+	  }
+      }
+
       template <typename StreamT> inline 
       void toStream(StreamT & out) const
       {
@@ -125,6 +268,47 @@ namespace Amr2Ugrid
       size_t nLevels;
       LevelInfo* levelInfo;
       AmrCellSize* levelSize;
+
+    private:
+      struct SizeBucket
+      {
+	uint64_t key;
+	int first;
+	int nCells;
+	AmrCellSize size; // size of the first cell
+      };
+      std::vector<SizeBucket> sizeBuckets;
+      std::vector<AmrCellSize> bucketLevel; // level size of each bucket
+      std::vector<int> bucketDepth;
+
+      /*
+       * rounded 2.log2 of each component, packed on Bits bits per component.
+       * Buckets are sqrt(2) wide, sizes of a bucket are all equivalent for LevelMap.
+       */
+      static inline uint64_t bucketKey( const AmrCellSize& size )
+      {
+	static constexpr int Bits = ( 64/D < 21 ) ? 64/D : 21;
+	static constexpr int Offset = 1 << (Bits-1);
+	static const T M1 = static_cast<T>( std::pow(2.0,-0.75) );
+	static const T M2 = static_cast<T>( std::pow(2.0,-0.25) );
+	T v[D];
+	size.toArray(v);
+	uint64_t key = 0;
+	for(unsigned int k=0;k<D;k++)
+	  {
+	    int e = -Offset;
+	    if( v[k] > 0 )
+	      {
+		// v = m.2^x, m in [0.5;1[
+		int x = 0;
+		T m = std::frexp( v[k], &x );
+		e = 2*x - ( (m<M1) ? 2 : ( (m<M2) ? 1 : 0 ) );
+	      }
+	    e = std::max( -Offset, std::min( Offset-1, e ) );
+	    key = ( key << Bits ) | static_cast<uint64_t>( e + Offset );
+	  }
+	return key;
+      }
     };
 
 }; // namespace hct
@@ -1,13 +1,33 @@
 #include "AmrSidePoints.h"
+#include "AmrUGrid.h"
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <chrono>
 using namespace std;
 using namespace Amr2Ugrid;
 using namespace hct;
-	
+
+// fichiers par maille : nCells, puis une valeur par maille
+template<typename T>
+static bool readCellArray(const string& fileName, int& nCells, vector<T>& values)
+{
+  cout<<"<- "<<fileName<<endl;
+  ifstream fic( fileName.c_str() );
+  int n = 0;
+  if( !fic || !fic.read( (char*)&n, sizeof(int) ) || ( nCells != 0 && n != nCells ) )
+    {
+      cerr<<"Erreur lecture "<<fileName<<endl;
+      return false;
+    }
+  nCells = n;
+  values.resize(n);
+  fic.read( (char*)values.data(), sizeof(T)*n );
+  return true;
+}
+
 int main(int argc, char* argv[])
 {
   // verification du nombre minimal d'arguments
@@ -21,12 +41,16 @@ int main(int argc, char* argv[])
   string levelFileName = baseName+".lvl";    // input
   string treeFileName = baseName+".tree";    // input
   string nbhFileName = baseName+".nbh";      // input
+  string bndFileName = baseName+".bnd";      // input
+  string m2tFileName = baseName+".m2t";      // input
+  string dptFileName = baseName+".dpt";      // input
+  string scalFileName = baseName+".scal";    // input
+  string ugridFileName = baseName+".ugrid";  // output
 
 #ifdef DEBUG
   cout<<"--- DEBUG ---"<<endl;
   string geomFileName = baseName + ".geom";
   string meshFileName = baseName + ".con";  
-  string m2tFileName = baseName + ".m2t";   
   string depthFileName = baseName + ".dpt"; 
   string centersFileName = baseName + ".cc";
   string sizesFileName = baseName + ".cs";
@@ -150,10 +174,7 @@ int main(int argc, char* argv[])
 
   AmrSidePoints<3> amrSidePoints;
   amrSidePoints.init(tree);
-  for(int i=0;i<3;i++)
-    {
-      amrSidePoints.unifyPoints( tree, levels.levelInfo, amrConnect );
-    }
+  amrSidePoints.unifyPoints( tree, levels.levelInfo, amrConnect );
   amrSidePoints.markPointOwners( tree );
   amrSidePoints.countSidePoints( tree, amrConnect );
   amrSidePoints.restorePointIdMap( tree );
@@ -172,5 +193,35 @@ int main(int argc, char* argv[])
   cout<<"Nb points de cotés : "<<amrSidePoints.nSidePoints<<endl;
   cout<<"Moyenne points de coté : "<<amrSidePoints.nSidePoints/(double)amrSidePoints.nSpecials<<endl;
 
+  // maillage final
+  cout<<"<- "<<bndFileName<<endl;
+  ifstream fic_in( bndFileName.c_str() );
+  if( !fic_in )
+    {
+      cerr<<"Erreur lecture "<<bndFileName<<endl;
+      return 1;
+    }
+  Vec<float,3> bmin, bmax;
+  fic_in.read( (char*)&bmin, sizeof(bmin) );
+  fic_in.read( (char*)&bmax, sizeof(bmax) );
+  fic_in.close();
+
+  int nMeshCells = 0;
+  vector<int> m2t, dpt;
+  vector<float> scalars;
+  if( !readCellArray(m2tFileName,nMeshCells,m2t) || !readCellArray(dptFileName,nMeshCells,dpt) || !readCellArray(scalFileName,nMeshCells,scalars) )
+    {
+      return 1;
+    }
+
+  AmrUGrid<3> ugrid;
+  ugrid.build( tree, levels.levelInfo, amrConnect, amrSidePoints, bmin, bmax, nMeshCells, m2t.data(), dpt.data(), scalars.data() );
+  ugrid.toStream(cout);
+
+  cout<<"-> "<<ugridFileName<<endl;
+  ofstream fic_out( ugridFileName.c_str() );
+  ugrid.toBinaryStream(fic_out);
+  fic_out.close();
+
   return 0;
 }
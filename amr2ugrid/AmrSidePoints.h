@@ -8,6 +8,7 @@
 #include "AmrLevels.h"
 #include "PointIds.h"
 #include "PointStatus.h"
+#include "UnionFind.h"
 
 
 #ifdef DEBUG
@@ -43,7 +44,7 @@ namespace Amr2Ugrid
     using LevelInfo = Amr2Ugrid::LevelInfo<D>;
     using AmrConnect = Amr2Ugrid::AmrConnect<D>;
 
-    inline AmrSidePoints() : sidePoints(0), pointIds(0), nPointIds(0), sidePointArray(0) {}
+    inline AmrSidePoints() : pointIds(0), nPointIds(0), sidePoints(0), sidePointArray(0), sidePointFirst(0) {}
 
     inline void init( const AmrTree& tree )
     {
@@ -67,31 +68,40 @@ namespace Amr2Ugrid
       this->pointIdMap = new int [nPointIds];
     }
 
+    /*
+     * Points shared by neighbor cells, and by parent and child cells, get the same point id.
+     * Each shared point relation unites two point ids in a union-find, in parallel over the nodes of a level,
+     * so that chains of any length are merged in one pass.
+     * Point ids are then renumbered in order of first occurrence.
+     */
     inline void unifyPoints( const AmrTree& tree, const LevelInfo* levelInfo, const AmrConnect& sideConnectivity)
     {
-      ElementConnect<D> elementConnect(*this);
-
+      pointSets.reset( nPointIds );
       for(int i=0;i<tree.nLevels;i++)
 	{
-	  elementConnect.level = i;
 	  int ncubes = tree.nodeLevels[i].size;
-	  for(int j=0;j<ncubes;j++)
-	    {
-	      //if( tree.isLeaf(i,j) )
-		{
-		  elementConnect.node = j;
-		  sideConnectivity.cubes[i][j].forEachComponent(elementConnect);
-		}
-	    }
+#         pragma omp parallel
+	  {
+	    ElementConnect<D> elementConnect(*this);
+	    elementConnect.level = i;
+#           pragma omp for schedule(static)
+	    for(int j=0;j<ncubes;j++)
+	      {
+		elementConnect.node = j;
+		sideConnectivity.neighborhood(i,j).forEachComponent(elementConnect);
+	      }
+	  }
 
 	  // on oublie pas de fusionner les points partages entre parents et enfants
 	  if( i < (tree.nLevels-1) )
 	    {
+#             pragma omp parallel for schedule(static)
 	      for(int j=0;j<ncubes;j++)
 		{
 		  if( ! tree.isLeaf(i,j) )
 		    {
-		      InterLevelPointConnect<D>::connect( pointIds[i][j],
+		      InterLevelPointConnect<D>::connect( pointSets,
+							  pointIds[i][j],
 							  pointIds[i+1] + tree.nodeLevels[i].nodes[j].index,
 							  levelInfo[i].grid );
 		    }
@@ -107,7 +117,7 @@ namespace Amr2Ugrid
 	    {
 	      for(int k=0;k<PointIds::Size;k++)
 		{
-		  int ptId = pointIds[i][j][k];
+		  int ptId = pointSets.find( pointIds[i][j][k] );
 		  if( pointIdMap[ptId] == -1 ) pointIdMap[ptId] = nid++;
 		  pointIds[i][j][k] = pointIdMap[ptId];
 		}
@@ -154,7 +164,7 @@ namespace Amr2Ugrid
 	      if( tree.isLeaf(i,j) )
 		{
 		  countElementSidePoints.node = j;
-		  sideConnectivity.cubes[i][j].forEachComponent(countElementSidePoints);
+		  sideConnectivity.neighborhood(i,j).forEachComponent(countElementSidePoints);
 		}
 	    }
 	}
@@ -208,25 +218,46 @@ namespace Amr2Ugrid
 	}
     } 
 
-   inline void buildSidePointArray( const AmrTree& tree, const AmrConnect& sideConnectivity )
+    /*
+     * Side points of each leaf, in the same traversal as countSidePoints :
+     * sidePointArray[ sidePointFirst[i][j] + k ], k < sidePoints[i][j], lists the side points of leaf j of level i.
+     * Point ownership is marked again (same numbering, markPointOwners is idempotent) so that each point is inserted once.
+     */
+    inline void buildSidePointArray( const AmrTree& tree, const AmrConnect& sideConnectivity )
     {
+      markPointOwners( tree );
       this->sidePointArray = new int[ this->nSidePoints ];
       for(int i=0;i<this->nSidePoints;i++) this->sidePointArray[i]=-1;
-      //this->nSidePoints = 0; // should have the same value as formerly after computation
-/*
+      this->sidePointFirst = new int*[ tree.nLevels ];
+      int first = 0;
       for(int i=0;i<tree.nLevels;i++)
 	{
+	  int ncubes = tree.nodeLevels[i].size;
+	  this->sidePointFirst[i] = new int[ ncubes ];
+	  for(int j=0;j<ncubes;j++)
+	    {
+	      this->sidePointFirst[i][j] = first;
+	      if( tree.isLeaf(i,j) ) first += this->sidePoints[i][j];
+	      this->sidePoints[i][j] = 0;
+	    }
+	}
+      assert( first == this->nSidePoints );
+
+      CountElementSidePoints<D> insertElementSidePoints(*this, true);
+      for(int i=0;i<tree.nLevels;i++)
+	{
+	  insertElementSidePoints.level = i;
 	  int ncubes = tree.nodeLevels[i].size;
 	  for(int j=0;j<ncubes;j++)
 	    {
 	      if( tree.isLeaf(i,j) )
 		{
-		  countElementSidePoints.node = j;
-		  sideConnectivity.cubes[i][j].forEachComponent(countElementSidePoints);
+		  insertElementSidePoints.node = j;
+		  sideConnectivity.neighborhood(i,j).forEachComponent(insertElementSidePoints);
 		}
 	    }
 	}
-*/
+      restorePointIdMap( tree );
     }
 
     PointIds ** pointIds;
@@ -237,6 +268,8 @@ namespace Amr2Ugrid
     int nSpecials;
     int nLeaves;
     int * sidePointArray;
+    int ** sidePointFirst;
+    hct::UnionFind pointSets;
   };
 
 }; // Amr2Ugrid
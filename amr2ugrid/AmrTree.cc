@@ -1,6 +1,7 @@
 #include "Vec.h"
 #include "AmrLevels.h"
 #include "AmrTree.h"
+#include "AmrHyperCubeTree.h"
 
 #include <iostream>
 #include <fstream>
@@ -77,18 +78,14 @@ int main(int argc, char* argv[])
   fic_bnd.close();
   
   // initialisation arbre
-  AmrTree tree;
+  AmrHyperCubeTree<3> tree;
   tree.initLevels( levels.nLevels, levels.levelInfo );
-  tree.toStream(cout); cout<<endl;
 
   // allocation d'un tableau pour recuperer la correspondance maillage -> arbre
   int * m2t = new int [ nCells ];
 
   // insertion des mailles dans l'arbre
-  for(int i=0;i<nCells;i++)
-    {
-      m2t[i] = tree.insertCell( cellCenters[i], cellDepth[i], bmin, levels.levelInfo, levels.levelSize );
-    }
+  tree.insertCells( nCells, cellCenters, cellDepth, bmin, levels.levelSize, m2t );
   tree.toStream(cout); cout<<endl;
   delete [] cellCenters;
   delete [] cellDepth;
@@ -112,7 +109,9 @@ int main(int argc, char* argv[])
       cerr<<"Erreur ecriture "<<treeFileName<<endl;
       return 1;
     }
-  tree.toBinaryStream(fic_tree);
+  AmrTree amrTree;
+  tree.toAmrTree(amrTree);
+  amrTree.toBinaryStream(fic_tree);
   fic_tree.close();
 
   return 0;
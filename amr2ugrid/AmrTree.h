@@ -27,14 +27,14 @@ namespace Amr2Ugrid
 
   struct AmrTree
   {
-    inline AmrTree() : nLevels(0), nodeLevels(0), allNodes(0) {}
+    inline AmrTree() : nLevels(0), nodeLevels(0), allNodes(0), mapped(false) {}
     inline ~AmrTree()
     {
       if( allNodes!=0 )
 	{
 	  delete[] allNodes;
 	}
-      else
+      else if( !mapped )
 	{
 	  for(int i=0;i<nLevels;i++)
 	    {
@@ -219,9 +219,31 @@ namespace Amr2Ugrid
 		}
 	}
 
+	/*
+	 * Tree structure view on a buffer holding a tree file (memory mapped file) : nodes are not copied,
+	 * the buffer must outlive the tree.
+	 */
+	inline void fromBuffer(char* data)
+	{
+		int* header = reinterpret_cast<int*>( data );
+		nLevels = header[0];
+		nodeLevels = new NodeLevel[nLevels];
+		mapped = true;
+
+		TreeNode* ptr = reinterpret_cast<TreeNode*>( header + 1 + nLevels );
+		for(int i=0;i<nLevels;i++)
+		{
+			nodeLevels[i].capacity = 0; // empeche tout ajout
+			nodeLevels[i].size = header[1+i];
+			nodeLevels[i].nodes = ptr;
+			ptr += nodeLevels[i].size;
+		}
+	}
+
     int nLevels;
     NodeLevel* nodeLevels;
     TreeNode* allNodes;
+    bool mapped; // nodes are a view (fromBuffer)
   };
 
 }; // namespace hct
@@ -0,0 +1,517 @@
+#ifndef __AMR_UGRID_H
+#define __AMR_UGRID_H
+
+#include "Vec.h"
+#include "PointIds.h"
+#include "CubeEnum.h"
+#include "AmrTree.h"
+#include "AmrLevels.h"
+#include "AmrConnect.h"
+#include "AmrSidePoints.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Amr2Ugrid
+{
+
+	using namespace hct;
+
+  /*
+   * Final unstructured grid : one cell per tree leaf holding a mesh cell, in level then node order.
+   * Leaves with no other point than their corners on their boundary are hexahedra. The others are polyhedra :
+   * a face next to a refined neighbor is split along the neighbor's leaves, and each face polygon
+   * goes through all the cell's points lying on its boundary, so that faces match on both sides.
+   * Points are the unified points of AmrSidePoints, placed on the finest tree lattice. The side points of a leaf
+   * are the corners of the finer leaves across its faces and edges, collected with them.
+   * Cell values are the mesh cell scalars, remapped through the mesh to tree map (.m2t, .dpt).
+   *
+   * Cells of a level are generated in parallel, each thread appending to its own buffer.
+   * initCells() and buildCell() generate cells one at a time, without the whole grid (Amr2UGridStream).
+   *
+   * Binary layout, same as .bin mesh files :
+   * int nCells, int nPoints, nCells records { int n, int data[n] }, nPoints Vec3f points, nCells float scalars.
+   * A hexahedron is n=8 points, in VTK_HEXAHEDRON order. A polyhedron is a VTK_POLYHEDRON face stream :
+   * nFaces, then nPoints and point ids of each face, faces oriented outward.
+   */
+  template<unsigned int _D = 3>
+  struct AmrUGrid
+  {
+    enum { D = _D };
+    static_assert( D == 3, "AmrUGrid builds 3D cells" );
+    using Vec3 = hct::Vec<float,D>;
+    using Coord = hct::Vec<unsigned int,D>;
+    using PointIds = hct::PointIds<D>;
+    using LevelInfo = Amr2Ugrid::LevelInfo<D>;
+    using Connect = Amr2Ugrid::AmrConnect<D>;
+    using ElementInfo = typename Connect::ElementInfo;
+    using Cube = typename Connect::Cube;
+    using SidePoints = Amr2Ugrid::AmrSidePoints<D>;
+
+    inline AmrUGrid() : nHexahedra(0), nPolyhedra(0) {}
+
+    inline void build( const AmrTree& tree, const LevelInfo* levelInfo, const Connect& connect, const SidePoints& sidePoints,
+		       const Vec3& bmin, const Vec3& bmax, int nMeshCells, const int* m2t, const int* depth, const float* scalars )
+    {
+      initCells( tree, levelInfo, connect, sidePoints.pointIds );
+      int nLevels = tree.nLevels;
+
+      // first mesh cell of each tree node
+      m_nodeCell.assign( nLevels, std::vector<int>() );
+      for(int i=0;i<nLevels;i++) m_nodeCell[i].assign( tree.nodeLevels[i].size, -1 );
+      for(int i=0;i<nMeshCells;i++)
+	{
+	  int& cell = m_nodeCell[ depth[i] ][ m2t[i] ];
+	  if( cell == -1 ) cell = i;
+	}
+
+      // node positions
+      m_nodePos.assign( nLevels, std::vector<Coord>() );
+      m_nodePos[0].assign( 1, Coord(0u) );
+      for(int i=0;i<(nLevels-1);i++)
+	{
+	  int ncubes = tree.nodeLevels[i].size;
+	  int nChildren = levelInfo[i].grid.gridSize();
+	  m_nodePos[i+1].resize( tree.nodeLevels[i+1].size );
+#         pragma omp parallel for schedule(static)
+	  for(int j=0;j<ncubes;j++)
+	    {
+	      int index = tree.nodeLevels[i].nodes[j].index;
+	      if( index == -1 ) continue;
+	      for(int k=0;k<nChildren;k++)
+		{
+		  m_nodePos[i+1][index+k] = m_nodePos[i][j] * levelInfo[i].grid + connect.branchCoord[i][k];
+		}
+	    }
+	}
+
+      // point positions, from their first occurrence
+      int nPointIds = sidePoints.nPointIds;
+      m_pointLattice.resize( nPointIds );
+      std::vector<char> placed( nPointIds, 0 );
+      for(int i=0;i<nLevels;i++)
+	{
+	  int ncubes = tree.nodeLevels[i].size;
+	  for(int j=0;j<ncubes;j++)
+	    {
+	      for(int k=0;k<PointIds::Size;k++)
+		{
+		  int p = sidePoints.pointIds[i][j][k];
+		  if( ! placed[p] )
+		    {
+		      placed[p] = 1;
+		      m_pointLattice[p] = corner( m_nodePos[i][j], i, k );
+		    }
+		}
+	    }
+	}
+
+      // cells, level by level
+      records.clear();
+      cellStart.clear();
+      cellScalars.clear();
+      nHexahedra = nPolyhedra = 0;
+      int maxThreads = 1;
+#     ifdef _OPENMP
+      maxThreads = omp_get_max_threads();
+#     endif
+      std::vector< std::vector<int> > threadRecords( maxThreads );
+      std::vector< std::vector<int> > threadCells( maxThreads ); // node, then record start, of each cell
+      for(int i=0;i<nLevels;i++)
+	{
+	  int ncubes = tree.nodeLevels[i].size;
+#         pragma omp parallel
+	  {
+	    int thread = 0;
+#           ifdef _OPENMP
+	    thread = omp_get_thread_num();
+#           endif
+	    std::vector<int>& rec = threadRecords[thread];
+	    std::vector<int>& cells = threadCells[thread];
+	    rec.clear();
+	    cells.clear();
+	    Scratch tmp;
+	    // static schedule : contiguous chunks of nodes, in thread order
+#           pragma omp for schedule(static)
+	    for(int j=0;j<ncubes;j++)
+	      {
+		if( ! tree.isLeaf(i,j) || m_nodeCell[i][j] == -1 ) continue;
+		cells.push_back( j );
+		cells.push_back( rec.size() );
+		buildCell( i, j, m_nodePos[i][j], connect.neighborhood(i,j), rec, tmp );
+	      }
+	  }
+	  for(int t=0;t<maxThreads;t++)
+	    {
+	      size_t base = records.size();
+	      for(size_t c=0;c<threadCells[t].size();c+=2)
+		{
+		  cellStart.push_back( base + threadCells[t][c+1] );
+		  cellScalars.push_back( scalars[ m_nodeCell[i][ threadCells[t][c] ] ] );
+		  if( threadRecords[t][ threadCells[t][c+1] ] == PointIds::Size ) nHexahedra++;
+		  else nPolyhedra++;
+		}
+	      records.insert( records.end(), threadRecords[t].begin(), threadRecords[t].end() );
+	    }
+	}
+      cellStart.push_back( records.size() );
+      int nCells = cellScalars.size();
+
+      // points used by cells, renumbered in point id order
+      std::vector<char> used( nPointIds, 0 );
+#     pragma omp parallel for schedule(static)
+      for(int c=0;c<nCells;c++)
+	{
+	  forEachCellPoint( c, [&used](int& p)
+			    {
+#                             pragma omp atomic write
+			      used[p] = 1;
+			    } );
+	}
+      std::vector<int> pointIndex( nPointIds, -1 );
+      int nPoints = 0;
+      for(int p=0;p<nPointIds;p++)
+	{
+	  if( used[p] ) pointIndex[p] = nPoints++;
+	}
+      points.resize( nPoints );
+      Vec3 step = ( bmax - bmin ) / Vec3( latticeResolution() );
+#     pragma omp parallel for schedule(static)
+      for(int p=0;p<nPointIds;p++)
+	{
+	  if( pointIndex[p] != -1 ) points[ pointIndex[p] ] = bmin + Vec3( m_pointLattice[p] ) * step;
+	}
+#     pragma omp parallel for schedule(static)
+      for(int c=0;c<nCells;c++)
+	{
+	  forEachCellPoint( c, [&pointIndex](int& p) { p = pointIndex[p]; } );
+	}
+
+      m_nodeCell.clear();
+      m_nodePos.clear();
+      m_pointLattice.clear();
+    }
+
+    // tree, lattice step of each level, and point ids of tree nodes, for buildCell()
+    inline void initCells( const AmrTree& tree, const LevelInfo* levelInfo, const Connect& connect, const PointIds* const* pointIds )
+    {
+      m_tree = &tree;
+      m_connect = &connect;
+      m_pointIds = pointIds;
+      int nLevels = tree.nLevels;
+      m_scale.resize( nLevels );
+      std::vector<Coord> resolution( nLevels, Coord(1u) );
+      for(int i=1;i<nLevels;i++) resolution[i] = resolution[i-1] * levelInfo[i-1].grid;
+      for(int i=0;i<nLevels;i++) m_scale[i] = resolution[nLevels-1] / resolution[i];
+    }
+
+    // finest lattice size : points are in [0;latticeResolution()]
+    inline Coord latticeResolution() const { return m_scale[0]; }
+
+    // lattice position of corner k of a node at pos
+    inline Coord corner( const Coord& pos, int level, int k ) const
+    {
+      return ( pos + Coord::fromBitfield(k) ) * m_scale[level];
+    }
+
+    inline int nCells() const { return cellScalars.size(); }
+    inline int nPoints() const { return points.size(); }
+
+    template <typename StreamT>
+    inline void toStream(StreamT& out) const
+    {
+      out<<"Maillage final : "<<nCells()<<" mailles ("<<nHexahedra<<" hexaedres, "<<nPolyhedra<<" polyedres), "<<nPoints()<<" points\n";
+    }
+
+    template <typename StreamT>
+    inline void toBinaryStream(StreamT& out) const
+    {
+      int nc = nCells();
+      int np = nPoints();
+      out.write( (char*)&nc, sizeof(int) );
+      out.write( (char*)&np, sizeof(int) );
+      out.write( (char*)records.data(), records.size()*sizeof(int) );
+      out.write( (char*)points.data(), np*sizeof(Vec3) );
+      out.write( (char*)cellScalars.data(), nc*sizeof(float) );
+    }
+
+    // ---- Data ----
+    std::vector<int> records; // cell records { n, data[n] }
+    std::vector<size_t> cellStart; // record of each cell, nCells+1 entries
+    std::vector<float> cellScalars;
+    std::vector<Vec3> points;
+    int nHexahedra, nPolyhedra;
+
+    // part of face 2*axis+side, as a flat lattice box
+    struct SubFace
+    {
+      int face;
+      Coord lo, hi;
+    };
+
+    // per thread work buffers of buildCell()
+    struct Scratch
+    {
+      std::vector<SubFace> rects;
+      std::vector< std::pair<int,Coord> > points; // cell boundary points, id and lattice position
+      std::vector< std::pair<unsigned long,int> > polygon; // boundary position and id of a sub face point
+      std::vector<int> faces;
+    };
+
+    /* appends the record of a leaf at lattice position pos (in level units), with its neighborhood cube.
+     * Point ids are the unified ids, not the final point indices.
+     */
+    inline void buildCell( int level, int node, const Coord& pos, const Cube& cube, std::vector<int>& rec, Scratch& tmp ) const
+    {
+      const PointIds& ids = m_pointIds[level][node];
+      Neighbors neighbors;
+      cube.forEachComponent( neighbors );
+      Coord lo = pos * m_scale[level];
+      Coord hi = lo + m_scale[level];
+
+      /* all the points of the cell boundary : corners, and corners of the finer leaves across faces and edges
+       * (side points are among them), a point brought by a leaf across an edge may lie on two faces
+       */
+      tmp.points.clear();
+      tmp.rects.clear();
+      for(int k=0;k<PointIds::Size;k++)
+	{
+	  tmp.points.push_back( std::make_pair( ids[k], corner(pos,level,k) ) );
+	}
+      for(int f=0;f<2*D;f++)
+	{
+	  int a = f/2, s = f%2;
+	  const ElementInfo& nbh = neighbors.face[f];
+	  if( nbh.node != -1 && nbh.level == level && ! m_tree->isLeaf(nbh.level,nbh.node) )
+	    {
+	      touchingLeaves( nbh.level, nbh.node, withComponent( pos, a, component(pos,a) + (s ? 1 : -1) ), size_t(1)<<a, size_t(s)<<a, f, tmp );
+	    }
+	  else
+	    {
+	      unsigned int plane = component( s ? hi : lo, a );
+	      tmp.rects.push_back( SubFace{ f, withComponent(lo,a,plane), withComponent(hi,a,plane) } );
+	    }
+	}
+      for(int e=0;e<neighbors.nEdges;e++)
+	{
+	  const ElementInfo& nbh = neighbors.edge[e];
+	  if( nbh.node != -1 && nbh.level == level && ! m_tree->isLeaf(nbh.level,nbh.node) )
+	    {
+	      touchingLeaves( nbh.level, nbh.node, edgeNeighborPos( pos, neighbors.edgeDef[e], neighbors.edgeSides[e] ), neighbors.edgeDef[e], neighbors.edgeSides[e], -1, tmp );
+	    }
+	}
+      std::sort( tmp.points.begin(), tmp.points.end(), [](const std::pair<int,Coord>& x, const std::pair<int,Coord>& y) { return x.first < y.first; } );
+      tmp.points.erase( std::unique( tmp.points.begin(), tmp.points.end(), [](const std::pair<int,Coord>& x, const std::pair<int,Coord>& y) { return x.first == y.first; } ), tmp.points.end() );
+
+      if( tmp.rects.size() == 2*D && tmp.points.size() == PointIds::Size )
+	{
+	  rec.push_back( PointIds::Size );
+	  for(int v=0;v<PointIds::Size;v++) rec.push_back( ids[ VtkHexCorner[v] ] );
+	  return;
+	}
+      tmp.faces.clear();
+      for(const auto& r : tmp.rects) appendPolygon( r, tmp );
+      rec.push_back( 1 + tmp.faces.size() );
+      rec.push_back( tmp.rects.size() );
+      rec.insert( rec.end(), tmp.faces.begin(), tmp.faces.end() );
+    }
+
+    // calls f on each point id of a cell record
+    template<typename FuncT>
+    static inline void forEachRecordPoint( int* rec, FuncT f )
+    {
+      if( rec[0] == PointIds::Size )
+	{
+	  for(int i=1;i<=PointIds::Size;i++) f( rec[i] );
+	  return;
+	}
+      int nFaces = rec[1];
+      int* p = rec + 2;
+      for(int i=0;i<nFaces;i++)
+	{
+	  int n = *p++;
+	  for(int j=0;j<n;j++) f( *p++ );
+	}
+    }
+
+  private:
+    // corner k of a hexahedron, for each VTK_HEXAHEDRON vertex
+    static constexpr int VtkHexCorner[8] = { 0, 1, 3, 2, 4, 5, 7, 6 };
+
+    // lowest point of an element : its constrained bits (enumerate() takes the functor by value)
+    struct LowestPoint
+    {
+      inline LowestPoint(size_t& b) : bits(b) {}
+      template<typename Point> inline void operator () ( Point )
+      {
+	if( Point::BITFIELD < bits ) bits = Point::BITFIELD;
+      }
+      size_t& bits;
+    };
+
+    /* face and edge neighbors. A face is 2*axis+side, an edge is given by its two constrained axes (def)
+     * and on which side of them it lies (sides).
+     */
+    struct Neighbors
+    {
+      template<typename M> inline void processComponent(const CubeEnum<ElementInfo,0,M>& c)
+      {
+	using Mask = typename CubeEnum<ElementInfo,0,M>::Mask;
+	if( Mask::N_FREE == D-1 )
+	  {
+	    int axis = 0;
+	    while( (Mask::DEF_BITFIELD >> axis) != 1 ) axis++;
+	    face[ 2*axis + Mask::N_ONES ] = c.value;
+	  }
+	else if( Mask::N_FREE == 1 )
+	  {
+	    size_t lowest = ~size_t(0);
+	    Mask::enumerate( LowestPoint(lowest) );
+	    edge[nEdges] = c.value;
+	    edgeDef[nEdges] = Mask::DEF_BITFIELD;
+	    edgeSides[nEdges] = lowest;
+	    nEdges++;
+	  }
+      }
+      ElementInfo face[2*D];
+      ElementInfo edge[12];
+      size_t edgeDef[12], edgeSides[12];
+      int nEdges = 0;
+    };
+
+    static inline unsigned int component( const Coord& c, int axis )
+    {
+      unsigned int a[D];
+      c.toArray(a);
+      return a[axis];
+    }
+
+    static inline Coord withComponent( const Coord& c, int axis, unsigned int value )
+    {
+      unsigned int a[D];
+      c.toArray(a);
+      a[axis] = value;
+      return Coord(a);
+    }
+
+    // position of the neighbor across an edge : sides gives the side of each constrained axis
+    static inline Coord edgeNeighborPos( const Coord& pos, size_t def, size_t sides )
+    {
+      unsigned int a[D];
+      pos.toArray(a);
+      for(int i=0;i<D;i++)
+	{
+	  if( (def>>i) & 1 ) a[i] = ( (sides>>i) & 1 ) ? a[i]+1 : a[i]-1;
+	}
+      return Coord(a);
+    }
+
+    /* leaves of a refined neighbor touching the cell, with their corners on the cell boundary.
+     * def gives the axes along which the neighbor is next to the cell, sides on which side of the cell it lies.
+     * For a face neighbor (face >= 0), the leaves also split the face.
+     */
+    inline void touchingLeaves( int level, int node, const Coord& pos, size_t def, size_t sides, int face, Scratch& tmp ) const
+    {
+      if( m_tree->isLeaf(level,node) )
+	{
+	  for(int k=0;k<PointIds::Size;k++)
+	    {
+	      if( (k & def) == (~sides & def) ) tmp.points.push_back( std::make_pair( m_pointIds[level][node][k], corner(pos,level,k) ) );
+	    }
+	  if( face >= 0 )
+	    {
+	      int axis = face/2;
+	      Coord lo = pos * m_scale[level];
+	      Coord hi = lo + m_scale[level];
+	      unsigned int plane = component( (face%2) ? lo : hi, axis );
+	      tmp.rects.push_back( SubFace{ face, withComponent(lo,axis,plane), withComponent(hi,axis,plane) } );
+	    }
+	  return;
+	}
+      int index = m_tree->nodeLevels[level].nodes[node].index;
+      Coord childGrid = m_scale[level] / m_scale[level+1];
+      unsigned int grid[D];
+      childGrid.toArray(grid);
+      int nChildren = m_scale[level].reduce_mul() / m_scale[level+1].reduce_mul();
+      for(int k=0;k<nChildren;k++)
+	{
+	  unsigned int c[D];
+	  m_connect->branchCoord[level][k].toArray(c);
+	  bool touching = true;
+	  for(int i=0;i<D && touching;i++)
+	    {
+	      if( (def>>i) & 1 ) touching = ( c[i] == ( ((sides>>i)&1) ? 0 : grid[i]-1 ) );
+	    }
+	  if( touching ) touchingLeaves( level+1, index+k, pos * childGrid + m_connect->branchCoord[level][k], def, sides, face, tmp );
+	}
+    }
+
+    static inline bool onSubFace( const Coord& p, const SubFace& r )
+    {
+      unsigned int c[D], rlo[D], rhi[D];
+      p.toArray(c);
+      r.lo.toArray(rlo);
+      r.hi.toArray(rhi);
+      for(int i=0;i<D;i++)
+	{
+	  if( c[i] < rlo[i] || c[i] > rhi[i] ) return false;
+	}
+      return true;
+    }
+
+    // cell points on the boundary of a sub face, counterclockwise around the face axis, reversed for low side faces
+    inline void appendPolygon( const SubFace& r, Scratch& tmp ) const
+    {
+      int a = r.face/2, s = r.face%2;
+      int u = (a+1)%D, v = (a+2)%D;
+      unsigned int rlo[D], rhi[D];
+      r.lo.toArray(rlo);
+      r.hi.toArray(rhi);
+      unsigned long du = rhi[u] - rlo[u], dv = rhi[v] - rlo[v];
+      tmp.polygon.clear();
+      for(const auto& p : tmp.points)
+	{
+	  unsigned int c[D];
+	  if( ! onSubFace(p.second,r) ) continue;
+	  p.second.toArray(c);
+	  unsigned long pu = c[u] - rlo[u], pv = c[v] - rlo[v];
+	  unsigned long t;
+	  if( pv == 0 && pu < du ) t = pu;
+	  else if( pu == du && pv < dv ) t = du + pv;
+	  else if( pv == dv && pu > 0 ) t = du + dv + (du - pu);
+	  else if( pu == 0 && pv > 0 ) t = 2*du + dv + (dv - pv);
+	  else continue; // inside the sub face
+	  tmp.polygon.push_back( std::make_pair( t, p.first ) );
+	}
+      std::sort( tmp.polygon.begin(), tmp.polygon.end() );
+      tmp.faces.push_back( tmp.polygon.size() );
+      if( s == 1 ) for(auto it=tmp.polygon.begin(); it!=tmp.polygon.end(); ++it) tmp.faces.push_back( it->second );
+      else for(auto it=tmp.polygon.rbegin(); it!=tmp.polygon.rend(); ++it) tmp.faces.push_back( it->second );
+    }
+
+    template<typename FuncT>
+    inline void forEachCellPoint( int c, FuncT f )
+    {
+      forEachRecordPoint( records.data() + cellStart[c], f );
+    }
+
+    const AmrTree* m_tree = 0;
+    const Connect* m_connect = 0;
+    const PointIds* const* m_pointIds = 0;
+    std::vector< std::vector<int> > m_nodeCell;
+    std::vector< std::vector<Coord> > m_nodePos;
+    std::vector<Coord> m_scale;
+    std::vector<Coord> m_pointLattice;
+  };
+
+  template<unsigned int _D> constexpr int AmrUGrid<_D>::VtkHexCorner[8];
+
+}; // Amr2Ugrid
+
+#endif
@@ -4,6 +4,7 @@
 #include "Vec.h"
 #include "PointIds.h"
 #include "GridDimension.h"
+#include "UnionFind.h"
 
 namespace Amr2Ugrid
 {
@@ -13,20 +14,11 @@ namespace Amr2Ugrid
   template<unsigned int DecD, unsigned int IncD=0, typename Point=NullBitField> struct InterLevelPointConnect;
   template<unsigned int D, typename Point> struct InterLevelPointConnect<0,D,Point>
   {
-    static inline void connect( PointIds<D>& parentIds, PointIds<D>* childIds, const hct::Vec<unsigned int,D>& grid, hct::Vec<unsigned int,D> coord)
+    static inline void connect( UnionFind& pointSets, const PointIds<D>& parentIds, const PointIds<D>* childIds, const hct::Vec<unsigned int,D>& grid, hct::Vec<unsigned int,D> coord)
     {
       int point = Point::Reverse::BITFIELD;
       int branch = GridDimension<D>(grid).branch( coord.reverse() );
-      int pid = parentIds[point];
-      int cid = childIds[branch][point];
-      if( pid < cid )
-	{
-	  childIds[branch][point] = pid;
-	}
-      else
-	{
-	  parentIds[point] = cid;
-	}
+      pointSets.unite( parentIds[point], childIds[branch][point] );
     }
   };
   template<unsigned int DecD, unsigned int IncD, typename Point> struct InterLevelPointConnect
@@ -35,17 +27,17 @@ namespace Amr2Ugrid
     using Grid_D = hct::Vec<unsigned int,D>;
     using Grid_IncD = hct::Vec<unsigned int,IncD> ;
 
-    static inline void connect( PointIds<D>& parentIds, PointIds<D>* childIds,
+    static inline void connect( UnionFind& pointSets, const PointIds<D>& parentIds, const PointIds<D>* childIds,
 				const Grid_D& grid, 
 				Grid_IncD gridHead = Grid_IncD() )
     {
       unsigned int gridVal = grid.Vec<unsigned int,DecD>::val;
 
       InterLevelPointConnect< DecD-1, IncD+1, CBitField<Bit0,Point> >
-	::connect( parentIds,childIds,grid, hct::Vec<unsigned int,IncD+1>(0,gridHead) );
+	::connect( pointSets,parentIds,childIds,grid, hct::Vec<unsigned int,IncD+1>(0,gridHead) );
 
       InterLevelPointConnect< DecD-1, IncD+1, CBitField<Bit1,Point> >
-	::connect(parentIds,childIds,grid, hct::Vec<unsigned int,IncD+1>(gridVal-1,gridHead) );
+	::connect( pointSets,parentIds,childIds,grid, hct::Vec<unsigned int,IncD+1>(gridVal-1,gridHead) );
 					  
     }
   };
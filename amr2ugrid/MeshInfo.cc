@@ -38,7 +38,10 @@ int main(int argc, char* argv[])
     {
       ofstream fic;
 
-      mesh.init(indices,geom.points);
+      Vec<float,3> bmin,bmax;
+      Vec<float,3>* centers = new Vec<float,3>[mesh.nCells];
+      AmrCellSize<float,3>* sizes = new AmrCellSize<float,3>[mesh.nCells];
+      geom.computeCellInfo(mesh,indices,centers,sizes,bmin,bmax);
       delete [] indices;
       mesh.toStream(cout);
       geom.toStream(cout);
@@ -60,8 +63,6 @@ int main(int argc, char* argv[])
       geom.toBinaryStream(fic);
       fic.close();
 
-      Vec<float,3> bmin,bmax;
-      geom.computeDomainBounds(mesh,bmin,bmax);
       cout<<"Domain bounds : ("; bmin.toStream(cout); cout<<") - ("; bmax.toStream(cout); cout<<")\n";
       fic.open(boundsFileName.c_str());
       cout<<"-> "<<boundsFileName<<endl;
@@ -69,8 +70,6 @@ int main(int argc, char* argv[])
       fic.write( (char*)&bmax, sizeof(Vec<float,3>) );
       fic.close();
 
-      Vec<float,3>* centers = new Vec<float,3>[mesh.nCells];
-      geom.computeCellCenters(mesh,centers);
 /*       cout<<"Cell centers :\n"; */
 /*       for(int i=0;i<mesh.nCells;i++) */
 /* 	{ */
@@ -83,8 +82,6 @@ int main(int argc, char* argv[])
       fic.close();
       delete [] centers;
       
-      AmrCellSize<float,3>* sizes = new AmrCellSize<float,3>[mesh.nCells];
-      geom.computeCellSizes(mesh,sizes);
 /*       cout<<"Cell sizes :\n"; */
 /*       for(int i=0;i<mesh.nCells;i++) */
 /* 	{ */
@@ -9,6 +9,12 @@
 #include "PointIds.h"
 #include "PathBits.h"
 
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace Amr2Ugrid
 {
 	using namespace hct;
@@ -102,12 +108,22 @@ namespace Amr2Ugrid
 
     int nPoints;
     Vec* points;
+    bool ownsPoints;
 
-    inline MeshGeometry() : nPoints(0), points(0) {}
+    inline MeshGeometry() : nPoints(0), points(0), ownsPoints(true) {}
 
     inline ~MeshGeometry()
     {
-      if( points != 0 ) delete [] points;
+      if( points != 0 && ownsPoints ) delete [] points;
+    }
+
+    // points owned elsewhere (mapped file), only read through this geometry
+    inline void setPointsView(int n, const Vec* p)
+    {
+      if( points != 0 && ownsPoints ) delete [] points;
+      nPoints = n;
+      points = const_cast<Vec*>(p);
+      ownsPoints = false;
     }
 
     template<typename StreamT>
@@ -167,6 +183,101 @@ namespace Amr2Ugrid
 	}
     }
     
+    /*
+     * Fused version of MeshConnectivity::init, computeCellCenters, computeCellSizes and computeDomainBounds :
+     * the points of each cell are gathered once, cells are processed in parallel and bounds are reduced per thread.
+     * Results are bitwise identical to the separate passes (centers are summed in the same orders).
+     */
+    inline void computeCellInfo(MeshConnectivity<D>& meshcon, const PointIds* indices, Vec* centers, CellSize* sizes, Vec& bmin, Vec& bmax) const
+    {
+      computeCellInfo(points, meshcon, indices, centers, sizes, bmin, bmax);
+    }
+
+    // same, for points not owned by a MeshGeometry (mapped file)
+    static inline void computeCellInfo(const Vec* points, MeshConnectivity<D>& meshcon, const PointIds* indices, Vec* centers, CellSize* sizes, Vec& bmin, Vec& bmax)
+    {
+      using Path = typename MeshConnectivity<D>::Path;
+      int nCells = meshcon.nCells;
+      meshcon.pointIds = new PointIds[ nCells ];
+      meshcon.enabled = new bool[ nCells ];
+      if( nCells <= 0 ) return;
+
+      int maxThreads = 1;
+#     ifdef _OPENMP
+      maxThreads = omp_get_max_threads();
+#     endif
+      Vec p0 = points[ indices[0].nodes[0] ];
+      std::vector<Vec> threadMin(maxThreads,p0), threadMax(maxThreads,p0);
+
+#     pragma omp parallel
+      {
+	int thread = 0;
+#       ifdef _OPENMP
+	thread = omp_get_thread_num();
+#       endif
+	Vec tmin = threadMin[thread], tmax = threadMax[thread];
+
+#       pragma omp for schedule(static)
+	for(int i=0;i<nCells;i++)
+	  {
+	    Vec p[PointIds::Size];
+	    for(int j=0 ; j<PointIds::Size ; j++)
+	      {
+		p[j] = points[ indices[i].nodes[j] ];
+	      }
+
+	    // center in input order, as in MeshConnectivity::init, and bounds
+	    Vec center(p[0]), pmin(p[0]), pmax(p[0]);
+	    for(int j=1 ; j<PointIds::Size ; j++)
+	      {
+		center += p[j];
+		pmin = pmin.min(p[j]);
+		pmax = pmax.max(p[j]);
+	      }
+	    center /= PointIds::Size;
+	    sizes[i] = (pmax - pmin);
+	    tmin = tmin.min(pmin);
+	    tmax = tmax.max(pmax);
+
+	    // hypercube vertex ordering
+	    PointIds& ids = meshcon.pointIds[i];
+	    int order[PointIds::Size];
+	    ids = PointIds(-1);
+	    for(int j=0 ; j<PointIds::Size ; j++)
+	      {
+		Path path = ( p[j] > center );
+		unsigned int pi = PathBits<D>::fromPath( path );
+		ids.nodes[ pi ] = indices[i].nodes[j];
+		order[ pi ] = j;
+	      }
+	    meshcon.enabled[i] = ! ids.contains(-1);
+
+	    // center in vertex order, as in computeCellCenters
+	    if( meshcon.enabled[i] )
+	      {
+		center = p[ order[0] ];
+		for(int j=1 ; j<PointIds::Size ; j++)
+		  {
+		    center += p[ order[j] ];
+		  }
+		center /= PointIds::Size;
+	      }
+	    centers[i] = center;
+	  }
+
+	threadMin[thread] = tmin;
+	threadMax[thread] = tmax;
+      }
+
+      bmin = threadMin[0];
+      bmax = threadMax[0];
+      for(int t=1;t<maxThreads;t++)
+	{
+	  bmin = bmin.min(threadMin[t]);
+	  bmax = bmax.max(threadMax[t]);
+	}
+    }
+
     inline void computeDomainBounds(const MeshConnectivity<D>& meshcon, Vec& bmin, Vec& bmax)
     {
       if( meshcon.nCells <= 0 ) return;
@@ -58,18 +58,7 @@ namespace Amr2Ugrid
 #endif
 	  if( ok )
 	    {
-	      // on utilise le > pour ne pas avoir de probleme avec 0
-	      // si 0 != 1, alors on affecte -1 a la place de 0, donc pas d'ambiguite
-	      if( nbhPointId < myPointId ) 
-		{
-		  //std::cout<<myPointId<<" <- "<<nbhPointId<<std::endl;
-		  self.pointIds[level][node][myPoint] = nbhPointId;
-		}
-	      else 
-		{
-		  //std::cout<<nbhPointId<<" <- "<<myPointId<<std::endl;
-		  self.pointIds[nbh.level][nbh.node][nbhPoint] = myPointId;
-		}
+	      self.pointSets.unite( myPointId, nbhPointId );
 	    }
 	}
     }
@@ -23,8 +23,8 @@ namespace Amr2Ugrid
     using PointIds = hct::PointIds<D>;
     using ElementInfo = typename Amr2Ugrid::AmrConnect<D>::ElementInfo;
 
-    inline SidePointCount(AmrSidePoints<D>& s, int l, int n, const ElementInfo& _nbh )
-      : self(s), level(l), node(n), nbh(_nbh) {}
+    inline SidePointCount(AmrSidePoints<D>& s, int l, int n, const ElementInfo& _nbh, bool ins )
+      : self(s), level(l), node(n), nbh(_nbh), insert(ins) {}
     
     // not a functer 'cause it has a type specialization (Point)
     template<typename Point> inline void operator () ( Point )
@@ -45,16 +45,21 @@ namespace Amr2Ugrid
 	      if ( owner )
 		{
 #ifdef DEBUG
-	      		if ( sidePointSet[nbh.level][nbh.node].find(myPointId)!=sidePointSet[nbh.level][nbh.node].end() )
+	      		if ( !insert && sidePointSet[nbh.level][nbh.node].find(myPointId)!=sidePointSet[nbh.level][nbh.node].end() )
 			{
 				std::cout<<'L'<<nbh.level<<".N"<<nbh.node<<".P"<<myPointId<<" ("; Mask::toStream(std::cout);
 				std::cout<<") inserted more than once"<<std::endl;
 			}
-	      		sidePointSet[nbh.level][nbh.node].insert(myPointId);
+	      		if( !insert ) sidePointSet[nbh.level][nbh.node].insert(myPointId);
 #endif
+			// second pass : sidePoints[][] is reset and used as a cursor in the neighbor's list
+			if( insert )
+			  {
+			    self.sidePointArray[ self.sidePointFirst[nbh.level][nbh.node] + self.sidePoints[nbh.level][nbh.node] ] = myPointId;
+			  }
 		  	self.sidePoints[nbh.level][nbh.node] ++;
 #ifdef DEBUG
-			if( self.sidePoints[nbh.level][nbh.node] != sidePointSet[nbh.level][nbh.node].size() )
+			if( !insert && self.sidePoints[nbh.level][nbh.node] != sidePointSet[nbh.level][nbh.node].size() )
 			{
 				std::cout<<'L'<<nbh.level<<".N"<<nbh.node<<".P"<<myPointId<<" ("; Mask::toStream(std::cout);
 				std::cout<<") NS="<<self.sidePoints[nbh.level][nbh.node]<<" != "
@@ -74,6 +79,7 @@ namespace Amr2Ugrid
     AmrSidePoints<D>& self;
     int level, node;
     const ElementInfo& nbh;
+    bool insert;
   };
   
   // operateur applique sur chaque sous-element d'un n-cube
@@ -83,17 +89,18 @@ namespace Amr2Ugrid
     using PointIds = hct::PointIds<D> ;
     using ElementInfo = typename Amr2Ugrid::AmrConnect<D>::ElementInfo ;
 
-    inline CountElementSidePoints(AmrSidePoints<D>& s) : self(s), level(0), node(-1) {}
+    inline CountElementSidePoints(AmrSidePoints<D>& s, bool ins=false) : self(s), level(0), node(-1), insert(ins) {}
     template<typename M> inline void processComponent(const CubeEnum<ElementInfo,0,M>& c)
     {
       if( CubeEnum<ElementInfo,0,M>::Mask::N_FREE > 0 && CubeEnum<ElementInfo,0,M>::Mask::N_FREE < CubeEnum<ElementInfo,0,M>::Mask::N_BITS )
 	{
-	  SidePointCount< D , typename CubeEnum<ElementInfo,0,M>::Mask > sidePointCount(self,level,node,c.value);
+	  SidePointCount< D , typename CubeEnum<ElementInfo,0,M>::Mask > sidePointCount(self,level,node,c.value,insert);
 	  CubeEnum<ElementInfo,0,M>::Mask::enumerate( sidePointCount );
 	}
     }
     AmrSidePoints<D>& self;
     int level,node;
+    bool insert; // fills sidePointArray instead of counting
   };
 
 }; // Amr2Ugrid
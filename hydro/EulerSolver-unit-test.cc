@@ -0,0 +1,72 @@
+#include "EulerSolver.h"
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "ScalarFunction.h"
+#include "TreeRefineImplicitSurface.h"
+
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+using namespace std;
+using namespace hct;
+
+using Tree = HyperCubeTree< 3, SimpleSubdivisionScheme<3> >;
+using Solver = hydro::EulerSolver<Tree>;
+
+// blast wave on an octree refined along a sphere, the blast is centered on the refined surface
+int main()
+{
+  const int nLevels = 5;
+  SimpleSubdivisionScheme<3> octree;
+  for(int i=1;i<nLevels;i++) octree.addLevelSubdivision({ 2,2,2 });
+  Tree tree(octree);
+  tree_refine_implicit_surface( tree, csg_sphere( Vec3d({ 0.5,0.5,0.5 }), 0.3 ), nLevels );
+
+  Solver solver( tree, Vec3d(0.0), Vec3d(1.0) );
+  Vec3d center({ 0.5,0.5,0.8 });
+  double radius = 0.15;
+  solver.initialize( [center,radius](const Vec3d& x)
+    {
+      Solver::Primitive w;
+      w.rho = 1.0;
+      w.p = ( (x-center).length2() < radius*radius ) ? 10.0 : 0.1;
+      return w;
+    } );
+
+  size_t nBlast = 0;
+  for(size_t i=0;i<solver.state().size();i++) if( solver.toPrimitive(solver.state()[i]).p > 1.0 ) ++nBlast;
+  assert( nBlast > 0 );
+  Solver::State initial = solver.total();
+
+  int nSteps = 0;
+  double tFinal = 0.05;
+  while( solver.time() < tFinal )
+    {
+      solver.step( min( solver.computeTimeStep(0.4), tFinal - solver.time() ) );
+      ++nSteps;
+    }
+  Solver::State final = solver.total();
+
+  double rhoMin = numeric_limits<double>::max();
+  for(size_t i=0;i<solver.state().size();i++)
+    {
+      Solver::Primitive w = solver.toPrimitive(solver.state()[i]);
+      assert( w.rho > 0.0 && w.p > 0.0 );
+      rhoMin = min( rhoMin, w.rho );
+    }
+  double massError = abs(final.rho-initial.rho) / initial.rho;
+  double energyError = abs(final.E-initial.E) / initial.E;
+  cout<<tree.getNumberOfLeaves()<<" leaves, "<<nBlast<<" in the blast, "<<nSteps<<" steps"<<endl;
+  cout<<"min density "<<rhoMin<<", mass error "<<massError<<", energy error "<<energyError<<endl;
+
+  // the blast evolves, mass and energy are conserved (walls are reflective)
+  assert( rhoMin < 0.5 );
+  assert( massError < 1e-14 );
+  assert( energyError < 1e-14 );
+  // symmetric blast along x and y : no net momentum along these axes
+  assert( abs(final.mom[0]) < 1e-12 && abs(final.mom[1]) < 1e-12 );
+
+  return 0;
+}
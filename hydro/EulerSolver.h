@@ -0,0 +1,418 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "HyperCubeTreeFaceList.h"
+#include "LeafArray.h"
+#include "Vec.h"
+
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+namespace hydro
+{
+
+	// conservative variables, per unit volume : density, momentum, total energy
+	template<unsigned int _D>
+	struct EulerState
+	{
+		static constexpr unsigned int D = _D;
+
+		double rho = 0.0;
+		double mom[D] = {};
+		double E = 0.0;
+
+		inline EulerState& operator += (const EulerState& s)
+		{
+			rho += s.rho;
+			for (unsigned int i = 0; i < D; i++) { mom[i] += s.mom[i]; }
+			E += s.E;
+			return *this;
+		}
+
+		inline EulerState& operator -= (const EulerState& s)
+		{
+			rho -= s.rho;
+			for (unsigned int i = 0; i < D; i++) { mom[i] -= s.mom[i]; }
+			E -= s.E;
+			return *this;
+		}
+
+		inline EulerState operator * (double a) const
+		{
+			EulerState r;
+			r.rho = rho * a;
+			for (unsigned int i = 0; i < D; i++) { r.mom[i] = mom[i] * a; }
+			r.E = E * a;
+			return r;
+		}
+	};
+
+	// primitive variables : density, velocity, pressure
+	template<unsigned int _D>
+	struct EulerPrimitive
+	{
+		static constexpr unsigned int D = _D;
+
+		double rho = 1.0;
+		double vel[D] = {};
+		double p = 1.0;
+	};
+
+	/*
+	First order finite volume solver for the compressible Euler equations (ideal gas) on the leaves of a tree.
+
+	Conservative variables are a leaf field. Each leaf is a box of the domain given by its tree position.
+	Fluxes are computed with the HLL approximate Riemann solver, time stepping is explicit (forward Euler)
+	with the unsplit CFL condition dt = cfl / max( sum_axis (|u_axis|+c)/dx_axis ). Domain boundaries are reflective walls.
+
+	Faces are extracted once per topology change (updateTopology) into an hct::HyperCubeTreeFaceList :
+	a face between a leaf and a coarser leaf is owned by the finer one, with the finer leaf's area.
+	A coarse leaf thus gets the sum of the fluxes of its finer neighbors, and the scheme stays conservative across levels.
+	Flux sweeps only iterate over this face list, interior faces then boundary faces.
+
+	step(dt) advances all leaves with the same time step. For local time stepping (see LevelScheduler.h), faces are also
+	grouped by the level of their owning leaf : computeLevelFluxes(level, dt) only reads states of leaves of that level
+	or coarser, updateLevel(level) applies them. Time integrated fluxes are accumulated in a per leaf register (m_residual),
+	so that the fluxes of the substeps of finer leaves are applied to their coarse neighbors at the coarse leaf update (refluxing).
+	*/
+	template<typename _Tree>
+	class EulerSolver
+	{
+	public:
+		using Tree = _Tree;
+		static constexpr unsigned int D = Tree::D;
+		using State = EulerState<D>;
+		using Primitive = EulerPrimitive<D>;
+		using VecD = hct::Vec<double, D>;
+		using Cell = hct::HyperCubeTreeCell;
+		using TreeCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+		using FaceList = hct::HyperCubeTreeFaceList<Tree>;
+
+		inline EulerSolver(const Tree& tree, const VecD& origin, const VecD& domainSize, double gamma = 1.4)
+			: m_tree(tree)
+			, m_origin(origin)
+			, m_domainSize(domainSize)
+			, m_gamma(gamma)
+		{
+			m_state.setName("EulerState");
+			updateTopology();
+		}
+
+		// leaf geometry and face list. leaf values are not remapped
+		inline void updateTopology()
+		{
+			m_tree.updateLeafIndex();
+			size_t nLeaves = m_tree.getNumberOfLeaves();
+			m_tree.fitLeafArray(&m_state);
+			m_tree.fitLeafArray(&m_center);
+			m_tree.fitLeafArray(&m_size);
+			m_tree.fitLeafArray(&m_volume);
+			m_tree.parseLeaves([this](const TreeCursor& cursor)
+			{
+				size_t leaf = m_tree.leafIndex(cursor.cell());
+				VecD resolution( cursor.position().m_resolution );
+				VecD size = m_domainSize / resolution;
+				m_size[leaf] = size;
+				m_center[leaf] = m_origin + ( VecD(cursor.position().m_position) + 0.5 ) * size;
+				m_volume[leaf] = size.reduce_mul();
+			}
+			, TreeCursor());
+			m_faces.build(m_tree, m_domainSize);
+			m_flux.resize(m_faces.size());
+			m_residual.assign(nLeaves, State());
+
+			// leaves and faces of each level, a face belongs to the level of its owning (finer) leaf
+			size_t nLevels = m_tree.getNumberOfLevels();
+			m_levelLeaves.assign(nLevels, std::vector<size_t>());
+			m_levelFaces.assign(nLevels, std::vector<size_t>());
+			m_tree.forEachLeaf([this](size_t leaf, Cell cell) { m_levelLeaves[cell.level()].push_back(leaf); });
+			std::vector<size_t> leafLevel(nLeaves);
+			for (size_t l = 0; l < nLevels; l++)
+			{
+				for (size_t leaf : m_levelLeaves[l]) { leafLevel[leaf] = l; }
+			}
+			for (size_t f = 0; f < m_faces.size(); f++)
+			{
+				m_levelFaces[leafLevel[m_faces.left(f)]].push_back(f);
+			}
+		}
+
+		// sets leaf values from a function of the leaf center, returning primitive variables
+		template<typename FuncT>
+		inline void initialize(FuncT f)
+		{
+			size_t nLeaves = m_state.size();
+			for (size_t i = 0; i < nLeaves; i++)
+			{
+				m_state[i] = toConservative(f(m_center[i]));
+			}
+			m_time = 0.0;
+		}
+
+		inline double computeTimeStep(double cfl) const
+		{
+			long nLeaves = static_cast<long>(m_state.size());
+			double maxRate = 0.0;
+#			pragma omp parallel for reduction(max:maxRate)
+			for (long i = 0; i < nLeaves; i++)
+			{
+				maxRate = std::max(maxRate, waveRate(i));
+			}
+			return (maxRate > 0.0) ? cfl / maxRate : std::numeric_limits<double>::max();
+		}
+
+		inline void step(double dt)
+		{
+			// flux sweep, faces are independent. flux goes from left to right
+			const size_t* left = m_faces.leftData();
+			const size_t* right = m_faces.rightData();
+			const uint8_t* axis = m_faces.axisData();
+			const int8_t* orientation = m_faces.orientationData();
+			const double* area = m_faces.areaData();
+			long nInterior = static_cast<long>(m_faces.numberOfInteriorFaces());
+			long nFaces = static_cast<long>(m_faces.size());
+#			pragma omp parallel for schedule(static)
+			for (long f = 0; f < nInterior; f++)
+			{
+				m_flux[f] = hllFlux(m_state[left[f]], m_state[right[f]], axis[f], orientation[f]) * area[f];
+			}
+#			pragma omp parallel for schedule(static)
+			for (long f = nInterior; f < nFaces; f++)
+			{
+				// reflective wall : mirrored normal velocity outside
+				m_flux[f] = hllFlux(m_state[left[f]], reflect(m_state[left[f]], axis[f]), axis[f], orientation[f]) * area[f];
+			}
+
+			// accumulation : a leaf may appear in many faces
+			size_t nLeaves = m_state.size();
+			for (long f = 0; f < nInterior; f++)
+			{
+				m_residual[left[f]] -= m_flux[f];
+				m_residual[right[f]] += m_flux[f];
+			}
+			for (long f = nInterior; f < nFaces; f++)
+			{
+				m_residual[left[f]] -= m_flux[f];
+			}
+
+			long n = static_cast<long>(nLeaves);
+#			pragma omp parallel for schedule(static)
+			for (long i = 0; i < n; i++)
+			{
+				m_state[i] += m_residual[i] * (dt / m_volume[i]);
+				m_residual[i] = State();
+			}
+			m_time += dt;
+		}
+
+		// ======================= local time stepping =========================
+		inline size_t numberOfLeaves(size_t level) const { return m_levelLeaves[level].size(); }
+
+		// CFL time step of the leaves of a level, infinite if there are none
+		inline double computeLevelTimeStep(size_t level, double cfl) const
+		{
+			const std::vector<size_t>& leaves = m_levelLeaves[level];
+			long n = static_cast<long>(leaves.size());
+			double maxRate = 0.0;
+#			pragma omp parallel for reduction(max:maxRate)
+			for (long i = 0; i < n; i++)
+			{
+				maxRate = std::max(maxRate, waveRate(leaves[i]));
+			}
+			return (maxRate > 0.0) ? cfl / maxRate : std::numeric_limits<double>::max();
+		}
+
+		// time integrated fluxes through the faces of a level. may run concurrently with finer levels' substeps
+		inline void computeLevelFluxes(size_t level, double dt)
+		{
+			const size_t* faces = m_levelFaces[level].data(); // pointers, not references : taskloop would copy vectors
+			long n = static_cast<long>(m_levelFaces[level].size());
+#			pragma omp taskloop grainsize(1024)
+			for (long i = 0; i < n; i++)
+			{
+				size_t f = faces[i];
+				m_flux[f] = faceFlux(f) * dt;
+			}
+		}
+
+		// applies the fluxes of a level's faces, and the fluxes registered by finer neighbors, to the leaves of that level
+		inline void updateLevel(size_t level)
+		{
+			const size_t* left = m_faces.leftData();
+			const size_t* right = m_faces.rightData();
+			for (size_t f : m_levelFaces[level])
+			{
+				m_residual[left[f]] -= m_flux[f];
+				if (right[f] != FaceList::NoLeaf) { m_residual[right[f]] += m_flux[f]; }
+			}
+			const size_t* leaves = m_levelLeaves[level].data();
+			long n = static_cast<long>(m_levelLeaves[level].size());
+#			pragma omp taskloop grainsize(1024)
+			for (long i = 0; i < n; i++)
+			{
+				size_t leaf = leaves[i];
+				m_state[leaf] += m_residual[leaf] * (1.0 / m_volume[leaf]);
+				m_residual[leaf] = State();
+			}
+		}
+
+		inline void advanceTime(double dt) { m_time += dt; }
+
+		// integral of conservative variables over the domain
+		inline State total() const
+		{
+			State sum;
+			size_t nLeaves = m_state.size();
+			for (size_t i = 0; i < nLeaves; i++)
+			{
+				sum += m_state[i] * m_volume[i];
+			}
+			return sum;
+		}
+
+		// ======================= ideal gas =========================
+		inline Primitive toPrimitive(const State& u) const
+		{
+			Primitive w;
+			w.rho = u.rho;
+			double kinetic = 0.0;
+			for (unsigned int a = 0; a < D; a++)
+			{
+				w.vel[a] = u.mom[a] / u.rho;
+				kinetic += 0.5 * u.mom[a] * w.vel[a];
+			}
+			w.p = (m_gamma - 1.0) * (u.E - kinetic);
+			return w;
+		}
+
+		inline State toConservative(const Primitive& w) const
+		{
+			State u;
+			u.rho = w.rho;
+			double kinetic = 0.0;
+			for (unsigned int a = 0; a < D; a++)
+			{
+				u.mom[a] = w.rho * w.vel[a];
+				kinetic += 0.5 * w.rho * w.vel[a] * w.vel[a];
+			}
+			u.E = w.p / (m_gamma - 1.0) + kinetic;
+			return u;
+		}
+
+		inline double soundSpeed(const Primitive& w) const
+		{
+			return std::sqrt(m_gamma * std::max(w.p, 0.0) / w.rho);
+		}
+
+		// ======================= accessors =========================
+		inline const Tree& tree() const { return m_tree; }
+		inline double time() const { return m_time; }
+		inline double gamma() const { return m_gamma; }
+		inline size_t numberOfFaces() const { return m_faces.size(); }
+		inline const FaceList& faces() const { return m_faces; }
+		inline hct::LeafArray<State>& state() { return m_state; }
+		inline const hct::LeafArray<State>& state() const { return m_state; }
+		inline const hct::LeafArray<VecD>& center() const { return m_center; }
+		inline const hct::LeafArray<double>& volume() const { return m_volume; }
+
+	private:
+
+		// sum over axes of (|u_axis|+c)/dx_axis
+		inline double waveRate(size_t leaf) const
+		{
+			Primitive w = toPrimitive(m_state[leaf]);
+			double c = soundSpeed(w);
+			double size[D];
+			m_size[leaf].toArray(size);
+			double rate = 0.0;
+			for (unsigned int a = 0; a < D; a++)
+			{
+				rate += (std::abs(w.vel[a]) + c) / size[a];
+			}
+			return rate;
+		}
+
+		// flux through a face, times its area
+		inline State faceFlux(size_t f) const
+		{
+			size_t left = m_faces.left(f);
+			size_t right = m_faces.right(f);
+			const State& ul = m_state[left];
+			State ur = (right != FaceList::NoLeaf) ? m_state[right] : reflect(ul, m_faces.axis(f));
+			return hllFlux(ul, ur, m_faces.axis(f), m_faces.orientation(f)) * m_faces.area(f);
+		}
+
+		// state of a wall's ghost cell : mirrored normal velocity
+		static inline State reflect(State u, unsigned int axis)
+		{
+			u.mom[axis] = -u.mom[axis];
+			return u;
+		}
+
+		// flux through a face of normal sign*axis
+		inline State physicalFlux(const State& u, const Primitive& w, unsigned int axis, double sign) const
+		{
+			double vn = sign * w.vel[axis];
+			State f;
+			f.rho = u.rho * vn;
+			for (unsigned int a = 0; a < D; a++)
+			{
+				f.mom[a] = u.mom[a] * vn;
+			}
+			f.mom[axis] += sign * w.p;
+			f.E = (u.E + w.p) * vn;
+			return f;
+		}
+
+		// HLL flux from ul to ur, through a face of normal sign*axis. wave speeds estimated from both sides (Davis)
+		inline State hllFlux(const State& ul, const State& ur, unsigned int axis, double sign) const
+		{
+			Primitive wl = toPrimitive(ul);
+			Primitive wr = toPrimitive(ur);
+			double cl = soundSpeed(wl);
+			double cr = soundSpeed(wr);
+			double vl = sign * wl.vel[axis];
+			double vr = sign * wr.vel[axis];
+			double sl = std::min(vl - cl, vr - cr);
+			double sr = std::max(vl + cl, vr + cr);
+			State fl = physicalFlux(ul, wl, axis, sign);
+			if (sl >= 0.0) { return fl; }
+			State fr = physicalFlux(ur, wr, axis, sign);
+			if (sr <= 0.0) { return fr; }
+			State jump = ur;
+			jump -= ul;
+			State f = fl * sr;
+			f -= fr * sl;
+			f += jump * (sl * sr);
+			return f * (1.0 / (sr - sl));
+		}
+
+		const Tree& m_tree;
+		VecD m_origin;
+		VecD m_domainSize;
+		double m_gamma;
+		double m_time = 0.0;
+
+		// leaf fields
+		hct::LeafArray<State> m_state;
+		hct::LeafArray<VecD> m_center;
+		hct::LeafArray<VecD> m_size;
+		hct::LeafArray<double> m_volume;
+		std::vector<State> m_residual; // fluxes not yet applied to leaves
+
+		// leaves and faces of each level
+		std::vector< std::vector<size_t> > m_levelLeaves;
+		std::vector< std::vector<size_t> > m_levelFaces;
+
+		// face list, and flux through each face (times its area)
+		FaceList m_faces;
+		std::vector<State> m_flux;
+	};
+
+}
@@ -0,0 +1,116 @@
+#include "EulerSolver.h"
+#include "LevelScheduler.h"
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "ScalarFunction.h"
+#include "TreeRefineImplicitSurface.h"
+
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+using namespace std;
+using namespace hct;
+
+using Tree = HyperCubeTree< 3, SimpleSubdivisionScheme<3> >;
+using Solver = hydro::EulerSolver<Tree>;
+using Scheduler = hydro::LevelScheduler<Solver>;
+
+static const double tFinal = 0.05;
+static const double cfl = 0.4;
+
+// blast centered on the refined surface, so that the wave crosses coarse/fine faces
+static void initBlast(Solver& solver)
+{
+  Vec3d center({ 0.5,0.5,0.8 });
+  double radius = 0.15;
+  solver.initialize( [center,radius](const Vec3d& x)
+    {
+      Solver::Primitive w;
+      w.rho = 1.0;
+      w.p = ( (x-center).length2() < radius*radius ) ? 10.0 : 0.1;
+      return w;
+    } );
+}
+
+static void checkConservation(const Solver& solver, const Solver::State& initial)
+{
+  Solver::State final = solver.total();
+  double massError = abs(final.rho-initial.rho) / initial.rho;
+  double energyError = abs(final.E-initial.E) / initial.E;
+  cout<<"mass error "<<massError<<", energy error "<<energyError<<endl;
+  assert( massError < 1e-14 );
+  assert( energyError < 1e-14 );
+}
+
+// compares local time stepping with global time stepping on a blast wave
+int main()
+{
+  const int nLevels = 5;
+  SimpleSubdivisionScheme<3> octree;
+  for(int i=1;i<nLevels;i++) octree.addLevelSubdivision({ 2,2,2 });
+  Tree tree(octree);
+  tree_refine_implicit_surface( tree, csg_sphere( Vec3d({ 0.5,0.5,0.5 }), 0.3 ), nLevels );
+  size_t nLeaves = tree.getNumberOfLeaves();
+
+  // global time stepping
+  Solver global( tree, Vec3d(0.0), Vec3d(1.0) );
+  initBlast( global );
+  Solver::State initial = global.total();
+  int nSteps = 0;
+  while( global.time() < tFinal )
+    {
+      global.step( min( global.computeTimeStep(cfl), tFinal - global.time() ) );
+      ++nSteps;
+    }
+  cout<<"global: "<<nSteps<<" steps, "<<nSteps*nLeaves<<" leaf updates, ";
+  checkConservation( global, initial );
+
+  // subcycling
+  Solver local( tree, Vec3d(0.0), Vec3d(1.0) );
+  initBlast( local );
+  Scheduler scheduler( local );
+  assert( scheduler.lastLevel() > scheduler.firstLevel() );
+  int nCoarseSteps = 0;
+  while( local.time() < tFinal )
+    {
+      scheduler.advance( min( scheduler.computeTimeStep(cfl), tFinal - local.time() ) );
+      ++nCoarseSteps;
+    }
+  cout<<"subcycle: "<<nCoarseSteps<<" coarse steps, "<<scheduler.numberOfLeafUpdates()<<" leaf updates, ";
+  checkConservation( local, initial );
+  assert( scheduler.numberOfLeafUpdates() < nSteps*nLeaves );
+
+  // the blast evolves, and reaches coarse/fine faces : refluxing is what keeps them conservative
+  const Solver::FaceList& faces = local.faces();
+  size_t nCoarseFine = 0;
+  double rhoMin = numeric_limits<double>::max();
+  for(size_t i=0;i<nLeaves;i++)
+    {
+      Solver::Primitive w = local.toPrimitive(local.state()[i]);
+      assert( w.rho > 0.0 && w.p > 0.0 );
+      rhoMin = min( rhoMin, w.rho );
+    }
+  for(size_t f=0;f<faces.numberOfInteriorFaces();f++)
+    {
+      if( faces.levelDifference(f) == 0 ) continue;
+      double left = local.state()[faces.left(f)].rho, right = local.state()[faces.right(f)].rho;
+      if( abs(left-1.0) > 1e-3 && abs(right-1.0) > 1e-3 ) ++nCoarseFine;
+    }
+  cout<<"min density "<<rhoMin<<", "<<nCoarseFine<<" coarse/fine faces crossed by the blast"<<endl;
+  assert( rhoMin < 0.5 );
+  assert( nCoarseFine > 0 );
+
+  // both solutions are close : L1 density difference, relative to the density perturbation
+  double diff = 0.0, perturbation = 0.0;
+  for(size_t i=0;i<nLeaves;i++)
+    {
+      diff += abs( local.state()[i].rho - global.state()[i].rho ) * local.volume()[i];
+      perturbation += abs( global.state()[i].rho - 1.0 ) * local.volume()[i];
+    }
+  cout<<"relative L1 density difference "<<diff/perturbation<<endl;
+  assert( diff < 0.1*perturbation );
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+
+namespace hydro
+{
+
+	/*
+	Level based local time stepping (subcycling) of a leaf solver.
+
+	Leaves of level l+1 do ratio(l) substeps for one step of level l, ratio(l) being the largest component
+	of the tree's subdivision grid at level l (the cell size ratio along the finest axis).
+	The time step of the coarsest leaf level is the largest one such that each level's substep respects its own CFL condition.
+
+	One step of level l is a small dependency graph, run with OpenMP tasks :
+	- flux(l) : fluxes through the faces owned by level l leaves. It reads states of level l and coarser leaves only,
+	  which finer substeps never modify, so it runs concurrently with the substeps of finer levels
+	- ratio(l) steps of level l+1, in sequence, as one task : each substep waits for its own tasks only,
+	  so flux(l) overlaps all of them
+	- update(l), once both are done : applies flux(l) and the time integrated fluxes registered by finer neighbors
+	  during their substeps (refluxing), so that coarse/fine faces are conservative
+
+	Solver requirements :
+	- tree()
+	- numberOfLeaves(level), computeLevelTimeStep(level, cfl)
+	- computeLevelFluxes(level, dt), updateLevel(level), advanceTime(dt)
+	*/
+	template<typename _Solver>
+	class LevelScheduler
+	{
+	public:
+		using Solver = _Solver;
+
+		inline LevelScheduler(Solver& solver)
+			: m_solver(solver)
+		{
+			updateLevels();
+		}
+
+		// levels holding leaves, after a topology change
+		inline void updateLevels()
+		{
+			const auto& tree = m_solver.tree();
+			size_t nLevels = tree.getNumberOfLevels();
+			m_ratio.assign(nLevels, 1);
+			for (size_t l = 0; (l + 1) < nLevels; l++)
+			{
+				m_ratio[l] = tree.getLevelSubdivisionGrid(l).reduce_max();
+			}
+			m_firstLevel = 0;
+			while ((m_firstLevel + 1) < nLevels && m_solver.numberOfLeaves(m_firstLevel) == 0) { ++m_firstLevel; }
+			m_lastLevel = nLevels - 1;
+			while (m_lastLevel > m_firstLevel && m_solver.numberOfLeaves(m_lastLevel) == 0) { --m_lastLevel; }
+		}
+
+		inline size_t firstLevel() const { return m_firstLevel; }
+		inline size_t lastLevel() const { return m_lastLevel; }
+		inline unsigned int ratio(size_t level) const { return m_ratio[level]; }
+
+		// time step of the coarsest leaf level
+		inline double computeTimeStep(double cfl) const
+		{
+			double dt = std::numeric_limits<double>::max();
+			double substeps = 1.0;
+			for (size_t l = m_firstLevel; l <= m_lastLevel; l++)
+			{
+				double levelDt = m_solver.computeLevelTimeStep(l, cfl);
+				if (levelDt < std::numeric_limits<double>::max()) { dt = std::min(dt, levelDt * substeps); }
+				substeps *= m_ratio[l];
+			}
+			return dt;
+		}
+
+		// one step of the coarsest leaf level
+		inline void advance(double dt)
+		{
+#			pragma omp parallel
+#			pragma omp single
+			advanceLevel(m_firstLevel, dt);
+			m_solver.advanceTime(dt);
+		}
+
+		// leaf updates done so far, a measure of the work saved by subcycling
+		inline size_t numberOfLeafUpdates() const { return m_leafUpdates; }
+
+	private:
+		inline void advanceLevel(size_t level, double dt)
+		{
+#			pragma omp task
+			m_solver.computeLevelFluxes(level, dt);
+			if (level < m_lastLevel)
+			{
+				unsigned int r = m_ratio[level];
+#				pragma omp task
+				for (unsigned int s = 0; s < r; s++) { advanceLevel(level + 1, dt / r); }
+			}
+#			pragma omp taskwait
+			m_solver.updateLevel(level);
+			m_leafUpdates += m_solver.numberOfLeaves(level);
+		}
+
+		Solver& m_solver;
+		std::vector<unsigned int> m_ratio;
+		size_t m_firstLevel = 0;
+		size_t m_lastLevel = 0;
+		size_t m_leafUpdates = 0;
+	};
+
+}
@@ -1,46 +1,189 @@
+#include "AmrLevels.h"
+#include "AmrTree.h"
+#include "AmrHyperCubeTree.h"
+#include "EulerSolver.h"
+#include "LevelScheduler.h"
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "ScalarFunction.h"
+#include "TreeRefineImplicitSurface.h"
+#include "TreeLevelArray.h"
+#include "vtkLegacyExport.h"
+
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
 using namespace std;
-//using namespace hct;
+using namespace hct;
+
+using Tree = Amr2Ugrid::AmrHyperCubeTree<3>::Tree;
+using Solver = hydro::EulerSolver<Tree>;
+
+// blast wave : high pressure sphere, gas at rest
+static Solver::Primitive blast(const Vec3d& x, const Vec3d& center, double radius)
+{
+  Solver::Primitive w;
+  w.rho = 1.0;
+  w.p = ( (x-center).length2() < radius*radius ) ? 10.0 : 0.1;
+  return w;
+}
+
+// blast center : center of the finest leaf closest to the domain center.
+// Leaves near the domain center may be much larger than the blast, their centers would all be outside of it.
+static Vec3d blastCenter(const Tree& tree, const Solver& solver, const Vec3d& domainCenter)
+{
+  size_t finest = 0;
+  tree.forEachLeaf( [&finest](size_t, HyperCubeTreeCell cell) { finest = max<size_t>( finest, cell.level() ); } );
+  Vec3d center = domainCenter;
+  double best = numeric_limits<double>::max();
+  tree.forEachLeaf( [&](size_t leaf, HyperCubeTreeCell cell)
+    {
+      double d = ( solver.center()[leaf] - domainCenter ).length2();
+      if( cell.level() == finest && d < best ) { best = d; center = solver.center()[leaf]; }
+    } );
+  return center;
+}
+
+static double minDensity(const Solver& solver)
+{
+  double rho = numeric_limits<double>::max();
+  for(size_t i=0;i<solver.state().size();i++) rho = min( rho, solver.state()[i].rho );
+  return rho;
+}
 
 int main(int argc, char* argv[])
 {
   // verification du nombre minimal d'arguments
   if( argc<3 )
     {
-      cerr<<"Utilisation: "<<argv[0]<<" fichier.lvl fichier.tree"<<endl;
+      cerr<<"Utilisation: "<<argv[0]<<" fichier.lvl fichier.tree [-t temps_final] [-cfl cfl] [-subcycle] [-vtk fichier.vtk]"<<endl;
+      cerr<<"             "<<argv[0]<<" -sphere nombre_de_niveaux [-t temps_final] [-cfl cfl] [-subcycle] [-vtk fichier.vtk]"<<endl;
       return 1;
     }
-  string levelFileName = argv[1];
-  string treeFileName = argv[2];
+  double tFinal = 0.1;
+  double cfl = 0.4;
+  bool subcycle = false;
+  string vtkFileName;
+  for(int i=3;i<argc;i++)
+    {
+      if( string(argv[i]) == "-t" && (i+1)<argc ) tFinal = atof(argv[++i]);
+      else if( string(argv[i]) == "-cfl" && (i+1)<argc ) cfl = atof(argv[++i]);
+      else if( string(argv[i]) == "-vtk" && (i+1)<argc ) vtkFileName = argv[++i];
+      else if( string(argv[i]) == "-subcycle" ) subcycle = true;
+    }
+
+  TreeLevelArray<double> density; // declared first, so that it outlives the trees it is attached to
+  Amr2Ugrid::AmrHyperCubeTree<3> amrTree;
+  unique_ptr<Tree> sphereTree;
+  Tree* tree = 0;
+  Vec3d domain(1.0);
+
+  if( string(argv[1]) == "-sphere" )
+    {
+      // octree refined along a sphere surface, in the unit cube
+      int nLevels = atoi(argv[2]);
+      SimpleSubdivisionScheme<3> octree;
+      for(int i=1;i<nLevels;i++) octree.addLevelSubdivision({ 2,2,2 });
+      sphereTree.reset( new Tree(octree) );
+      auto sphere = csg_sphere( Vec3d({ 0.5,0.5,0.5 }), 0.3 );
+      tree_refine_implicit_surface( *sphereTree, sphere, nLevels );
+      tree = sphereTree.get();
+    }
+  else
+    {
+      string levelFileName = argv[1];
+      string treeFileName = argv[2];
+
+      cout<<"<- "<<levelFileName<<endl;
+      ifstream fic_grid( levelFileName.c_str() );
+      if( !fic_grid )
+	{
+	  cerr<<"Erreur lecture "<<levelFileName<<endl;
+	  return 1;
+	}
+      Amr2Ugrid::AmrLevels<float,3> levels;
+      levels.fromBinaryStream(fic_grid);
+      fic_grid.close();
+      levels.toStream(cout); cout<<endl;
+
+      cout<<"<- "<<treeFileName<<endl;
+      ifstream fic_tree( treeFileName.c_str() );
+      if( !fic_tree )
+	{
+	  cerr<<"Erreur lecture "<<treeFileName<<endl;
+	  return 1;
+	}
+      Amr2Ugrid::AmrTree legacyTree;
+      legacyTree.fromBinaryStream(fic_tree);
+      fic_tree.close();
+
+      amrTree.fromAmrTree( legacyTree, levels.levelInfo );
+      tree = amrTree.tree.get();
+      domain = Vec3d( levels.levelSize[0] );
+    }
 
-  cout<<"<- "<<levelFileName<<endl;
-  ifstream fic_grid( levelFileName.c_str() );
-  if( !fic_grid )
+  auto T1 = chrono::high_resolution_clock::now();
+  Solver solver( *tree, Vec3d(0.0), domain );
+  auto T2 = chrono::high_resolution_clock::now();
+  cout<<"Feuilles : "<<tree->getNumberOfLeaves()<<", faces : "<<solver.numberOfFaces()
+      <<" ("<<chrono::duration_cast<chrono::microseconds>(T2-T1).count()<<" uSec)"<<endl;
+
+  Vec3d center = blastCenter( *tree, solver, domain * 0.5 );
+  double radius = 0.1 * domain.reduce_max();
+  solver.initialize( [center,radius](const Vec3d& x) { return blast(x,center,radius); } );
+  Solver::State initial = solver.total();
+  size_t blastLeaves = 0;
+  for(size_t i=0;i<solver.state().size();i++) if( ( solver.center()[i] - center ).length2() < radius*radius ) ++blastLeaves;
+  cout<<"Explosion : centre ("; center.toStream(cout); cout<<"), rayon "<<radius<<", "<<blastLeaves<<" feuilles"<<endl;
+
+  // pas de temps local par niveau (sous-cyclage) ou pas de temps global
+  hydro::LevelScheduler<Solver> scheduler( solver );
+  int nSteps = 0;
+  size_t leafUpdates = 0;
+  T1 = chrono::high_resolution_clock::now();
+  while( solver.time() < tFinal )
     {
-      cerr<<"Erreur lecture "<<levelFileName<<endl;
-      return 1;
+      double dt;
+      if( subcycle )
+	{
+	  dt = min( scheduler.computeTimeStep(cfl), tFinal - solver.time() );
+	  scheduler.advance(dt);
+	}
+      else
+	{
+	  dt = min( solver.computeTimeStep(cfl), tFinal - solver.time() );
+	  solver.step(dt);
+	  leafUpdates += tree->getNumberOfLeaves();
+	}
+      ++nSteps;
+      if( nSteps % 50 == 0 ) cout<<"pas "<<nSteps<<" : t="<<solver.time()<<", dt="<<dt<<endl;
     }
-/*
-  AmrLevels<float,3> levels;
-  levels.fromBinaryStream(fic_grid);
-  fic_grid.close();
-  levels.toStream(cout); cout<<endl;
-*/
-
-  cout<<"<- "<<treeFileName<<endl;
-  ifstream fic_tree( treeFileName.c_str() );
-  if( !fic_tree )
+  T2 = chrono::high_resolution_clock::now();
+  if( subcycle ) leafUpdates = scheduler.numberOfLeafUpdates();
+  Solver::State final = solver.total();
+
+  cout<<nSteps<<" pas, t="<<solver.time()<<", "<<leafUpdates<<" mises a jour de feuilles ("<<chrono::duration_cast<chrono::microseconds>(T2-T1).count()<<" uSec)"<<endl;
+  cout<<"Masse : "<<initial.rho<<" -> "<<final.rho<<", ecart relatif "<<abs(final.rho-initial.rho)/initial.rho<<endl;
+  cout<<"Energie : "<<initial.E<<" -> "<<final.E<<", ecart relatif "<<abs(final.E-initial.E)/initial.E<<endl;
+  cout<<"Densite minimale : "<<minDensity(solver)<<endl;
+
+  if( ! vtkFileName.empty() )
     {
-      cerr<<"Erreur lecture "<<treeFileName<<endl;
-      return 1;
+      // leaf density written as a tree field
+      density.setName("density");
+      tree->addArray(&density);
+      tree->forEachLeaf( [&solver,&density](size_t leaf, HyperCubeTreeCell cell) { density[cell] = solver.state()[leaf].rho; } );
+      cout<<"-> "<<vtkFileName<<endl;
+      ofstream fic_vtk( vtkFileName.c_str() );
+      vtk::exportUnstructuredGrid( *tree, fic_vtk );
+      fic_vtk.close();
     }
-/*
-  AmrTree tree;
-  tree.fromBinaryStream(fic_tree);
-  fic_tree.close();
-  tree.toStream(cout); cout<<endl;
-*/
+
   return 0;
 }
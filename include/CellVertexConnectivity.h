@@ -5,6 +5,9 @@
 
 #include <limits>	// numeric_limits
 #include <cstddef>	// size_t
+#include <array>
+#include <vector>
+#include <algorithm>	// copy
 
 namespace hct
 {
@@ -147,6 +150,125 @@ namespace hct
 
 			return nbVertices;
 		}
+
+		/*
+		Hanging vertex constraints, stored as compressed rows :
+		value(m_vertex[i]) = SUM( m_weight[j] * value(m_master[j]) ), for j in [ m_offset[i] , m_offset[i+1] [
+		master vertices are the corners of the coarse neighbor's edge or face (sub n-cube) the hanging vertex lies on,
+		weights are the multilinear interpolation coefficients of the hanging vertex on this edge or face.
+		In a tree that is not 2:1 balanced (see balance), a master vertex may itself be hanging.
+		*/
+		struct HangingVertexConstraints
+		{
+			std::vector<size_t> m_vertex;
+			std::vector<size_t> m_offset = std::vector<size_t>(1, 0);
+			std::vector<size_t> m_master;
+			std::vector<double> m_weight;
+
+			inline size_t size() const { return m_vertex.size(); }
+
+			inline void clear()
+			{
+				m_vertex.clear();
+				m_offset.assign(1, 0);
+				m_master.clear();
+				m_weight.clear();
+			}
+		};
+
+		// vertex ids and hanging vertex constraints
+		static inline size_t compute(const Tree& tree, VertexIdArray& vertexIdArray, HangingVertexConstraints& constraints)
+		{
+			size_t nbVertices = compute(tree, vertexIdArray);
+			computeHangingVertices(tree, vertexIdArray, constraints);
+			return nbVertices;
+		}
+
+		/*
+		A vertex is visited once, by the leaf owning it.
+		It is hanging if it lies inside an edge or a face of a coarser neighbor (it is not one of the neighbor's corners).
+		When several coarser neighbors qualify, the one where it lies on the smallest sub n-cube is used (edge before face),
+		then the coarsest one.
+		*/
+		static inline void computeHangingVertices(const Tree& tree, const VertexIdArray& vertexIdArray, HangingVertexConstraints& constraints)
+		{
+			using VecI = Vec<size_t, D>;
+			constraints.clear();
+			tree.parseLeaves([&vertexIdArray, &constraints](const HCTVertexOwnershipCursor& cursor)
+			{
+				Cell cell = cursor.cell();
+				for (size_t v = 0; v < CellNumberOfVertices; v++)
+				{
+					if (!cursor.ownsVertex(v)) { continue; }
+					auto vertex = cursor.position() + hct::bitfield_vec<D>(v);
+
+					// coarse neighbor touching vertex, with the least free axes
+					const HCubeComponentValue* master = nullptr;
+					size_t masterFreeAxes = D + 1;
+					size_t vp[D], np0[D], np1[D];
+					cursor.m_nbh.forEachValue([cell, &vertex, &master, &masterFreeAxes, &vp, &np0, &np1](const HCubeComponentValue& nbh)
+					{
+						if (!nbh.m_cell.isTreeCell() || nbh.m_cell.level() >= cell.level()) { return; }
+						size_t p[D], n0[D], n1[D];
+						(vertex.m_position * nbh.m_position.m_resolution).toArray(p);
+						(nbh.m_position.m_position * vertex.m_resolution).toArray(n0);
+						((nbh.m_position.m_position + 1) * vertex.m_resolution).toArray(n1);
+						size_t freeAxes = 0;
+						for (unsigned int i = 0; i < D; i++)
+						{
+							if (p[i] < n0[i] || p[i] > n1[i]) { return; } // does not touch vertex
+							if (p[i] > n0[i] && p[i] < n1[i]) { ++freeAxes; }
+						}
+						if (freeAxes == 0) { return; } // vertex is one of its corners
+						if (freeAxes < masterFreeAxes || (freeAxes == masterFreeAxes && nbh.m_cell.level() < master->m_cell.level()))
+						{
+							master = &nbh;
+							masterFreeAxes = freeAxes;
+							std::copy(p, p + D, vp);
+							std::copy(n0, n0 + D, np0);
+							std::copy(n1, n1 + D, np1);
+						}
+					});
+					if (master == nullptr) { continue; }
+
+					// corners of the sub n-cube, interpolation weights
+					size_t vertexId = vertexIdArray[cell][v];
+					assert(vertexId != NotAVertexId);
+					constraints.m_vertex.push_back(vertexId);
+					size_t nCorners = static_cast<size_t>(1) << masterFreeAxes;
+					for (size_t c = 0; c < nCorners; c++)
+					{
+						size_t corner = 0;
+						double weight = 1.0;
+						size_t freeAxis = 0;
+						for (unsigned int i = 0; i < D; i++)
+						{
+							if (vp[i] > np0[i] && vp[i] < np1[i])
+							{
+								double t = static_cast<double>(vp[i] - np0[i]) / static_cast<double>(np1[i] - np0[i]);
+								bool upper = ((c >> freeAxis) & 1) != 0;
+								weight *= upper ? t : (1.0 - t);
+								if (upper) { corner |= static_cast<size_t>(1) << i; }
+								++freeAxis;
+							}
+							else if (vp[i] == np1[i])
+							{
+								corner |= static_cast<size_t>(1) << i;
+							}
+						}
+						size_t masterId = vertexIdArray[master->m_cell][corner];
+						assert(masterId != NotAVertexId);
+						constraints.m_master.push_back(masterId);
+						constraints.m_weight.push_back(weight);
+					}
+					constraints.m_offset.push_back(constraints.m_master.size());
+				}
+			}
+			, HCTVertexOwnershipCursor(tree));
+		}
 	};
+
+	// out of class definition, needed when NotAVertexId is bound to a reference (c++14)
+	template<typename _Tree> constexpr size_t CellVertexConnectivity<_Tree>::NotAVertexId;
 }
 
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include <iostream>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	Point to point message passing between the ranks of a parallel run.
+
+	Messages are byte buffers matched by source and tag. Messages with the same source and tag are received
+	in the order they were sent. send does not wait for the matching recv (backends buffer or drain messages),
+	so exchanges where each rank first sends then receives are deadlock free.
+
+	Backends :
+	- SerialCommunicator : a single rank, messages to self
+	- SocketCommunicator : processes of one machine, connected by local sockets (SocketCommunicator.h)
+	- MpiCommunicator : MPI, when built with HCT_WITH_MPI (MpiCommunicator.h)
+	*/
+	class Communicator
+	{
+	public:
+		virtual ~Communicator() {}
+		virtual int rank() const = 0;
+		virtual int size() const = 0;
+		virtual void send(int dest, int tag, const void* data, size_t bytes) = 0;
+		virtual void recv(int source, int tag, std::vector<char>& data) = 0;
+
+		// each rank sends sendBuffers[r] to rank r, and receives recvBuffers[r] from rank r
+		inline void allToAll(const std::vector< std::vector<char> >& sendBuffers, std::vector< std::vector<char> >& recvBuffers, int tag)
+		{
+			int n = size();
+			int me = rank();
+			assert(static_cast<int>(sendBuffers.size()) == n);
+			recvBuffers.resize(n);
+			for (int r = 0; r < n; r++)
+			{
+				if (r != me) { send(r, tag, sendBuffers[r].data(), sendBuffers[r].size()); }
+			}
+			recvBuffers[me] = sendBuffers[me];
+			for (int r = 0; r < n; r++)
+			{
+				if (r != me) { recv(r, tag, recvBuffers[r]); }
+			}
+		}
+
+		// concatenation of every rank's values, in rank order
+		template<typename T>
+		inline void allGather(const std::vector<T>& values, std::vector<T>& result, int tag)
+		{
+			std::vector<char> bytes(values.size() * sizeof(T));
+			if (!values.empty()) { std::memcpy(bytes.data(), values.data(), bytes.size()); }
+			std::vector< std::vector<char> > recvBuffers;
+			allToAll(std::vector< std::vector<char> >(size(), bytes), recvBuffers, tag);
+			result.clear();
+			for (const auto& b : recvBuffers)
+			{
+				size_t n = b.size() / sizeof(T);
+				result.resize(result.size() + n);
+				if (n > 0) { std::memcpy(&result[result.size() - n], b.data(), b.size()); }
+			}
+		}
+
+		template<typename T>
+		inline T allReduceSum(T value, int tag)
+		{
+			std::vector<T> all;
+			allGather(std::vector<T>(1, value), all, tag);
+			T sum = T();
+			for (const T& x : all) { sum += x; }
+			return sum;
+		}
+
+		inline void barrier(int tag)
+		{
+			std::vector< std::vector<char> > recvBuffers;
+			allToAll(std::vector< std::vector<char> >(size()), recvBuffers, tag);
+		}
+	};
+
+	// received messages not yet matched by a recv, per source
+	class MessageQueue
+	{
+	public:
+		inline void resize(int nSources) { m_messages.resize(nSources); }
+
+		inline void push(int source, int tag, const char* data, size_t bytes)
+		{
+			m_messages[source].push_back(Message{ tag, std::vector<char>(data, data + bytes) });
+		}
+
+		// first message from source with this tag
+		inline bool pop(int source, int tag, std::vector<char>& data)
+		{
+			std::deque<Message>& messages = m_messages[source];
+			for (auto it = messages.begin(); it != messages.end(); ++it)
+			{
+				if (it->m_tag == tag)
+				{
+					data.swap(it->m_data);
+					messages.erase(it);
+					return true;
+				}
+			}
+			return false;
+		}
+
+	private:
+		struct Message
+		{
+			int m_tag;
+			std::vector<char> m_data;
+		};
+		std::vector< std::deque<Message> > m_messages;
+	};
+
+	class SerialCommunicator : public Communicator
+	{
+	public:
+		inline SerialCommunicator() { m_queue.resize(1); }
+
+		inline int rank() const override { return 0; }
+		inline int size() const override { return 1; }
+
+		inline void send(int dest, int tag, const void* data, size_t bytes) override
+		{
+			assert(dest == 0);
+			m_queue.push(dest, tag, static_cast<const char*>(data), bytes);
+		}
+
+		inline void recv(int source, int tag, std::vector<char>& data) override
+		{
+			assert(source == 0);
+			if (!m_queue.pop(source, tag, data))
+			{
+				std::cerr << "SerialCommunicator: no message with tag " << tag << std::endl;
+				std::abort();
+			}
+		}
+
+	private:
+		MessageQueue m_queue;
+	};
+
+}
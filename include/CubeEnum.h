@@ -36,6 +36,12 @@ template <typename _T, typename _Mask> struct CubeEnum<_T, 0, _Mask>
 	{
 		proc.processComponent(*this);
 	}
+
+	template<typename ComponentProcessor>
+	inline void forEachComponent(ComponentProcessor& proc) const
+	{
+		proc.processComponent(*this);
+	}
 };
 
 template <typename _T, unsigned int _D, typename _Mask> struct CubeEnum
@@ -0,0 +1,606 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeCellPosition.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "HyperCubeTreeGhostLayer.h"
+#include "HyperCubeTreePartition.h"
+#include "LeafArray.h"
+#include "TreeLevelArray.h"
+#include "Communicator.h"
+#include "Vec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	A tree distributed over the ranks of a Communicator.
+
+	Each rank holds a local HyperCubeTree made of :
+	- the coarse top of the tree, levels 0 to topLevel, uniformly refined and replicated on all ranks.
+	  Cells of level topLevel are the roots of the distributed subtrees. A root is numbered by its index
+	  at that level, which is also its rank along the tree's space filling curve (leaf order)
+	- the subtrees of the roots it owns, that it refines freely
+	- ghost leaves : the foreign leaves within ghostWidth adjacency steps (face, edge or vertex) of its owned leaves,
+	  as built by HyperCubeTreeGhostLayer, so that neighbor cursors on owned leaves see across rank boundaries.
+	  Ghost roots, the foreign roots holding ghost leaves, are refined down to their ghost leaves only :
+	  their other cells are leaves of the local tree standing for whole foreign subtrees
+	Other foreign roots are plain leaves of the local tree.
+
+	Ghost leaves are found on a local tree holding the topology (refinement flags, no values) of the foreign roots
+	within ghostWidth roots of owned roots, which contains every leaf path of length ghostWidth from an owned leaf.
+	Each rank then requests its ghost leaves from their owners, so sends match receives.
+
+	Fields are TreeLevelArrays of trivially copyable values, registered with addArray. They follow their subtrees
+	when roots migrate, and exchange(array) refreshes ghost leaf values from their owners.
+
+	The local tree is rebuilt by updateGhosts() (to be called after refining owned subtrees, before the next exchange)
+	and by migrate()/rebalance() : cells, cursors and leaf numbering of tree() are invalidated, registered arrays
+	are refitted and keep their values. Arrays added directly to tree() are dropped.
+	Values of top cells, above topLevel, and of foreign cells other than ghost leaves are undefined.
+	*/
+	template<typename _Tree>
+	class DistributedHyperCubeTree
+	{
+	public:
+		using Tree = _Tree;
+		static constexpr unsigned int D = Tree::D;
+		using SubdivisionScheme = typename Tree::SubdivisionSchemeT;
+		using SubdivisionGrid = typename Tree::SubdivisionGrid;
+		using GridLocation = typename Tree::GridLocation;
+		using Cell = HyperCubeTreeCell;
+		using CellPosition = HyperCubeTreeCellPosition<D>;
+		using LocatedCursor = HyperCubeTreeLocatedCursor<Tree>;
+
+		// message tags
+		enum { TagSubtrees = 101, TagValues = 102, TagWeights = 103, TagGhosts = 104 };
+
+		inline DistributedHyperCubeTree(Communicator& comm, const SubdivisionScheme& subdivisions, size_t topLevel, unsigned int ghostWidth = 1)
+			: m_comm(comm)
+			, m_subdivisions(subdivisions)
+			, m_topLevel(topLevel)
+			, m_ghostWidth(ghostWidth)
+		{
+			assert(ghostWidth >= 1);
+			assert(topLevel <= subdivisions.getNumberOfLevelSubdivisions());
+			m_tree.reset(new Tree(m_subdivisions));
+			refineTop(*m_tree);
+
+			m_numberOfRoots = m_tree->getLevelSize(m_topLevel);
+			m_rootPosition.resize(m_numberOfRoots);
+			m_tree->preorderParseCells([this](const LocatedCursor& cursor)
+			{
+				if (cursor.cell().level() == m_topLevel) { m_rootPosition[cursor.cell().index()] = cursor.position(); }
+			}
+			, LocatedCursor());
+			m_rootResolution = m_rootPosition[0].m_resolution;
+			m_rootAt.resize(m_numberOfRoots);
+			for (size_t r = 0; r < m_numberOfRoots; r++) { m_rootAt[linearRootIndex(m_rootPosition[r].m_position)] = r; }
+
+			// contiguous ranges of roots
+			m_owner.resize(m_numberOfRoots);
+			for (size_t r = 0; r < m_numberOfRoots; r++) { m_owner[r] = static_cast<int>((r * m_comm.size()) / m_numberOfRoots); }
+			updateGhosts();
+		}
+
+		inline Communicator& communicator() const { return m_comm; }
+		inline Tree& tree() { return *m_tree; }
+		inline const Tree& tree() const { return *m_tree; }
+
+		// ======================= roots =========================
+		inline size_t topLevel() const { return m_topLevel; }
+		inline size_t numberOfRoots() const { return m_numberOfRoots; }
+		inline Cell rootCell(size_t root) const { return Cell(m_topLevel, root); }
+		inline int owner(size_t root) const { return m_owner[root]; }
+		inline bool isOwned(size_t root) const { return m_owner[root] == m_comm.rank(); }
+		inline const std::vector<size_t>& ghostRoots() const { return m_ghostRoots; }
+		inline unsigned int ghostWidth() const { return m_ghostWidth; }
+
+		// ghost leaves of the local tree, by owner rank then leaf order
+		inline const std::vector<Cell>& ghostLeaves() const { return m_ghostLeaves; }
+
+		// root containing a cell of level topLevel or below
+		inline size_t rootAt(const CellPosition& position) const
+		{
+			return m_rootAt[linearRootIndex(position.m_position / (position.m_resolution / m_rootResolution))];
+		}
+
+		// visits owned leaves, in leaf order
+		template<typename CellFuncT, typename CellCursorT = typename Tree::DefaultTreeCursor>
+		inline void parseOwnedLeaves(CellFuncT f, const CellCursorT& cursor = CellCursorT()) const
+		{
+			if (cursor.cell().level() == m_topLevel)
+			{
+				if (isOwned(cursor.cell().index())) { m_tree->parseLeaves(f, cursor); }
+				return;
+			}
+			SubdivisionGrid grid = m_tree->getLevelSubdivisionGrid(cursor.cell().level());
+			Tree::SubdivisionTraversal::forEachChildLocation(grid, [this, grid, &f, &cursor](GridLocation loc)
+			{
+				parseOwnedLeaves(f, CellCursorT(*m_tree, cursor, grid, loc));
+			});
+		}
+
+		inline size_t numberOfOwnedLeaves() const
+		{
+			size_t n = 0;
+			parseOwnedLeaves([&n](const typename Tree::DefaultTreeCursor&) { ++n; });
+			return n;
+		}
+
+		inline size_t globalNumberOfLeaves() const
+		{
+			return static_cast<size_t>(m_comm.allReduceSum<uint64_t>(numberOfOwnedLeaves(), TagWeights));
+		}
+
+		// ======================= fields =========================
+		template<typename T>
+		inline void addArray(TreeLevelArray<T>* a)
+		{
+			m_tree->addArray(a);
+			m_fields.emplace_back(new Field<T>(a));
+		}
+
+		// ghost leaf values of a, from their owners
+		template<typename T>
+		inline void exchange(TreeLevelArray<T>& a)
+		{
+			Field<T> field(&a);
+			exchangeValues({ &field });
+		}
+
+		// ======================= topology =========================
+
+		// ghost leaves and their values, after a change of owned subtrees
+		inline void updateGhosts()
+		{
+			int me = m_comm.rank();
+			int nRanks = m_comm.size();
+			updateExchangeLists();
+
+			// owned subtrees, and the topology of the foreign roots within reach
+			std::vector< std::vector<char> > sendBuffers(nRanks), recvBuffers;
+			for (int r = 0; r < nRanks; r++)
+			{
+				if (r == me) { continue; }
+				for (size_t root : m_sendRoots[r]) { packSubtree(root, sendBuffers[r], false); }
+			}
+			packOwnedSubtrees(sendBuffers[me]);
+			m_comm.allToAll(sendBuffers, recvBuffers, TagSubtrees);
+			assemble(recvBuffers);
+
+			// ghost layer of owned leaves, in the local tree partitioned by root owners
+			LeafArray<unsigned int> parts;
+			m_tree->fitLeafArray(&parts);
+			m_tree->forEachLeaf([this, &parts](size_t leaf, Cell cell) { parts[leaf] = static_cast<unsigned int>(m_owner[rootOf(cell)]); });
+			HyperCubeTreeGhostLayer<Tree> layer;
+			layer.build(*m_tree, parts, static_cast<unsigned int>(nRanks), m_ghostWidth);
+			LeafArray<char> isGhost;
+			m_tree->fitLeafArray(&isGhost);
+			isGhost.fill(0);
+			for (size_t leaf : layer.ghostLeaves(me)) { isGhost[leaf] = 1; }
+
+			// ghost leaves are requested from their owners by their pre-order rank in their root's subtree,
+			// and the local tree keeps foreign subtrees down to ghost leaves only
+			std::vector< std::vector<char> > requests(nRanks), received;
+			std::vector<char> local, ghostLeafFlags;
+			packOwnedSubtrees(local);
+			m_ghostRoots.clear();
+			for (size_t root : m_nearRoots)
+			{
+				std::vector<Cell> cells;
+				subtreeCells(*m_tree, rootCell(root), cells);
+				for (size_t k = 0; k < cells.size(); k++)
+				{
+					if (!m_tree->isLeaf(cells[k]) || !isGhost[m_tree->leafIndex(cells[k])]) { continue; }
+					appendValue<uint64_t>(requests[m_owner[root]], root);
+					appendValue<uint64_t>(requests[m_owner[root]], k);
+				}
+				std::vector<char> flags;
+				if (!pruneSubtree(*m_tree, rootCell(root), isGhost, flags, ghostLeafFlags)) { continue; }
+				m_ghostRoots.push_back(root);
+				packFlags(root, flags, local);
+			}
+			assemble(std::vector< std::vector<char> >(1, local));
+			m_comm.allToAll(requests, received, TagGhosts);
+
+			// ghost leaves of the new local tree, in request order
+			m_sendCells.assign(nRanks, std::vector<Cell>());
+			m_recvCells.assign(nRanks, std::vector<Cell>());
+			m_ghostLeaves.clear();
+			size_t next = 0;
+			for (size_t root : m_ghostRoots)
+			{
+				std::vector<Cell> cells;
+				subtreeCells(*m_tree, rootCell(root), cells);
+				for (Cell cell : cells)
+				{
+					if (ghostLeafFlags[next++] != 0) { m_recvCells[m_owner[root]].push_back(cell); }
+				}
+			}
+			assert(next == ghostLeafFlags.size());
+			for (int r = 0; r < nRanks; r++) { m_ghostLeaves.insert(m_ghostLeaves.end(), m_recvCells[r].begin(), m_recvCells[r].end()); }
+
+			// owned leaves requested by each rank
+			for (int r = 0; r < nRanks; r++)
+			{
+				if (r == me) { continue; }
+				const char* in = received[r].data();
+				const char* end = in + received[r].size();
+				size_t cached = m_numberOfRoots;
+				std::vector<Cell> cells;
+				while (in < end)
+				{
+					size_t root = static_cast<size_t>(readValue<uint64_t>(in));
+					size_t k = static_cast<size_t>(readValue<uint64_t>(in));
+					assert(isOwned(root));
+					if (root != cached)
+					{
+						cells.clear();
+						subtreeCells(*m_tree, rootCell(root), cells);
+						cached = root;
+					}
+					assert(k < cells.size() && m_tree->isLeaf(cells[k]));
+					m_sendCells[r].push_back(cells[k]);
+				}
+			}
+
+			std::vector<IField*> fields;
+			for (const auto& field : m_fields) { fields.push_back(field.get()); }
+			exchangeValues(fields);
+		}
+
+		// moves roots (with their subtrees and field values) to their new owners. newOwner is the same on all ranks
+		inline void migrate(const std::vector<int>& newOwner)
+		{
+			assert(newOwner.size() == m_numberOfRoots);
+			int me = m_comm.rank();
+			std::vector< std::vector<char> > sendBuffers(m_comm.size()), recvBuffers;
+			for (size_t root = 0; root < m_numberOfRoots; root++)
+			{
+				if (m_owner[root] == me) { packSubtree(root, sendBuffers[newOwner[root]], true); }
+			}
+			m_comm.allToAll(sendBuffers, recvBuffers, TagSubtrees);
+			m_owner = newOwner;
+			assemble(recvBuffers);
+			updateGhosts();
+		}
+
+		/*
+		Moves roots so that each rank owns a contiguous range of roots (along the space filling curve)
+		with a balanced number of leaves. Root weights are gathered on all ranks, and cut by a HyperCubeTreePartition
+		of the replicated top tree, whose leaves are the roots.
+		*/
+		inline void rebalance()
+		{
+			std::vector<uint64_t> owned; // (root, number of leaves) pairs
+			for (size_t root = 0; root < m_numberOfRoots; root++)
+			{
+				if (!isOwned(root)) { continue; }
+				size_t n = 0;
+				m_tree->parseLeaves([&n](const typename Tree::DefaultTreeCursor&) { ++n; }, typename Tree::DefaultTreeCursor(rootCell(root)));
+				owned.push_back(root);
+				owned.push_back(n);
+			}
+			std::vector<uint64_t> all;
+			m_comm.allGather(owned, all, TagWeights);
+
+			Tree top(m_subdivisions);
+			refineTop(top);
+			LeafArray<double> weights;
+			top.fitLeafArray(&weights);
+			for (size_t i = 0; i < all.size(); i += 2) { weights[top.leafIndex(rootCell(all[i]))] = static_cast<double>(all[i + 1]); }
+			HyperCubeTreePartition<Tree> partition;
+			partition.build(top, static_cast<unsigned int>(m_comm.size()), weights);
+			std::vector<int> newOwner(m_numberOfRoots);
+			for (size_t r = 0; r < m_numberOfRoots; r++) { newOwner[r] = static_cast<int>(partition.partOf(top.leafIndex(rootCell(r)))); }
+			migrate(newOwner);
+		}
+
+	private:
+
+		// type erased field, for registered arrays
+		struct IField
+		{
+			virtual ~IField() {}
+			virtual ITreeLevelArray* array() const = 0;
+			virtual void pack(const std::vector<Cell>& cells, std::vector<char>& out) const = 0;
+			virtual void unpack(const std::vector<Cell>& cells, const char*& in) = 0;
+		};
+
+		// ghost leaf values of fields, from their owners
+		inline void exchangeValues(const std::vector<IField*>& fields)
+		{
+			int nRanks = m_comm.size();
+			std::vector< std::vector<char> > sendBuffers(nRanks), recvBuffers;
+			for (int r = 0; r < nRanks; r++)
+			{
+				if (r == m_comm.rank()) { continue; }
+				for (IField* field : fields) { field->pack(m_sendCells[r], sendBuffers[r]); }
+			}
+			m_comm.allToAll(sendBuffers, recvBuffers, TagValues);
+			for (int r = 0; r < nRanks; r++)
+			{
+				if (r == m_comm.rank()) { continue; }
+				const char* in = recvBuffers[r].data();
+				for (IField* field : fields) { field->unpack(m_recvCells[r], in); }
+				assert(in == recvBuffers[r].data() + recvBuffers[r].size());
+			}
+		}
+
+		template<typename T>
+		struct Field : public IField
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "distributed tree fields are copied as bytes");
+
+			inline Field(TreeLevelArray<T>* a) : m_array(a) {}
+
+			inline ITreeLevelArray* array() const override { return m_array; }
+
+			inline void pack(const std::vector<Cell>& cells, std::vector<char>& out) const override
+			{
+				size_t offset = out.size();
+				out.resize(offset + cells.size() * sizeof(T));
+				for (Cell cell : cells)
+				{
+					const T& value = (*m_array)[cell];
+					std::memcpy(&out[offset], &value, sizeof(T));
+					offset += sizeof(T);
+				}
+			}
+
+			inline void unpack(const std::vector<Cell>& cells, const char*& in) override
+			{
+				for (Cell cell : cells)
+				{
+					T& value = (*m_array)[cell];
+					std::memcpy(&value, in, sizeof(T));
+					in += sizeof(T);
+				}
+			}
+
+			TreeLevelArray<T>* m_array;
+		};
+
+		inline size_t linearRootIndex(const Vec<size_t, D>& position) const
+		{
+			size_t p[D], res[D];
+			position.toArray(p);
+			m_rootResolution.toArray(res);
+			size_t index = 0;
+			for (unsigned int a = D; a-- > 0; ) { index = index * res[a] + p[a]; }
+			return index;
+		}
+
+		// roots at most width roots away along each axis, that is within width (face, edge or vertex) adjacency steps
+		template<typename FuncT>
+		inline void forEachRootWithin(size_t root, unsigned int width, FuncT f) const
+		{
+			size_t p[D], res[D];
+			m_rootPosition[root].m_position.toArray(p);
+			m_rootResolution.toArray(res);
+			size_t side = 2 * width + 1;
+			size_t nOffsets = 1;
+			for (unsigned int a = 0; a < D; a++) { nOffsets *= side; }
+			for (size_t k = 0; k < nOffsets; k++)
+			{
+				size_t q[D];
+				bool self = true, inside = true;
+				size_t code = k;
+				for (unsigned int a = 0; a < D; a++)
+				{
+					size_t o = code % side; // o - width along axis a
+					code /= side;
+					self = self && (o == width);
+					inside = inside && (p[a] + o >= width) && (p[a] + o < res[a] + width);
+					q[a] = p[a] + o - width;
+				}
+				if (self || !inside) { continue; }
+				Vec<size_t, D> position;
+				position.fromArray(q);
+				f(m_rootAt[linearRootIndex(position)]);
+			}
+		}
+
+		inline size_t rootOf(Cell cell) const
+		{
+			while (cell.level() > m_topLevel) { cell = m_tree->parent(cell); }
+			return cell.index();
+		}
+
+		inline void refineTop(Tree& tree) const
+		{
+			for (size_t l = 0; l < m_topLevel; l++)
+			{
+				size_t n = tree.getLevelSize(l);
+				for (size_t i = 0; i < n; i++) { tree.refine(Cell(l, i)); }
+			}
+		}
+
+		// foreign roots within ghostWidth roots of this rank's roots, and roots of this rank within ghostWidth roots of each other rank's roots
+		inline void updateExchangeLists()
+		{
+			int me = m_comm.rank();
+			m_nearRoots.clear();
+			m_sendRoots.assign(m_comm.size(), std::vector<size_t>());
+			for (size_t root = 0; root < m_numberOfRoots; root++)
+			{
+				if (m_owner[root] == me)
+				{
+					forEachRootWithin(root, m_ghostWidth, [this, me, root](size_t a)
+					{
+						int o = m_owner[a];
+						if (o != me && (m_sendRoots[o].empty() || m_sendRoots[o].back() != root)) { m_sendRoots[o].push_back(root); }
+					});
+				}
+				else
+				{
+					bool near = false;
+					forEachRootWithin(root, m_ghostWidth, [this, me, &near](size_t a) { near = near || (m_owner[a] == me); });
+					if (near) { m_nearRoots.push_back(root); }
+				}
+			}
+		}
+
+		static inline void subtreeCells(const Tree& tree, Cell cell, std::vector<Cell>& cells)
+		{
+			cells.push_back(cell);
+			if (tree.isLeaf(cell)) { return; }
+			size_t nChildren = tree.getLevelSubdivisionGrid(cell.level()).gridSize();
+			for (size_t i = 0; i < nChildren; i++) { subtreeCells(tree, tree.child(cell, i), cells); }
+		}
+
+		template<typename T>
+		static inline void appendValue(std::vector<char>& out, T value)
+		{
+			size_t offset = out.size();
+			out.resize(offset + sizeof(T));
+			std::memcpy(&out[offset], &value, sizeof(T));
+		}
+
+		template<typename T>
+		static inline T readValue(const char*& in)
+		{
+			T value;
+			std::memcpy(&value, in, sizeof(T));
+			in += sizeof(T);
+			return value;
+		}
+
+		// root, number of cells, values flag, refinement flags in pre-order, then field values in pre-order if flagged
+		inline void packSubtree(size_t root, std::vector<char>& out, bool withValues) const
+		{
+			std::vector<Cell> cells;
+			subtreeCells(*m_tree, rootCell(root), cells);
+			appendValue<uint64_t>(out, root);
+			appendValue<uint64_t>(out, cells.size());
+			out.push_back(withValues ? 1 : 0);
+			for (Cell cell : cells) { out.push_back(m_tree->isLeaf(cell) ? 0 : 1); }
+			if (withValues)
+			{
+				for (const auto& field : m_fields) { field->pack(cells, out); }
+			}
+		}
+
+		// a subtree without values, from its refinement flags
+		static inline void packFlags(size_t root, const std::vector<char>& flags, std::vector<char>& out)
+		{
+			appendValue<uint64_t>(out, root);
+			appendValue<uint64_t>(out, flags.size());
+			out.push_back(0);
+			out.insert(out.end(), flags.begin(), flags.end());
+		}
+
+		inline void packOwnedSubtrees(std::vector<char>& out) const
+		{
+			for (size_t root = 0; root < m_numberOfRoots; root++)
+			{
+				if (isOwned(root)) { packSubtree(root, out, true); }
+			}
+		}
+
+		inline void unpackSubtree(Tree& tree, const char*& in) const
+		{
+			size_t root = static_cast<size_t>(readValue<uint64_t>(in));
+			size_t nCells = static_cast<size_t>(readValue<uint64_t>(in));
+			bool withValues = (*in++ != 0);
+			const char* flags = in;
+			in += nCells;
+			size_t next = 0;
+			graft(tree, rootCell(root), flags, next);
+			assert(next == nCells);
+			if (!withValues) { return; }
+			std::vector<Cell> cells;
+			subtreeCells(tree, rootCell(root), cells);
+			for (const auto& field : m_fields) { field->unpack(cells, in); }
+		}
+
+		/*
+		Appends the pre-order refinement flags of the cells of a subtree that contain ghost leaves, and their children,
+		and whether each is a ghost leaf. Returns false, appending nothing, when there is no ghost leaf below cell.
+		*/
+		static inline bool pruneSubtree(const Tree& tree, Cell cell, const LeafArray<char>& isGhost, std::vector<char>& flags, std::vector<char>& ghostLeaf)
+		{
+			if (tree.isLeaf(cell))
+			{
+				if (!isGhost[tree.leafIndex(cell)]) { return false; }
+				flags.push_back(0);
+				ghostLeaf.push_back(1);
+				return true;
+			}
+			size_t mark = flags.size();
+			size_t ghostMark = ghostLeaf.size();
+			flags.push_back(1);
+			ghostLeaf.push_back(0);
+			bool any = false;
+			size_t nChildren = tree.getLevelSubdivisionGrid(cell.level()).gridSize();
+			for (size_t i = 0; i < nChildren; i++)
+			{
+				if (pruneSubtree(tree, tree.child(cell, i), isGhost, flags, ghostLeaf)) { any = true; continue; }
+				flags.push_back(0);
+				ghostLeaf.push_back(0);
+			}
+			if (!any)
+			{
+				flags.resize(mark);
+				ghostLeaf.resize(ghostMark);
+			}
+			return any;
+		}
+
+		static inline void graft(Tree& tree, Cell cell, const char* flags, size_t& next)
+		{
+			if (flags[next++] == 0) { return; }
+			tree.refine(cell);
+			size_t nChildren = tree.getLevelSubdivisionGrid(cell.level()).gridSize();
+			for (size_t i = 0; i < nChildren; i++) { graft(tree, tree.child(cell, i), flags, next); }
+		}
+
+		// new local tree : replicated top, then packed subtrees
+		inline void assemble(const std::vector< std::vector<char> >& subtrees)
+		{
+			std::unique_ptr<Tree> tree(new Tree(m_subdivisions));
+			for (const auto& field : m_fields) { tree->addArray(field->array()); }
+			refineTop(*tree);
+			for (const auto& buffer : subtrees)
+			{
+				const char* in = buffer.data();
+				const char* end = in + buffer.size();
+				while (in < end) { unpackSubtree(*tree, in); }
+				assert(in == end);
+			}
+			m_tree = std::move(tree);
+		}
+
+		Communicator& m_comm;
+		SubdivisionScheme m_subdivisions;
+		size_t m_topLevel;
+		unsigned int m_ghostWidth;
+		std::unique_ptr<Tree> m_tree;
+		std::vector< std::unique_ptr<IField> > m_fields;
+
+		size_t m_numberOfRoots = 0;
+		Vec<size_t, D> m_rootResolution;
+		std::vector<CellPosition> m_rootPosition;
+		std::vector<size_t> m_rootAt; // root at each position of the top level grid
+		std::vector<int> m_owner;
+
+		std::vector<size_t> m_nearRoots; // foreign roots whose topology is needed to build the ghost layer
+		std::vector<size_t> m_ghostRoots;
+		std::vector<Cell> m_ghostLeaves;
+		std::vector< std::vector<size_t> > m_sendRoots;
+		std::vector< std::vector<Cell> > m_sendCells;
+		std::vector< std::vector<Cell> > m_recvCells;
+	};
+
+}
@@ -23,6 +23,11 @@ namespace hct
 			return pos.val;
 		}
 
+		inline size_t branchHorner(const Vec<unsigned int,1>& pos, size_t acc) const
+		{
+			return acc * this->val + pos.val;
+		}
+
 		inline unsigned int gridSize() const
 		{ 
 			return this->reduce_mul();
@@ -43,10 +48,14 @@ namespace hct
       inline GridDimension(Vec<unsigned int,D> v) : Vec<unsigned int,D>(v) {}
 	  inline GridDimension(const unsigned int* l) : Vec<unsigned int, D>(l) {}
 	  inline GridDimension(unsigned int head, Vec<unsigned int,D-1> tail ) : Vec<unsigned int,D>(head,tail) {}
+	  // Horner scheme, component 0 varies fastest : D-1 multiplications
 	  inline size_t branch(Vec<unsigned int, D> pos) const
 	  {
-		  GridDimension<D - 1> sgrid(*this);
-		  return pos.val * sgrid.gridSize() + sgrid.branch(pos);
+		  return GridDimension<D - 1>(*this).branchHorner(pos, pos.val);
+	  }
+	  inline size_t branchHorner(const Vec<unsigned int, D>& pos, size_t acc) const
+	  {
+		  return GridDimension<D - 1>(*this).branchHorner(pos, acc * this->val + pos.val);
 	  }
       inline unsigned int gridSize() const { return this->reduce_mul(); }
       inline GridDimension& operator = (Vec<unsigned int,D> v) { this->Vec<unsigned int,D>::operator = (v); return *this; }
@@ -45,6 +45,7 @@ namespace hct
 	  inline HyperCube& operator = (const HyperCube& cube)
 	  {
 		  value = cube.value;
+		  return *this;
 	  }
 
 	  inline T& self() { return value; }
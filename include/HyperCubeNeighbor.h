@@ -184,4 +184,76 @@ namespace hct
 	};
 
 
+// ==================================== compile time grid ======================================
+	/* Same digging as HyperCubeNeighbor, for a subdivision grid known at compile time (see StaticGridDim) :
+	grid extents are constants, and the functor gets the grid type instead of a grid value.
+	*/
+	template<typename T, typename GridDim, unsigned int DecD, unsigned int IncD = 0> struct HyperCubeNeighborStatic;
+
+	template<typename T, typename GridDim, unsigned int Dim>
+	struct HyperCubeNeighborStatic<T, GridDim, 0, Dim>
+	{
+		template<typename FuncT, typename M1, typename M2>
+		static inline void rdig(
+			const HyperCube<T, 0, M1>& parent,
+			HyperCube<T, 0, M2> &child,
+			Vec<unsigned int, Dim> inCoord,
+			Vec<unsigned int, Dim> outCoord,
+			FuncT f )
+		{
+			f(parent, child, GridDim(), inCoord, outCoord.reverse());
+		}
+	};
+
+	template<typename T, typename GridDim, unsigned int DecD, unsigned int IncD>
+	struct HyperCubeNeighborStatic
+	{
+		static constexpr unsigned int Dim = DecD + IncD;
+		static constexpr unsigned int GridVal = GridDim::template extent<DecD - 1>();
+		using Next = HyperCubeNeighborStatic<T, GridDim, DecD - 1, IncD + 1>;
+
+		template<typename FuncT, typename M1, typename M2>
+		static inline void
+			rdig(
+				const HyperCube<T, DecD, M1> & parent,
+				HyperCube<T, DecD, M2> & result,
+				Vec<unsigned int, Dim> inCoord,
+				Vec<unsigned int, IncD> outCoord,
+				FuncT f )
+		{
+			unsigned int inCoordVal = inCoord.Vec<unsigned int, DecD>::val;
+
+			if (inCoordVal == 0)
+			{
+				Next::rdig(parent._0, result._0, inCoord, Vec<unsigned int, IncD + 1>(GridVal - 1, outCoord), f);
+			}
+			else
+			{
+				Next::rdig(parent._X, result._0, inCoord, Vec<unsigned int, IncD + 1>(inCoordVal - 1, outCoord), f);
+			}
+
+			Next::rdig(parent._X, result._X, inCoord, Vec<unsigned int, IncD + 1>(inCoordVal, outCoord), f);
+
+			if (inCoordVal == (GridVal - 1))
+			{
+				Next::rdig(parent._1, result._1, inCoord, Vec<unsigned int, IncD + 1>(0, outCoord), f);
+			}
+			else
+			{
+				Next::rdig(parent._X, result._1, inCoord, Vec<unsigned int, IncD + 1>(inCoordVal + 1, outCoord), f);
+			}
+		}
+
+		template<typename FuncT>
+		static inline void dig(
+			const HyperCube<T, Dim>& parent,
+			HyperCube<T, Dim> &result,
+			Vec<unsigned int, Dim> inCoord,
+			FuncT f )
+		{
+			rdig(parent, result, inCoord, Vec<unsigned int, 0>(), f);
+		}
+	};
+
+
 }; // namespace hct
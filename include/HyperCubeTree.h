@@ -1,14 +1,20 @@
 #pragma once
 
 #include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeCellPosition.h"
 #include "HyperCubeTreeCursor.h"
+#include "ITreeRefinementListener.h"
 #include "TreeLevelStorage.h"
+#include "LeafArray.h"
 #include "GridDimension.h"
 #include "Vec.h"
 #include "GridEnum.h"
+#include "SubdivisionSchemeTraversal.h"
 
 #include <cstddef>
 #include <cstdint>
+#include <vector>
+#include <algorithm>
 
 namespace hct
 {
@@ -31,6 +37,9 @@ namespace hct
 		           /     /
 		          |     |
 		Level2 [ -1 -1 -1 -1]
+
+	 m_cell_parent_index holds the index of each cell's parent in the previous level (-1 for the root),
+	 so that a cell's position can be recovered without a traversal.
 	 */
 
 	template<unsigned int _D, typename _SubdivisionSchemeT>
@@ -42,6 +51,7 @@ namespace hct
 		using SubdivisionGrid = GridDimension<D>;
 		using GridLocation = Vec<unsigned int, D>;
 		using DefaultTreeCursor = HyperCubeTreeCursor<HyperCubeTree>;
+		using SubdivisionTraversal = SubdivisionSchemeTraversal<D, SubdivisionSchemeT>;
 
 		inline HyperCubeTree( SubdivisionSchemeT subdiv )
 			: m_subdivision_scheme(subdiv)
@@ -50,8 +60,13 @@ namespace hct
 			m_storage.resize(0, 1);
 			size_t childArrayIndex = m_storage.addArray(&m_cell_child_index);
 			assert(childArrayIndex == 0 ); // we assert this is true when indexing other arrays
+			size_t parentArrayIndex = m_storage.addArray(&m_cell_parent_index);
+			assert(parentArrayIndex == 1);
 			m_cell_child_index.setName( "_ChilIndex" );
 			m_cell_child_index[rootCell()] = -1;
+			m_cell_parent_index.setName( "_ParentIndex" );
+			m_cell_parent_index[rootCell()] = -1;
+			m_leaf_index.setName( "_LeafIndex" );
 		}
 
 		inline const SubdivisionSchemeT& getSubdivisionScheme() const
@@ -74,6 +89,12 @@ namespace hct
 			return m_storage.getNumberOfLevels();
 		}
 
+		// number of cells at a given level
+		inline size_t getLevelSize(size_t level) const
+		{
+			return m_storage.getLevelSize(level);
+		}
+
 		inline size_t addArray(ITreeLevelArray* a)
 		{
 			return m_storage.addArray(a);
@@ -81,7 +102,7 @@ namespace hct
 
 		inline size_t getNumberOfArrays() const
 		{
-			return m_storage.getNumberOfArrays() - 1;
+			return m_storage.getNumberOfArrays() - NumberOfInternalArrays;
 		}
 
 		inline void fitArray(ITreeLevelArray* a) const
@@ -92,7 +113,7 @@ namespace hct
 		inline ITreeLevelArray* array(size_t i) const
 		{
 			assert(i < getNumberOfArrays());
-			return m_storage.array(i + 1);
+			return m_storage.array(i + NumberOfInternalArrays);
 		}
 
 		inline bool checkArraySizes() const
@@ -125,7 +146,38 @@ namespace hct
 			assert( cell.level() < m_subdivision_scheme.getNumberOfLevelSubdivisions() );
 			GridDimension<D> grid = m_subdivision_scheme.getLevelSubdivision(cell.level());
 			assert((childLocation < grid).reduce_and());
-			return child(cell, grid.branch(childLocation));
+			return child(cell, SubdivisionTraversal::branch(grid, childLocation));
+		}
+
+		inline HyperCubeTreeCell parent(HyperCubeTreeCell cell) const
+		{
+			assert(cell.level() > 0);
+			return HyperCubeTreeCell(cell.level() - 1, m_cell_parent_index[cell]);
+		}
+
+		// location of cell in its parent's subdivision grid
+		inline GridLocation childLocation(HyperCubeTreeCell cell) const
+		{
+			HyperCubeTreeCell p = parent(cell);
+			SubdivisionGrid grid = m_subdivision_scheme.getLevelSubdivision(p.level());
+			size_t branch = cell.index() - m_cell_child_index[p];
+			unsigned int g[D], loc[D];
+			grid.toArray(g);
+			for (unsigned int a = 0; a < D; a++)
+			{
+				loc[a] = branch % g[a];
+				branch /= g[a];
+			}
+			return GridLocation(loc);
+		}
+
+		// position of cell, as a located cursor would compute it, from the chain of parents
+		inline HyperCubeTreeCellPosition<D> cellPosition(HyperCubeTreeCell cell) const
+		{
+			if (cell.level() == 0) { return HyperCubeTreeCellPosition<D>(); }
+			HyperCubeTreeCellPosition<D> p = cellPosition(parent(cell));
+			SubdivisionGrid grid = m_subdivision_scheme.getLevelSubdivision(cell.level() - 1);
+			return p.refine(grid) + Vec<size_t, D>(childLocation(cell));
 		}
 
 		inline bool isRefinable(HyperCubeTreeCell cell) const
@@ -133,18 +185,157 @@ namespace hct
 			return isLeaf(cell) && (cell.level()+1) < getNumberOfLevels();
 		}
 
+		// true if all children of cell are leaves
+		inline bool isCoarsenable(HyperCubeTreeCell cell) const
+		{
+			if (isLeaf(cell)) { return false; }
+			size_t nbChildren = SubdivisionTraversal::gridSize(m_subdivision_scheme.getLevelSubdivision(cell.level()));
+			for (size_t i = 0; i < nbChildren; i++)
+			{
+				if (!isLeaf(child(cell, i))) { return false; }
+			}
+			return true;
+		}
+
 		inline void refine(HyperCubeTreeCell cell)
 		{
 			assert(isRefinable(cell));
 			SubdivisionGrid grid = m_subdivision_scheme.getLevelSubdivision(cell.level());
 			size_t childStartIndex = m_storage.getLevelSize(cell.level() + 1);
-			size_t nbChildren = grid.gridSize();
+			size_t nbChildren = SubdivisionTraversal::gridSize(grid);
 			size_t childLevel = cell.level() + 1;
 			m_storage.resize(childLevel, childStartIndex + nbChildren );
 			m_cell_child_index[cell] = childStartIndex;
 			for (size_t i = childStartIndex; i < (childStartIndex + nbChildren); i++)
 			{
 				m_cell_child_index[HyperCubeTreeCell(childLevel, i)] = -1;
+				m_cell_parent_index[HyperCubeTreeCell(childLevel, i)] = cell.index();
+			}
+			m_leaf_index_valid = false;
+			for (auto listener : m_listeners) { listener->cellRefined(cell); }
+		}
+
+		/*
+		 removes the children of cells, which must be coarsenable when their turn comes :
+		 cells are processed from the finest level to the coarsest, so a cell and its parent can be coarsened in the same call.
+		 Removed child blocks leave holes that are closed in one compaction pass per level,
+		 which shifts indices of the remaining cells of that level : the batch form is much cheaper than one call per cell.
+		 */
+		inline void coarsen(const std::vector<HyperCubeTreeCell>& cells)
+		{
+			size_t nLevels = getNumberOfLevels();
+			std::vector< std::vector<size_t> > byLevel(nLevels);
+			for (auto cell : cells) { byLevel[cell.level()].push_back(cell.index()); }
+			for (size_t l = nLevels; l-- > 0;)
+			{
+				if (byLevel[l].empty()) { continue; }
+				std::sort(byLevel[l].begin(), byLevel[l].end());
+				byLevel[l].erase(std::unique(byLevel[l].begin(), byLevel[l].end()), byLevel[l].end());
+				size_t childLevel = l + 1;
+				std::vector<bool> keep(m_storage.getLevelSize(childLevel), true);
+				for (size_t i : byLevel[l])
+				{
+					HyperCubeTreeCell cell(l, i);
+					assert(isCoarsenable(cell));
+					for (auto listener : m_listeners) { listener->cellCoarsening(cell); }
+					size_t nbChildren = SubdivisionTraversal::gridSize(m_subdivision_scheme.getLevelSubdivision(l));
+					size_t first = m_cell_child_index[cell];
+					std::fill(keep.begin() + first, keep.begin() + first + nbChildren, false);
+					m_cell_child_index[cell] = -1;
+				}
+
+				// new index of kept child level cells, then references to them from both sides
+				std::vector<int64_t> newIndex(keep.size(), -1);
+				int64_t n = 0;
+				for (size_t i = 0; i < keep.size(); i++)
+				{
+					if (keep[i]) { newIndex[i] = n++; }
+				}
+				for (auto& c : m_cell_child_index[l])
+				{
+					if (c >= 0) { c = newIndex[c]; }
+				}
+				if ((childLevel + 1) < nLevels)
+				{
+					for (auto& p : m_cell_parent_index[childLevel + 1]) { p = newIndex[p]; }
+				}
+				for (auto listener : m_listeners) { listener->levelRenumbered(childLevel, newIndex); }
+				m_storage.compact(childLevel, keep);
+			}
+			m_leaf_index_valid = false;
+		}
+
+		inline void coarsen(HyperCubeTreeCell cell)
+		{
+			coarsen(std::vector<HyperCubeTreeCell>{ cell });
+		}
+
+		// listeners are notified by refine and coarsen, in the order they were added
+		inline void addRefinementListener(ITreeRefinementListener* listener)
+		{
+			m_listeners.push_back(listener);
+		}
+
+		inline void removeRefinementListener(ITreeRefinementListener* listener)
+		{
+			m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), listener), m_listeners.end());
+		}
+
+		//=================== leaf numbering ================================
+		/*
+		 Leaves are numbered in the order they are visited by parseLeaves.
+		 Numbering is lazily rebuilt on first access after a topology change.
+		 It is not thread safe : call updateLeafIndex() before concurrent accesses.
+		 */
+		inline void updateLeafIndex() const
+		{
+			if (m_leaf_index_valid) { return; }
+			m_storage.fitArray(&m_leaf_index);
+			m_leaf_index.fill(-1);
+			m_leaves.clear();
+			parseLeaves([this](const DefaultTreeCursor& cursor)
+			{
+				m_leaf_index[cursor.cell()] = m_leaves.size();
+				m_leaves.push_back(cursor.cell());
+			});
+			m_leaf_index_valid = true;
+		}
+
+		inline size_t getNumberOfLeaves() const
+		{
+			updateLeafIndex();
+			return m_leaves.size();
+		}
+
+		inline size_t leafIndex(HyperCubeTreeCell cell) const
+		{
+			updateLeafIndex();
+			assert(isLeaf(cell));
+			return m_leaf_index[cell];
+		}
+
+		inline HyperCubeTreeCell leafCell(size_t leaf) const
+		{
+			updateLeafIndex();
+			assert(leaf < m_leaves.size());
+			return m_leaves[leaf];
+		}
+
+		template<typename T>
+		inline void fitLeafArray(LeafArray<T>* a) const
+		{
+			a->resize(getNumberOfLeaves());
+		}
+
+		// visits leaves with their index, without tree traversal
+		template<typename LeafFuncT>
+		inline void forEachLeaf(LeafFuncT f) const
+		{
+			updateLeafIndex();
+			size_t nLeaves = m_leaves.size();
+			for (size_t i = 0; i < nLeaves; i++)
+			{
+				f(i, m_leaves[i]);
 			}
 		}
 
@@ -158,7 +349,7 @@ namespace hct
 			if (!isLeaf(cursor.cell()))
 			{
 				SubdivisionGrid grid = m_subdivision_scheme.getLevelSubdivision(cursor.cell().level());
-				ForEachGridLocation(grid, [this,grid,&f,&cursor](GridLocation loc)
+				SubdivisionTraversal::forEachChildLocation(grid, [this,grid,&f,&cursor](GridLocation loc)
 				{
 						preorderParseCells( f, CellCursorT(*this, cursor, grid, loc) );
 				});
@@ -172,7 +363,7 @@ namespace hct
 			if (!isLeaf(cursor.cell()))
 			{
 				SubdivisionGrid grid = m_subdivision_scheme.getLevelSubdivision(cursor.cell().level());
-				ForEachGridLocation(grid, [this, grid, &f, &cursor](GridLocation loc)
+				SubdivisionTraversal::forEachChildLocation(grid, [this, grid, &f, &cursor](GridLocation loc)
 				{
 					postorderParseCells(f, CellCursorT(*this, cursor, grid, loc));
 				});
@@ -192,7 +383,7 @@ namespace hct
 			else
 			{
 				SubdivisionGrid grid = m_subdivision_scheme.getLevelSubdivision(cursor.cell().level());
-				ForEachGridLocation(grid, [this, grid, &f, &cursor](GridLocation loc)
+				SubdivisionTraversal::forEachChildLocation(grid, [this, grid, &f, &cursor](GridLocation loc)
 				{
 					parseLeaves(f, CellCursorT(*this, cursor, grid, loc));
 				});
@@ -212,9 +403,18 @@ namespace hct
 
 	private:
 
+		static constexpr size_t NumberOfInternalArrays = 2;
+
 		SubdivisionSchemeT m_subdivision_scheme;
 		TreeLevelStorage m_storage;
 		TreeLevelArray<int64_t> m_cell_child_index;
+		TreeLevelArray<int64_t> m_cell_parent_index;
+		std::vector<ITreeRefinementListener*> m_listeners;
+
+		// leaf numbering cache
+		mutable TreeLevelArray<int64_t> m_leaf_index;
+		mutable std::vector<HyperCubeTreeCell> m_leaves;
+		mutable bool m_leaf_index_valid = false;
 	};
 
 }
@@ -50,6 +50,18 @@ namespace hct
 			return HyperCubeTreeCellPosition{ m_position*2 + 1 , m_resolution*2 };
 		}
 
+		// signed distance from this cell's center to the center of cell b along an axis, in units of this cell's size
+		inline double centerDistance(const HyperCubeTreeCellPosition& b, unsigned int axis) const
+		{
+			size_t pa[D], ra[D], pb[D], rb[D];
+			m_position.toArray(pa);
+			m_resolution.toArray(ra);
+			b.m_position.toArray(pb);
+			b.m_resolution.toArray(rb);
+			double cb = (pb[axis] + 0.5) * static_cast<double>(ra[axis]) / static_cast<double>(rb[axis]);
+			return cb - (pa[axis] + 0.5);
+		}
+
 		inline bool boundary() const
 		{
 			return (m_position == VecI(0)).reduce_or() || (m_position == m_resolution).reduce_or();
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "TreeLevelArray.h"
+#include "ScalarFunction.h"
+#include "MonotonicArena.h"
+#include "Vec.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	Owns a tree, its fields and the functions used to build them.
+	All these objects live in a single monotonic arena and are released in one shot
+	when the context is destroyed. A context can be moved, but not copied.
+	Pointers and references to the tree, fields and functions stay valid until the context dies.
+	*/
+	template<unsigned int _D, typename _T = double>
+	class HyperCubeTreeContext
+	{
+	public:
+		static constexpr unsigned int D = _D;
+		using T = _T;
+		using SubdivisionScheme = SimpleSubdivisionScheme<D>;
+		using Tree = HyperCubeTree<D, SubdivisionScheme>;
+		using ScalarField = TreeLevelArray<T>;
+		using VectorField = TreeLevelArray< Vec<T, D> >;
+		using Function = ScalarFunctionDelegate<D, T>;
+
+		inline HyperCubeTreeContext() {}
+		HyperCubeTreeContext(const HyperCubeTreeContext&) = delete;
+		HyperCubeTreeContext& operator = (const HyperCubeTreeContext&) = delete;
+
+		inline HyperCubeTreeContext(HyperCubeTreeContext&& other)
+			: m_arena(std::move(other.m_arena))
+			, m_tree(other.m_tree)
+			, m_scalars(std::move(other.m_scalars))
+			, m_vectors(std::move(other.m_vectors))
+		{
+			other.m_tree = nullptr;
+			other.m_scalars.clear();
+			other.m_vectors.clear();
+		}
+
+		inline HyperCubeTreeContext& operator = (HyperCubeTreeContext&& other)
+		{
+			if (this != &other)
+			{
+				m_arena = std::move(other.m_arena);
+				m_tree = other.m_tree;
+				m_scalars = std::move(other.m_scalars);
+				m_vectors = std::move(other.m_vectors);
+				other.m_tree = nullptr;
+				other.m_scalars.clear();
+				other.m_vectors.clear();
+			}
+			return *this;
+		}
+
+		inline Tree& createTree(const SubdivisionScheme& subdivisions)
+		{
+			assert(m_tree == nullptr);
+			m_tree = m_arena.template create<Tree>(subdivisions);
+			return *m_tree;
+		}
+
+		inline bool hasTree() const { return m_tree != nullptr; }
+		inline Tree& tree() { assert(m_tree != nullptr); return *m_tree; }
+		inline const Tree& tree() const { assert(m_tree != nullptr); return *m_tree; }
+
+		// creates a field and attaches it to the tree
+		inline ScalarField& addScalarField(const std::string& name)
+		{
+			ScalarField* field = m_arena.template create<ScalarField>();
+			field->setName(name);
+			tree().addArray(field);
+			m_scalars.push_back(field);
+			return *field;
+		}
+
+		inline VectorField& addVectorField(const std::string& name)
+		{
+			VectorField* field = m_arena.template create<VectorField>();
+			field->setName(name);
+			tree().addArray(field);
+			m_vectors.push_back(field);
+			return *field;
+		}
+
+		inline const std::vector<ScalarField*>& scalars() const { return m_scalars; }
+		inline const std::vector<VectorField*>& vectors() const { return m_vectors; }
+
+		inline ScalarField* findScalarField(const std::string& name) const
+		{
+			for (ScalarField* f : m_scalars) { if (f->name() == name) return f; }
+			return nullptr;
+		}
+
+		inline VectorField* findVectorField(const std::string& name) const
+		{
+			for (VectorField* f : m_vectors) { if (f->name() == name) return f; }
+			return nullptr;
+		}
+
+		// functions built in the context's arena
+		inline MonotonicArena& arena() { return m_arena; }
+
+		inline size_t allocatedBytes() const { return m_arena.allocatedBytes(); }
+
+	private:
+		MonotonicArena m_arena;
+		Tree* m_tree = nullptr;
+		std::vector<ScalarField*> m_scalars;
+		std::vector<VectorField*> m_vectors;
+	};
+
+}
@@ -22,7 +22,7 @@ namespace hct
 			: m_cell(cell) {}
 
 		inline HyperCubeTreeCursor(const Tree& tree, HyperCubeTreeCursor parent, SubdivisionGrid grid, GridLocation childLocation)
-			: m_cell(tree.child(parent.cell(), grid.branch(childLocation))) {}
+			: m_cell(tree.child(parent.cell(), Tree::SubdivisionTraversal::branch(grid, childLocation))) {}
 		
 		inline HyperCubeTreeCell cell() const { return m_cell; }
 		
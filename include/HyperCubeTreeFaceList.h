@@ -0,0 +1,174 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeNeighborCursor.h"
+#include "Vec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	Flat list of the (D-1)-dimensional faces between leaves, and between leaves and the domain boundary.
+
+	Each face is listed once, by the leaf owning it : the finer leaf at a coarse/fine interface,
+	the leaf on the low side between two leaves of the same level, the inner leaf on the domain boundary.
+	A coarse leaf thus has one face per fine neighbor leaf, and the sum of their areas is its face area.
+	- left : owning leaf, right : neighbor leaf (NoLeaf outside the domain)
+	- axis : normal axis, orientation : +1 if right lies on the +axis side of left, -1 otherwise
+	- levelDifference : level(left) - level(right), 0 for boundary faces
+	- area : area of the owning leaf's face, in a domain of the given size
+
+	Faces are stored as a structure of arrays, in leaf order, interior faces first then boundary faces,
+	so that flux kernels run over contiguous arrays without testing for the domain boundary.
+	The list is built by one neighbor cursor traversal, and has to be rebuilt after each topology change.
+	*/
+	template<typename _Tree>
+	class HyperCubeTreeFaceList
+	{
+	public:
+		using Tree = _Tree;
+		static constexpr unsigned int D = Tree::D;
+		using VecD = Vec<double, D>;
+		using NbhCursor = HyperCubeTreeNeighborCursor<Tree>;
+		using HCubeComponentValue = typename NbhCursor::HCubeComponentValue;
+
+		static constexpr size_t NoLeaf = std::numeric_limits<size_t>::max();
+
+		inline void build(const Tree& tree, const VecD& domainSize = VecD(1.0))
+		{
+			clear();
+			tree.updateLeafIndex();
+			Faces boundary;
+			tree.parseLeaves([this, &tree, &boundary, domainSize](const NbhCursor& cursor)
+			{
+				VecD size = domainSize / VecD(cursor.position().m_resolution);
+				cursor.m_nbh.forEachComponent(FaceCollector(tree, cursor.cell(), size, m_faces, boundary));
+			}
+			, NbhCursor());
+			m_numberOfInteriorFaces = m_faces.size();
+			m_faces.append(boundary);
+		}
+
+		inline void clear()
+		{
+			m_faces.clear();
+			m_numberOfInteriorFaces = 0;
+		}
+
+		inline size_t size() const { return m_faces.m_left.size(); }
+		inline size_t numberOfInteriorFaces() const { return m_numberOfInteriorFaces; }
+		inline size_t numberOfBoundaryFaces() const { return size() - m_numberOfInteriorFaces; }
+
+		inline size_t left(size_t f) const { return m_faces.m_left[f]; }
+		inline size_t right(size_t f) const { return m_faces.m_right[f]; }
+		inline unsigned int axis(size_t f) const { return m_faces.m_axis[f]; }
+		inline int orientation(size_t f) const { return m_faces.m_orientation[f]; }
+		inline unsigned int levelDifference(size_t f) const { return m_faces.m_levelDifference[f]; }
+		inline double area(size_t f) const { return m_faces.m_area[f]; }
+
+		// flat arrays, for vectorized kernels
+		inline const size_t* leftData() const { return m_faces.m_left.data(); }
+		inline const size_t* rightData() const { return m_faces.m_right.data(); }
+		inline const uint8_t* axisData() const { return m_faces.m_axis.data(); }
+		inline const int8_t* orientationData() const { return m_faces.m_orientation.data(); }
+		inline const uint8_t* levelDifferenceData() const { return m_faces.m_levelDifference.data(); }
+		inline const double* areaData() const { return m_faces.m_area.data(); }
+
+	private:
+
+		struct Faces
+		{
+			inline void clear()
+			{
+				m_left.clear();
+				m_right.clear();
+				m_axis.clear();
+				m_orientation.clear();
+				m_levelDifference.clear();
+				m_area.clear();
+			}
+
+			inline size_t size() const { return m_left.size(); }
+
+			inline void push_back(size_t left, size_t right, unsigned int axis, int orientation, unsigned int levelDifference, double area)
+			{
+				m_left.push_back(left);
+				m_right.push_back(right);
+				m_axis.push_back(static_cast<uint8_t>(axis));
+				m_orientation.push_back(static_cast<int8_t>(orientation));
+				m_levelDifference.push_back(static_cast<uint8_t>(levelDifference));
+				m_area.push_back(area);
+			}
+
+			inline void append(const Faces& f)
+			{
+				m_left.insert(m_left.end(), f.m_left.begin(), f.m_left.end());
+				m_right.insert(m_right.end(), f.m_right.begin(), f.m_right.end());
+				m_axis.insert(m_axis.end(), f.m_axis.begin(), f.m_axis.end());
+				m_orientation.insert(m_orientation.end(), f.m_orientation.begin(), f.m_orientation.end());
+				m_levelDifference.insert(m_levelDifference.end(), f.m_levelDifference.begin(), f.m_levelDifference.end());
+				m_area.insert(m_area.end(), f.m_area.begin(), f.m_area.end());
+			}
+
+			std::vector<size_t> m_left;
+			std::vector<size_t> m_right;
+			std::vector<uint8_t> m_axis;
+			std::vector<int8_t> m_orientation;
+			std::vector<uint8_t> m_levelDifference;
+			std::vector<double> m_area;
+		};
+
+		// neighborhood component functor, applied on the neighborhood of a leaf
+		struct FaceCollector
+		{
+			inline FaceCollector(const Tree& tree, HyperCubeTreeCell cell, const VecD& size, Faces& interior, Faces& boundary)
+				: m_tree(tree), m_cell(cell), m_size(size), m_interior(interior), m_boundary(boundary) {}
+
+			template<typename HCubeComp>
+			inline void operator () (const HCubeComponentValue& nbh, HCubeComp)
+			{
+				if (!NbhCursor::isFace(HCubeComp())) { return; }
+				unsigned int axis = NbhCursor::faceAxis(HCubeComp());
+				int orientation = (NbhCursor::faceSide(HCubeComp()) == 1) ? 1 : -1;
+
+				double size[D];
+				m_size.toArray(size);
+				double area = 1.0;
+				for (unsigned int i = 0; i < D; i++)
+				{
+					if (i != axis) { area *= size[i]; }
+				}
+
+				size_t leaf = m_tree.leafIndex(m_cell);
+				if (!nbh.m_cell.isTreeCell())
+				{
+					m_boundary.push_back(leaf, NoLeaf, axis, orientation, 0, area);
+					return;
+				}
+				if (!m_tree.isLeaf(nbh.m_cell)) { return; } // owned by the finer leaves
+				size_t level = m_cell.level();
+				size_t nbhLevel = nbh.m_cell.level();
+				assert(nbhLevel <= level);
+				if (nbhLevel == level && orientation < 0) { return; } // owned by the low side leaf
+				m_interior.push_back(leaf, m_tree.leafIndex(nbh.m_cell), axis, orientation, level - nbhLevel, area);
+			}
+
+			const Tree& m_tree;
+			HyperCubeTreeCell m_cell;
+			VecD m_size;
+			Faces& m_interior;
+			Faces& m_boundary;
+		};
+
+		Faces m_faces;
+		size_t m_numberOfInteriorFaces = 0;
+	};
+
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeNeighborCursor.h"
+#include "LeafArray.h"
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	Ghost layers (halos) of a leaf partition.
+
+	Given a partition number for each leaf, the ghost leaves of a partition are the foreign leaves
+	within 'width' adjacency steps of its own leaves. Two leaves are adjacent when they share a face, an edge
+	or a vertex, as enumerated by the neighbor cursor's hypercube : a leaf sees its same level or coarser
+	neighbors, finer neighbors see it, so the adjacency graph is symmetrized once at build time.
+
+	For each partition p :
+	- ownedLeaves(p) : its leaves, in leaf order
+	- ghostLeaves(p) : its ghost leaves, sorted by owning partition then leaf index, and ghostDistance(p),
+	  the adjacency distance (1..width) of each ghost leaf to the partition
+	- receives(p) : one Exchange per neighbor partition q, the ghost leaves of p owned by q. They are a contiguous
+	  range of ghostLeaves(p), starting at m_offset
+	- sends(p) : one Exchange per neighbor partition q, the leaves of p that are ghosts of q, in the order q receives them
+	Exchanges are sorted by partition number, so that matching sends and receives are posted in the same order.
+	*/
+	template<typename _Tree>
+	class HyperCubeTreeGhostLayer
+	{
+	public:
+		using Tree = _Tree;
+		static constexpr unsigned int D = Tree::D;
+		using NbhCursor = HyperCubeTreeNeighborCursor<Tree>;
+		using HCubeComponentValue = typename NbhCursor::HCubeComponentValue;
+
+		struct Exchange
+		{
+			unsigned int m_partition; // other partition
+			size_t m_offset;          // first ghost leaf, for receives
+			std::vector<size_t> m_leaves;
+		};
+
+		inline void build(const Tree& tree, const LeafArray<unsigned int>& partition, unsigned int nPartitions, unsigned int width = 1)
+		{
+			size_t nLeaves = tree.getNumberOfLeaves();
+			assert(partition.size() == nLeaves);
+			m_width = width;
+			buildAdjacency(tree);
+
+			m_owned.assign(nPartitions, std::vector<size_t>());
+			for (size_t i = 0; i < nLeaves; i++)
+			{
+				assert(partition[i] < nPartitions);
+				m_owned[partition[i]].push_back(i);
+			}
+
+			m_ghosts.assign(nPartitions, std::vector<size_t>());
+			m_ghostDistance.assign(nPartitions, std::vector<unsigned int>());
+			long nParts = static_cast<long>(nPartitions);
+#			pragma omp parallel
+			{
+				// distance of each leaf to the current partition, valid where stamp is p+1
+				std::vector<unsigned int> stamp(nLeaves, 0);
+				std::vector<unsigned int> distance(nLeaves, 0);
+				std::vector<size_t> frontier, next;
+#				pragma omp for schedule(dynamic)
+				for (long lp = 0; lp < nParts; lp++)
+				{
+					unsigned int p = static_cast<unsigned int>(lp);
+					frontier.clear();
+					for (size_t leaf : m_owned[p])
+					{
+						stamp[leaf] = p + 1;
+						distance[leaf] = 0;
+						frontier.push_back(leaf);
+					}
+					std::vector<size_t>& ghosts = m_ghosts[p];
+					for (unsigned int d = 1; d <= width && !frontier.empty(); d++)
+					{
+						next.clear();
+						for (size_t leaf : frontier)
+						{
+							for (size_t j = m_adjacencyOffset[leaf]; j < m_adjacencyOffset[leaf + 1]; j++)
+							{
+								size_t nbh = m_adjacency[j];
+								if (stamp[nbh] == p + 1) { continue; }
+								stamp[nbh] = p + 1;
+								distance[nbh] = d;
+								next.push_back(nbh);
+								ghosts.push_back(nbh);
+							}
+						}
+						frontier.swap(next);
+					}
+					std::sort(ghosts.begin(), ghosts.end(), [&partition](size_t a, size_t b)
+					{
+						return (partition[a] != partition[b]) ? (partition[a] < partition[b]) : (a < b);
+					});
+					m_ghostDistance[p].resize(ghosts.size());
+					for (size_t i = 0; i < ghosts.size(); i++)
+					{
+						m_ghostDistance[p][i] = distance[ghosts[i]];
+					}
+				}
+			}
+
+			// receives are ranges of ghost leaves, sends are the matching receives seen from the owner
+			m_receives.assign(nPartitions, std::vector<Exchange>());
+			m_sends.assign(nPartitions, std::vector<Exchange>());
+			for (unsigned int p = 0; p < nPartitions; p++)
+			{
+				const std::vector<size_t>& ghosts = m_ghosts[p];
+				for (size_t i = 0; i < ghosts.size(); i++)
+				{
+					unsigned int q = partition[ghosts[i]];
+					if (m_receives[p].empty() || m_receives[p].back().m_partition != q)
+					{
+						m_receives[p].push_back(Exchange{ q, i, std::vector<size_t>() });
+					}
+					m_receives[p].back().m_leaves.push_back(ghosts[i]);
+				}
+				for (const Exchange& r : m_receives[p])
+				{
+					m_sends[r.m_partition].push_back(Exchange{ p, 0, r.m_leaves });
+				}
+			}
+		}
+
+		inline unsigned int numberOfPartitions() const { return static_cast<unsigned int>(m_owned.size()); }
+		inline unsigned int width() const { return m_width; }
+
+		inline const std::vector<size_t>& ownedLeaves(unsigned int p) const { return m_owned[p]; }
+		inline const std::vector<size_t>& ghostLeaves(unsigned int p) const { return m_ghosts[p]; }
+		inline const std::vector<unsigned int>& ghostDistance(unsigned int p) const { return m_ghostDistance[p]; }
+		inline const std::vector<Exchange>& receives(unsigned int p) const { return m_receives[p]; }
+		inline const std::vector<Exchange>& sends(unsigned int p) const { return m_sends[p]; }
+
+		// leaves sharing a face, an edge or a vertex with leaf
+		inline const size_t* adjacentLeavesBegin(size_t leaf) const { return m_adjacency.data() + m_adjacencyOffset[leaf]; }
+		inline const size_t* adjacentLeavesEnd(size_t leaf) const { return m_adjacency.data() + m_adjacencyOffset[leaf + 1]; }
+
+	private:
+
+		// symmetric leaf adjacency, in compressed rows
+		inline void buildAdjacency(const Tree& tree)
+		{
+			size_t nLeaves = tree.getNumberOfLeaves();
+			std::vector<size_t> pairs; // (leaf, neighbor leaf) pairs, both ways
+			tree.parseLeaves([&tree, &pairs](const NbhCursor& cursor)
+			{
+				size_t leaf = tree.leafIndex(cursor.cell());
+				cursor.m_nbh.forEachValue([&tree, &pairs, &cursor, leaf](const HCubeComponentValue& nbh)
+				{
+					if (!nbh.m_cell.isTreeCell() || nbh.m_cell == cursor.cell() || !tree.isLeaf(nbh.m_cell)) { return; }
+					size_t other = tree.leafIndex(nbh.m_cell);
+					pairs.push_back(leaf);
+					pairs.push_back(other);
+					pairs.push_back(other);
+					pairs.push_back(leaf);
+				});
+			}
+			, NbhCursor());
+
+			size_t nPairs = pairs.size() / 2;
+			m_adjacencyOffset.assign(nLeaves + 1, 0);
+			for (size_t i = 0; i < nPairs; i++) { ++m_adjacencyOffset[pairs[2 * i] + 1]; }
+			for (size_t i = 0; i < nLeaves; i++) { m_adjacencyOffset[i + 1] += m_adjacencyOffset[i]; }
+			m_adjacency.resize(nPairs);
+			std::vector<size_t> fill(m_adjacencyOffset.begin(), m_adjacencyOffset.end() - 1);
+			for (size_t i = 0; i < nPairs; i++) { m_adjacency[fill[pairs[2 * i]]++] = pairs[2 * i + 1]; }
+
+			// a coarse neighbor is seen through several components, same level neighbors see each other
+			size_t n = 0;
+			for (size_t i = 0; i < nLeaves; i++)
+			{
+				size_t begin = m_adjacencyOffset[i];
+				size_t end = m_adjacencyOffset[i + 1];
+				std::sort(m_adjacency.begin() + begin, m_adjacency.begin() + end);
+				m_adjacencyOffset[i] = n;
+				for (size_t j = begin; j < end; j++)
+				{
+					if (j == begin || m_adjacency[j] != m_adjacency[j - 1]) { m_adjacency[n++] = m_adjacency[j]; }
+				}
+			}
+			m_adjacencyOffset[nLeaves] = n;
+			m_adjacency.resize(n);
+		}
+
+		unsigned int m_width = 1;
+		std::vector<size_t> m_adjacencyOffset;
+		std::vector<size_t> m_adjacency;
+		std::vector< std::vector<size_t> > m_owned;
+		std::vector< std::vector<size_t> > m_ghosts;
+		std::vector< std::vector<unsigned int> > m_ghostDistance;
+		std::vector< std::vector<Exchange> > m_receives;
+		std::vector< std::vector<Exchange> > m_sends;
+	};
+
+}
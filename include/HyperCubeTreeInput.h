@@ -4,6 +4,8 @@
 #include <vector>
 
 #include "ScalarFunctionInput.h"
+#include "HyperCubeTreeContext.h"
+#include "MonotonicArena.h"
 #include "SimpleSubdivisionScheme.h"
 #include "TreeRefineImplicitSurface.h"
 #include "TreeLevelStorage.h"
@@ -11,14 +13,19 @@
 
 namespace hct
 {
+	/*
+	Reads a tree description into context. The tree, its fields and the functions
+	read from input are all owned by context.
+	*/
 	template<unsigned int D, typename T, typename StreamT>
 	static inline
-	HyperCubeTree<D, SimpleSubdivisionScheme<D> >*
-	read_tree(StreamT& input,
-					std::vector< hct::TreeLevelArray<T>* > & scalars,
-					std::vector< hct::TreeLevelArray<Vec<T,D> >* > & vectors )
+	HyperCubeTree<D, SimpleSubdivisionScheme<D> >&
+	read_tree(StreamT& input, HyperCubeTreeContext<D, T>& context)
 	{
 		using Tree = HyperCubeTree<D, SimpleSubdivisionScheme<D> >;
+		using ScalarField = typename HyperCubeTreeContext<D, T>::ScalarField;
+		using VectorField = typename HyperCubeTreeContext<D, T>::VectorField;
+		MonotonicArena* arena = &context.arena();
 		using TreeCursor = typename Tree::DefaultTreeCursor;
 		using LocatedTreeCursor = HyperCubeTreeLocatedCursor<Tree>;
 
@@ -46,7 +53,7 @@ namespace hct
 			abort(); 
 		}
 
-		Tree* tree = new Tree(levels);
+		Tree* tree = &context.createTree(levels);
 
 		input >> token;
 		if (token == "refine")
@@ -71,7 +78,7 @@ namespace hct
 				{
 					size_t maxLevel = 0;
 					input >> maxLevel;
-					auto surf = scalar_function_read<D, T>(input);
+					auto surf = scalar_function_read<D, T>(input, arena);
 					tree_refine_implicit_surface(*tree, surf, maxLevel);
 				}
 				else
@@ -98,13 +105,10 @@ namespace hct
 			input >> functionOrData;
 			if (token == "scalar")
 			{
-				TreeLevelArray<T>* scalarField = new TreeLevelArray<T>();
-				scalarField->setName(name);
-				scalars.push_back(scalarField);
-				tree->addArray(scalarField);
+				ScalarField* scalarField = &context.addScalarField(name);
 				if (functionOrData == "function")
 				{
-					auto f = scalar_function_read<D, T>(input);
+					auto f = scalar_function_read<D, T>(input, arena);
 					tree->preorderParseCells( [scalarField,f](const LocatedTreeCursor& cursor)
 					{
 						(*scalarField)[cursor.cell()] = f( cursor.position().addHalfUnit().normalize() ).value();
@@ -114,17 +118,13 @@ namespace hct
 				{
 					abort();
 				}
-				scalars.push_back(scalarField);
 			}
 			else if( token=="gradient" )
 			{
-				TreeLevelArray< Vec<T,D> >* vectorField = new TreeLevelArray< Vec<T, D> >();
-				vectorField->setName(name);
-				vectors.push_back(vectorField);
-				tree->addArray(vectorField);
+				VectorField* vectorField = &context.addVectorField(name);
 				if (functionOrData == "function")
 				{
-					auto f = scalar_function_read<D, T>(input);
+					auto f = scalar_function_read<D, T>(input, arena);
 					tree->preorderParseCells([vectorField, f](const LocatedTreeCursor& cursor)
 					{
 						(*vectorField)[cursor.cell()] = f(cursor.position().addHalfUnit().normalize()).gradient();
@@ -151,7 +151,17 @@ namespace hct
 			abort();
 		}
 
-		return tree;
+		return *tree;
+	}
+
+	template<unsigned int D, typename T, typename StreamT>
+	static inline
+	HyperCubeTreeContext<D, T>
+	read_tree(StreamT& input)
+	{
+		HyperCubeTreeContext<D, T> context;
+		read_tree<D, T>(input, context);
+		return context;
 	}
 
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "HyperCubeNeighbor.h"
 #include "HyperCubeTreeCellPosition.h"
 
+#include <type_traits>
 #include <assert.h>
 
 namespace hct
@@ -30,6 +31,12 @@ namespace hct
 			CellPosition m_position;
 		};
 
+		// face components of the neighborhood (a single fixed coordinate) : axis of the face normal, and side (0 low, 1 high)
+		template<typename HCubeComp> static constexpr bool isFace(HCubeComp) { return HCubeComp::N_FREE == (D - 1); }
+		template<typename HCubeComp> static constexpr unsigned int faceAxis(HCubeComp) { return bitIndex(HCubeComp::DEF_BITFIELD); }
+		template<typename HCubeComp> static constexpr unsigned int faceSide(HCubeComp) { return (HCubeComp::N_ONES == 1) ? 1 : 0; }
+		static constexpr unsigned int bitIndex(size_t bits) { return (bits > 1) ? (1 + bitIndex(bits >> 1)) : 0; }
+
 		using HCube = HyperCube< HCubeComponentValue, D >;
 		using SubdivisionGrid = typename Tree::SubdivisionGrid;
 		using GridLocation = typename Tree::GridLocation;
@@ -72,11 +79,37 @@ namespace hct
 			const Tree & m_tree;
 		};
 
+		// same, for subdivision grids known at compile time : constant branch indices and position refinement
+		struct AttachStaticChildNeighborFunctor
+		{
+			inline AttachStaticChildNeighborFunctor(const Tree & tree) : m_tree(tree) {}
+
+			template<typename GridDim, typename M1, typename M2>
+			inline void operator () (
+				const HyperCube<HCubeComponentValue,0,M1>& parentNeighbor,
+				HyperCube<HCubeComponentValue,0,M2>& childNeighbor,
+				GridDim,
+				GridLocation,
+				GridLocation neighborChildLocation)
+			{
+				if ( !m_tree.isTerminal(parentNeighbor.value.m_cell) )
+				{
+					childNeighbor.value.m_cell = m_tree.child(parentNeighbor.value.m_cell, GridDim::branch(neighborChildLocation));
+					childNeighbor.value.m_position = parentNeighbor.value.m_position.refine(GridDim::value()) + neighborChildLocation;
+				}
+				else
+				{
+					childNeighbor.value = parentNeighbor.value;
+				}
+			}
+			const Tree & m_tree;
+		};
+
 		// recursion constructor
 		inline HyperCubeTreeNeighborCursor(const Tree& tree, const HyperCubeTreeNeighborCursor& parent, SubdivisionGrid grid, GridLocation childLocation)
 		{
 			assert(!tree.isLeaf(parent.cell()));
-			HyperCubeNeighbor<HCubeComponentValue, D>::dig(grid, parent.m_nbh, m_nbh, childLocation, AttachChildNeighborFunctor(tree) );
+			digChild<typename Tree::SubdivisionTraversal>(tree, parent, grid, childLocation, std::integral_constant<bool, Tree::SubdivisionTraversal::IsStatic>());
 		}
 
 		inline Cell cell() const
@@ -95,6 +128,20 @@ namespace hct
 		}
 
 		HCube m_nbh;
+
+	private:
+		template<typename Traversal>
+		inline void digChild(const Tree& tree, const HyperCubeTreeNeighborCursor& parent, SubdivisionGrid grid, GridLocation childLocation, std::false_type)
+		{
+			HyperCubeNeighbor<HCubeComponentValue, D>::dig(grid, parent.m_nbh, m_nbh, childLocation, AttachChildNeighborFunctor(tree));
+		}
+
+		template<typename Traversal>
+		inline void digChild(const Tree& tree, const HyperCubeTreeNeighborCursor& parent, SubdivisionGrid, GridLocation childLocation, std::true_type)
+		{
+			using GridDim = typename Traversal::GridDim;
+			HyperCubeNeighborStatic<HCubeComponentValue, GridDim, D>::dig(parent.m_nbh, m_nbh, childLocation, AttachStaticChildNeighborFunctor(tree));
+		}
 	};
 
 }
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "LeafArray.h"
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace hct
+{
+
+	/*
+	Space filling curve partitioning of the leaves of a tree into K parts of balanced weight.
+
+	The curve is the leaf numbering (see HyperCubeTree::leafIndex) : pre-order traversal, children in increasing branch order
+	of their level's GridDimension. On 2^D subdivisions this is the Morton (Z) curve, and it is locality preserving
+	on any subdivision grid since the leaves of a cell are contiguous along the curve. Each part thus owns a contiguous
+	range of leaves, which is a contiguous slice of any LeafArray.
+
+	Parts are cut on the prefix sums of per-leaf weights (computed in parallel) : part p starts at the leaf
+	whose prefix weight is the closest to p * totalWeight / K. A part may be empty when a single leaf outweighs a whole part.
+	Each part is also described by its subtree roots : the smallest set of cells whose leaves are exactly the part's range,
+	at most (grid size - 1) per level on each side of the range.
+	*/
+	template<typename _Tree>
+	class HyperCubeTreePartition
+	{
+	public:
+		using Tree = _Tree;
+		static constexpr unsigned int D = Tree::D;
+		using Cell = HyperCubeTreeCell;
+
+		// uniform leaf weights
+		inline void build(const Tree& tree, unsigned int nParts)
+		{
+			LeafArray<double> weights;
+			tree.fitLeafArray(&weights);
+			weights.fill(1.0);
+			build(tree, nParts, weights);
+		}
+
+		inline void build(const Tree& tree, unsigned int nParts, const LeafArray<double>& weights)
+		{
+			assert(nParts >= 1);
+			size_t nLeaves = tree.getNumberOfLeaves();
+			assert(weights.size() == nLeaves);
+
+			// m_prefix[i] = sum of weights of leaves before i
+			m_prefix.resize(nLeaves + 1);
+			m_prefix[0] = 0.0;
+			std::vector<double> chunkSum;
+#			pragma omp parallel
+			{
+				int nThreads = 1, thread = 0;
+#				ifdef _OPENMP
+				nThreads = omp_get_num_threads();
+				thread = omp_get_thread_num();
+#				endif
+#				pragma omp single
+				chunkSum.assign(nThreads + 1, 0.0);
+				size_t begin = (nLeaves * thread) / nThreads;
+				size_t end = (nLeaves * (thread + 1)) / nThreads;
+				double sum = 0.0;
+				for (size_t i = begin; i < end; i++)
+				{
+					sum += weights[i];
+					m_prefix[i + 1] = sum;
+				}
+				chunkSum[thread + 1] = sum;
+#				pragma omp barrier
+#				pragma omp single
+				for (int t = 0; t < nThreads; t++) { chunkSum[t + 1] += chunkSum[t]; }
+				for (size_t i = begin; i < end; i++)
+				{
+					m_prefix[i + 1] += chunkSum[thread];
+				}
+			}
+
+			// cuts
+			double total = m_prefix[nLeaves];
+			m_begin.assign(nParts + 1, 0);
+			m_begin[nParts] = nLeaves;
+			for (unsigned int p = 1; p < nParts; p++)
+			{
+				double target = (total * p) / nParts;
+				size_t cut = std::lower_bound(m_prefix.begin(), m_prefix.end(), target) - m_prefix.begin();
+				if (cut > 0 && (target - m_prefix[cut - 1]) < (m_prefix[cut] - target)) { --cut; }
+				m_begin[p] = std::max(m_begin[p - 1], cut);
+			}
+
+			buildRoots(tree);
+		}
+
+		inline unsigned int numberOfParts() const { return static_cast<unsigned int>(m_begin.size() - 1); }
+
+		// leaf range of part p : [beginLeaf(p), endLeaf(p))
+		inline size_t beginLeaf(unsigned int p) const { return m_begin[p]; }
+		inline size_t endLeaf(unsigned int p) const { return m_begin[p + 1]; }
+
+		inline unsigned int partOf(size_t leaf) const
+		{
+			assert(leaf < m_begin.back());
+			return static_cast<unsigned int>(std::upper_bound(m_begin.begin(), m_begin.end(), leaf) - m_begin.begin()) - 1;
+		}
+
+		inline double weight(unsigned int p) const { return m_prefix[endLeaf(p)] - m_prefix[beginLeaf(p)]; }
+
+		// heaviest part weight over mean part weight, 1 is perfect balance
+		inline double imbalance() const
+		{
+			double total = m_prefix.back();
+			if (total <= 0.0) { return 1.0; }
+			double maxWeight = 0.0;
+			for (unsigned int p = 0; p < numberOfParts(); p++) { maxWeight = std::max(maxWeight, weight(p)); }
+			return maxWeight * numberOfParts() / total;
+		}
+
+		// subtree roots of part p, in leaf order
+		inline const std::vector<Cell>& roots(unsigned int p) const { return m_roots[p]; }
+
+		// part of each leaf, as used by HyperCubeTreeGhostLayer
+		inline void leafParts(LeafArray<unsigned int>& parts) const
+		{
+			parts.resize(m_begin.back());
+			for (unsigned int p = 0; p < numberOfParts(); p++)
+			{
+				for (size_t i = beginLeaf(p); i < endLeaf(p); i++) { parts[i] = p; }
+			}
+		}
+
+	private:
+
+		inline void buildRoots(const Tree& tree)
+		{
+			size_t nLevels = tree.getNumberOfLevels();
+			m_leafCount.resize(nLevels);
+			for (size_t l = 0; l < nLevels; l++) { m_leafCount[l].assign(tree.getLevelSize(l), 0); }
+			countLeaves(tree, tree.rootCell());
+			m_roots.assign(numberOfParts(), std::vector<Cell>());
+			collectRoots(tree, tree.rootCell(), 0);
+			m_leafCount.clear();
+		}
+
+		inline size_t countLeaves(const Tree& tree, Cell cell)
+		{
+			size_t count = 1;
+			if (!tree.isLeaf(cell))
+			{
+				count = 0;
+				size_t nChildren = tree.getLevelSubdivisionGrid(cell.level()).gridSize();
+				for (size_t i = 0; i < nChildren; i++) { count += countLeaves(tree, tree.child(cell, i)); }
+			}
+			m_leafCount[cell.level()][cell.index()] = count;
+			return count;
+		}
+
+		// cell's leaves are [first, first + leaf count)
+		inline void collectRoots(const Tree& tree, Cell cell, size_t first)
+		{
+			size_t last = first + m_leafCount[cell.level()][cell.index()] - 1;
+			unsigned int p = partOf(first);
+			if (last < endLeaf(p))
+			{
+				m_roots[p].push_back(cell);
+				return;
+			}
+			size_t nChildren = tree.getLevelSubdivisionGrid(cell.level()).gridSize();
+			for (size_t i = 0; i < nChildren; i++)
+			{
+				Cell child = tree.child(cell, i);
+				collectRoots(tree, child, first);
+				first += m_leafCount[child.level()][child.index()];
+			}
+		}
+
+		std::vector<double> m_prefix;
+		std::vector<size_t> m_begin;
+		std::vector< std::vector<Cell> > m_roots;
+		std::vector< std::vector<size_t> > m_leafCount;
+	};
+
+}
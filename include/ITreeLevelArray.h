@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace hct
 {
@@ -22,6 +23,8 @@ namespace hct
 			virtual size_t size(size_t level) const = 0;
 			virtual void resize(size_t level, size_t nElems) =0;
 			virtual void erase(size_t level, size_t position, size_t nElems) =0;
+			// removes elements of a level whose keep flag is false, preserving the order of the others
+			virtual void compact(size_t level, const std::vector<bool>& keep) =0;
 			virtual size_t numberOfComponents() const = 0;
 			virtual std::ostream& printCell(std::ostream&, HyperCubeTreeCell cell) const =0;
 			virtual inline std::ostream& print(std::ostream& out) 
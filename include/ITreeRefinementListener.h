@@ -0,0 +1,28 @@
+#pragma once
+
+#include "HyperCubeTreeCell.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hct
+{
+
+	/*
+	Notified by the tree when a cell's children are created or removed,
+	so that cell data attached to the tree follows topology changes (see TreeFieldTransfer.h),
+	and when cells are renumbered, so that references to cells stay valid (see TreeParticles.h).
+	*/
+	class ITreeRefinementListener
+	{
+		public:
+			// children of cell have just been created
+			virtual void cellRefined(HyperCubeTreeCell cell) = 0;
+			// children of cell, all leaves, are about to be removed
+			virtual void cellCoarsening(HyperCubeTreeCell cell) = 0;
+			// cells of level are about to be renumbered by coarsening : cell i becomes newIndex[i], removed cells get -1
+			virtual void levelRenumbered(size_t /*level*/, const std::vector<int64_t>& /*newIndex*/) {}
+	};
+
+}
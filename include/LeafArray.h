@@ -0,0 +1,129 @@
+#pragma once
+
+#include "HyperCubeTreeCell.h"
+#include "NumericalValueTraits.h"
+#include "TreeLevelArray.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	A field holding one value per leaf of a tree, stored densely in leaf order.
+	Leaf order is the one given by the tree's leaf numbering (see HyperCubeTree::leafIndex),
+	that is the pre-order traversal order of parseLeaves.
+	Unlike TreeLevelArray, a LeafArray is not registered in the tree's storage,
+	it has to be re-fitted (tree.fitLeafArray) after each topology change.
+	*/
+	template<typename T>
+	class LeafArray
+	{
+		using ElementReference = typename std::vector<T>::reference;
+		using ConstElementReference = typename std::vector<T>::const_reference;
+		public:
+			using iterator = typename std::vector<T>::iterator;
+			using const_iterator = typename std::vector<T>::const_iterator;
+
+			inline void setName(const std::string& name)
+			{
+				m_name = name;
+			}
+
+			inline std::string name() const
+			{
+				return m_name;
+			}
+
+			inline size_t size() const
+			{
+				return m_values.size();
+			}
+
+			inline void resize(size_t nElems)
+			{
+				m_values.resize(nElems);
+			}
+
+			inline void fill(const T& value)
+			{
+				for (auto& x : m_values) { x = value; }
+			}
+
+			inline size_t numberOfComponents() const
+			{
+				return NumericalValueTraits<T>::NumberOfComponents;
+			}
+
+			inline std::ostream& printLeaf(std::ostream& out, size_t leaf) const
+			{
+				return NumericalValueTraits<T>::toStream(out, m_values[leaf]);
+			}
+
+			// flat array access
+			inline T* data() { return m_values.data(); }
+			inline const T* data() const { return m_values.data(); }
+			inline iterator begin() { return m_values.begin(); }
+			inline iterator end() { return m_values.end(); }
+			inline const_iterator begin() const { return m_values.begin(); }
+			inline const_iterator end() const { return m_values.end(); }
+
+			inline ConstElementReference operator [] (size_t leaf) const
+			{
+				assert(leaf < m_values.size());
+				return m_values[leaf];
+			}
+
+			inline ElementReference operator [] (size_t leaf)
+			{
+				assert(leaf < m_values.size());
+				return m_values[leaf];
+			}
+
+			// cell based access, cell must be a leaf of tree
+			template<typename Tree>
+			inline ConstElementReference at(const Tree& tree, HyperCubeTreeCell cell) const
+			{
+				return operator [] (tree.leafIndex(cell));
+			}
+
+			template<typename Tree>
+			inline ElementReference at(const Tree& tree, HyperCubeTreeCell cell)
+			{
+				return operator [] (tree.leafIndex(cell));
+			}
+
+			// copies leaf values of a per-level array
+			template<typename Tree>
+			inline void gather(const Tree& tree, const TreeLevelArray<T>& src)
+			{
+				size_t nLeaves = tree.getNumberOfLeaves();
+				m_values.resize(nLeaves);
+				for (size_t i = 0; i < nLeaves; i++)
+				{
+					m_values[i] = src[tree.leafCell(i)];
+				}
+			}
+
+			// writes values back to leaf cells of a per-level array. interior cells are left untouched
+			template<typename Tree>
+			inline void scatter(const Tree& tree, TreeLevelArray<T>& dst) const
+			{
+				size_t nLeaves = tree.getNumberOfLeaves();
+				assert(nLeaves == m_values.size());
+				for (size_t i = 0; i < nLeaves; i++)
+				{
+					dst[tree.leafCell(i)] = m_values[i];
+				}
+			}
+
+		private:
+			std::vector<T> m_values;
+			std::string m_name;
+	};
+
+}
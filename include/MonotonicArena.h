@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	A monotonic memory arena : memory is taken from large blocks, never given back individually,
+	and everything is released in one shot when the arena is destroyed (or release() is called).
+	Objects built with create() have their destructors called at release time, in reverse creation order.
+	Objects live at a fixed address until release, so the arena itself may be moved.
+	*/
+	class MonotonicArena
+	{
+	public:
+		static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+		inline explicit MonotonicArena(size_t blockSize = DefaultBlockSize)
+			: m_block_size(blockSize)
+		{}
+
+		inline ~MonotonicArena()
+		{
+			release();
+		}
+
+		MonotonicArena(const MonotonicArena&) = delete;
+		MonotonicArena& operator = (const MonotonicArena&) = delete;
+
+		inline MonotonicArena(MonotonicArena&& other)
+			: m_blocks(std::move(other.m_blocks))
+			, m_current(other.m_current)
+			, m_remaining(other.m_remaining)
+			, m_block_size(other.m_block_size)
+			, m_allocated(other.m_allocated)
+			, m_finalizers(other.m_finalizers)
+		{
+			other.forget();
+		}
+
+		inline MonotonicArena& operator = (MonotonicArena&& other)
+		{
+			if (this != &other)
+			{
+				release();
+				m_blocks = std::move(other.m_blocks);
+				m_current = other.m_current;
+				m_remaining = other.m_remaining;
+				m_block_size = other.m_block_size;
+				m_allocated = other.m_allocated;
+				m_finalizers = other.m_finalizers;
+				other.forget();
+			}
+			return *this;
+		}
+
+		// raw, uninitialized memory
+		inline void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+			size_t padding = alignmentPadding(m_current, alignment);
+			if (m_current == nullptr || (padding + size) > m_remaining)
+			{
+				// large requests get a dedicated block, so that the current block is not wasted
+				size_t blockSize = size + alignment;
+				if (blockSize <= m_block_size)
+				{
+					blockSize = m_block_size;
+					m_current = newBlock(blockSize);
+					m_remaining = blockSize;
+				}
+				else
+				{
+					char* block = newBlock(blockSize);
+					m_allocated += size;
+					return block + alignmentPadding(block, alignment);
+				}
+				padding = alignmentPadding(m_current, alignment);
+			}
+			char* ptr = m_current + padding;
+			m_current = ptr + size;
+			m_remaining -= padding + size;
+			m_allocated += size;
+			return ptr;
+		}
+
+		// constructs an object in the arena. the arena owns it.
+		template<typename T, typename... Args>
+		inline T* create(Args&&... args)
+		{
+			void* mem = allocate(sizeof(T), alignof(T));
+			T* obj = new (mem) T(std::forward<Args>(args)...);
+			if (!std::is_trivially_destructible<T>::value)
+			{
+				Finalizer* fin = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+				fin->m_destroy = &destroyObject<T>;
+				fin->m_object = obj;
+				fin->m_next = m_finalizers;
+				m_finalizers = fin;
+			}
+			return obj;
+		}
+
+		// destroys all objects and frees all memory blocks
+		inline void release()
+		{
+			while (m_finalizers != nullptr)
+			{
+				Finalizer* fin = m_finalizers;
+				m_finalizers = fin->m_next;
+				fin->m_destroy(fin->m_object);
+			}
+			for (char* block : m_blocks) { delete[] block; }
+			m_blocks.clear();
+			m_current = nullptr;
+			m_remaining = 0;
+			m_allocated = 0;
+		}
+
+		inline size_t allocatedBytes() const
+		{
+			return m_allocated;
+		}
+
+		inline size_t numberOfBlocks() const
+		{
+			return m_blocks.size();
+		}
+
+	private:
+
+		struct Finalizer
+		{
+			void(*m_destroy)(void*);
+			void* m_object;
+			Finalizer* m_next;
+		};
+
+		template<typename T>
+		static inline void destroyObject(void* p)
+		{
+			static_cast<T*>(p)->~T();
+		}
+
+		static inline size_t alignmentPadding(const char* p, size_t alignment)
+		{
+			uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+			return (alignment - (addr % alignment)) % alignment;
+		}
+
+		inline char* newBlock(size_t size)
+		{
+			char* block = new char[size];
+			m_blocks.push_back(block);
+			return block;
+		}
+
+		inline void forget()
+		{
+			m_blocks.clear();
+			m_current = nullptr;
+			m_remaining = 0;
+			m_allocated = 0;
+			m_finalizers = nullptr;
+		}
+
+		std::vector<char*> m_blocks;
+		char* m_current = nullptr;
+		size_t m_remaining = 0;
+		size_t m_block_size;
+		size_t m_allocated = 0;
+		Finalizer* m_finalizers = nullptr;
+	};
+
+}
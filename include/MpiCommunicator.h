@@ -0,0 +1,86 @@
+#pragma once
+
+#ifdef HCT_WITH_MPI
+
+#include "Communicator.h"
+
+#include <cstddef>
+#include <list>
+#include <vector>
+#include <assert.h>
+
+#include <mpi.h>
+
+namespace hct
+{
+
+	/*
+	Communicator over an MPI communicator (MPI_COMM_WORLD by default). MPI has to be initialized by the caller.
+	Sends are non blocking (MPI_Isend on a copy of the message), completed requests are released
+	on later calls, remaining ones when the communicator is destroyed.
+	*/
+	class MpiCommunicator : public Communicator
+	{
+	public:
+		inline MpiCommunicator(MPI_Comm comm = MPI_COMM_WORLD)
+			: m_comm(comm)
+		{
+			MPI_Comm_rank(m_comm, &m_rank);
+			MPI_Comm_size(m_comm, &m_size);
+		}
+
+		inline ~MpiCommunicator()
+		{
+			for (auto& s : m_sends) { MPI_Wait(&s.m_request, MPI_STATUS_IGNORE); }
+		}
+
+		inline int rank() const override { return m_rank; }
+		inline int size() const override { return m_size; }
+
+		inline void send(int dest, int tag, const void* data, size_t bytes) override
+		{
+			releaseCompletedSends();
+			const char* p = static_cast<const char*>(data);
+			m_sends.push_back(PendingSend{ MPI_REQUEST_NULL, std::vector<char>(p, p + bytes) });
+			PendingSend& s = m_sends.back();
+			MPI_Isend(s.m_data.data(), static_cast<int>(bytes), MPI_BYTE, dest, tag, m_comm, &s.m_request);
+		}
+
+		inline void recv(int source, int tag, std::vector<char>& data) override
+		{
+			MPI_Status status;
+			MPI_Probe(source, tag, m_comm, &status);
+			int count = 0;
+			MPI_Get_count(&status, MPI_BYTE, &count);
+			data.resize(count);
+			MPI_Recv(data.data(), count, MPI_BYTE, source, tag, m_comm, MPI_STATUS_IGNORE);
+			releaseCompletedSends();
+		}
+
+	private:
+		struct PendingSend
+		{
+			MPI_Request m_request;
+			std::vector<char> m_data;
+		};
+
+		inline void releaseCompletedSends()
+		{
+			for (auto it = m_sends.begin(); it != m_sends.end(); )
+			{
+				int done = 0;
+				MPI_Test(&it->m_request, &done, MPI_STATUS_IGNORE);
+				if (done) { it = m_sends.erase(it); }
+				else { ++it; }
+			}
+		}
+
+		MPI_Comm m_comm;
+		int m_rank = 0;
+		int m_size = 1;
+		std::list<PendingSend> m_sends;
+	};
+
+}
+
+#endif
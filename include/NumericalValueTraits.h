@@ -1,11 +1,39 @@
 #pragma once
 
+#include <cstddef>
+#include <array>
+
 namespace hct
 {
 	template <typename T>
 	struct NumericalValueTraits
 	{
 		static constexpr size_t NumberOfComponents = 1;
+
+		template<typename StreamT>
+		static inline StreamT& toStream(StreamT& out, const T& value)
+		{
+			out << value;
+			return out;
+		}
+	};
+
+	// components are written space separated, as expected by multi-component field writers
+	template <typename T, size_t N>
+	struct NumericalValueTraits< std::array<T, N> >
+	{
+		static constexpr size_t NumberOfComponents = N;
+
+		template<typename StreamT>
+		static inline StreamT& toStream(StreamT& out, const std::array<T, N>& value)
+		{
+			for (size_t i = 0; i < N; i++)
+			{
+				if (i > 0) { out << ' '; }
+				NumericalValueTraits<T>::toStream(out, value[i]);
+			}
+			return out;
+		}
 	};
 
-}
\ No newline at end of file
+}
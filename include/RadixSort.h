@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace hct
+{
+
+	/*
+	Stable LSD radix sort of (key,value) pairs on the keyBits lowest bits of unsigned integer keys.
+	Each 8 bits digit pass is a parallel histogram followed by a parallel scatter,
+	threads process contiguous chunks so that equal keys keep their relative order.
+	*/
+	template<typename KeyT, typename ValueT>
+	static inline void radixSort(std::vector<KeyT>& keys, std::vector<ValueT>& values, unsigned int keyBits = sizeof(KeyT) * 8)
+	{
+		static constexpr unsigned int DigitBits = 8;
+		static constexpr size_t Radix = size_t(1) << DigitBits;
+		static constexpr long ParallelThreshold = 1 << 16;
+
+		assert(keys.size() == values.size());
+		assert(keyBits <= sizeof(KeyT) * 8);
+		long n = static_cast<long>(keys.size());
+
+		int maxThreads = 1;
+#		ifdef _OPENMP
+		maxThreads = omp_get_max_threads();
+#		endif
+		std::vector<size_t> offsets(maxThreads * Radix);
+		std::vector<KeyT> tmpKeys(n);
+		std::vector<ValueT> tmpValues(n);
+
+		for (unsigned int shift = 0; shift < keyBits; shift += DigitBits)
+		{
+			std::fill(offsets.begin(), offsets.end(), 0);
+#			pragma omp parallel if(n > ParallelThreshold)
+			{
+				int thread = 0;
+				int nThreads = 1;
+#				ifdef _OPENMP
+				thread = omp_get_thread_num();
+				nThreads = omp_get_num_threads();
+#				endif
+				long begin = (n * thread) / nThreads;
+				long end = (n * (thread + 1)) / nThreads;
+				size_t* histogram = offsets.data() + thread * Radix;
+				for (long i = begin; i < end; i++)
+				{
+					++histogram[(keys[i] >> shift) & (Radix - 1)];
+				}
+
+#				pragma omp barrier
+#				pragma omp single
+				{
+					// digit major, thread minor : lower threads write first
+					size_t sum = 0;
+					for (size_t d = 0; d < Radix; d++)
+					{
+						for (int t = 0; t < nThreads; t++)
+						{
+							size_t count = offsets[t * Radix + d];
+							offsets[t * Radix + d] = sum;
+							sum += count;
+						}
+					}
+				}
+
+				for (long i = begin; i < end; i++)
+				{
+					size_t pos = histogram[(keys[i] >> shift) & (Radix - 1)]++;
+					tmpKeys[pos] = keys[i];
+					tmpValues[pos] = values[i];
+				}
+			}
+			keys.swap(tmpKeys);
+			values.swap(tmpValues);
+		}
+	}
+
+	// number of bits needed to store values in [0;n[
+	static inline unsigned int radixSortKeyBits(uint64_t n)
+	{
+		if (n <= 1) { return 0; }
+		unsigned int bits = 0;
+		while (bits < 64 && (n - 1) >> bits) { ++bits; }
+		return bits;
+	}
+
+}
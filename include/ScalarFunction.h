@@ -6,12 +6,16 @@
 #include <algorithm>
 
 #include "Vec.h"
+#include "MonotonicArena.h"
 
 namespace hct
 {
 
 	static constexpr double SurfEpsilon = 1.e-16;
 
+	// tag type, selects constructors that do not take ownership of a pointer
+	struct NonOwningTag {};
+
 	// ================= returned by a scalar function ==================
 	template<unsigned int D, typename T = double>
 	struct ScalarFunctionValue
@@ -53,17 +57,24 @@ namespace hct
 	};
 
 	// ================= generic scalar function placeholder ==================
+	/*
+	The delegate either shares ownership of a heap allocated function,
+	or just references a function owned by someone else (e.g. a MonotonicArena).
+	*/
 	template<unsigned int _D, typename _T = double>
 	struct ScalarFunctionDelegate : public IScalarFunction<_D, _T>
 	{
 		using T = _T;
 		static constexpr unsigned int D = _D;
-		inline ScalarFunctionDelegate(IScalarFunction<D, T>* fptr) : m_f_ptr(fptr) {}
+		inline ScalarFunctionDelegate(IScalarFunction<D, T>* fptr) : m_f_ptr(fptr), m_f_owner(fptr) {}
+		inline ScalarFunctionDelegate(std::shared_ptr< const IScalarFunction<D, T> > fptr) : m_f_ptr(fptr.get()), m_f_owner(fptr) {}
+		inline ScalarFunctionDelegate(const IScalarFunction<D, T>* fptr, NonOwningTag) : m_f_ptr(fptr) {}
 		inline ScalarFunctionValue<D, T> operator () (const hct::Vec<T, D>& p) const override final
 		{
 			return m_f_ptr->operator () (p);
 		}
-		std::shared_ptr< IScalarFunction<D, T> > m_f_ptr;
+		const IScalarFunction<D, T>* m_f_ptr;
+		std::shared_ptr< const IScalarFunction<D, T> > m_f_owner;
 	};
 
 	template<typename FuncT>
@@ -71,7 +82,27 @@ namespace hct
 	ScalarFunctionDelegate<FuncT::D, typename FuncT::T>
 	scalar_function_delegate(FuncT f)
 	{
-		return ScalarFunctionDelegate<FuncT::D, typename FuncT::T>( new FuncT(f) );
+		// make_shared keeps FuncT's destructor, IScalarFunction has no virtual destructor
+		return ScalarFunctionDelegate<FuncT::D, typename FuncT::T>( std::static_pointer_cast< const IScalarFunction<FuncT::D, typename FuncT::T> >( std::make_shared<FuncT>(f) ) );
+	}
+
+	// function object is built in the arena, no per-function heap allocation nor reference counting
+	template<typename FuncT>
+	inline
+	ScalarFunctionDelegate<FuncT::D, typename FuncT::T>
+	scalar_function_delegate(MonotonicArena& arena, FuncT f)
+	{
+		return ScalarFunctionDelegate<FuncT::D, typename FuncT::T>( arena.create<FuncT>(f), NonOwningTag() );
+	}
+
+	// builds a function delegate, in arena if one is given, on the heap otherwise
+	template<typename FuncT>
+	inline
+	ScalarFunctionDelegate<FuncT::D, typename FuncT::T>
+	scalar_function_delegate(MonotonicArena* arena, FuncT f)
+	{
+		if (arena != nullptr) { return scalar_function_delegate(*arena, f); }
+		else { return scalar_function_delegate(f); }
 	}
 
 	// ================= constant function ==================
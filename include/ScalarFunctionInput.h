@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ScalarFunction.h"
+#include "MonotonicArena.h"
 
 #include <string>
 #include <memory>
@@ -10,8 +11,13 @@
 namespace hct
 {
 
+	/*
+	Reads a function expression from a stream.
+	If arena is not null, all function nodes are allocated in it and
+	the returned delegate is only valid as long as arena is not released.
+	*/
 	template<unsigned int D, typename T, typename StreamT>
-	ScalarFunctionDelegate<D, T> scalar_function_read(StreamT& input)
+	ScalarFunctionDelegate<D, T> scalar_function_read(StreamT& input, MonotonicArena* arena = nullptr)
 	{
 		std::string token;
 		input >> token;
@@ -20,14 +26,14 @@ namespace hct
 			T center[D];
 			for (size_t i = 0; i < D; i++) { center[i] = 0.0;  input >> center[i]; }
 			auto surf = point_distance_function( Vec<T, D>(center) );
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		else if (token == "constant")
 		{
 			T c = 0;
 			input >> c;
 			auto surf = ConstantFunction<D,T>( c );
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		else if (token == "sphere")
 		{
@@ -36,7 +42,7 @@ namespace hct
 			T radius = 0;
 			input >> radius;
 			auto surf = csg_sphere(Vec<T, D>(center), radius);
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		else if (token == "plane")
 		{
@@ -45,41 +51,41 @@ namespace hct
 			T offset = 0;
 			input >> offset;
 			auto surf = plane_function(Vec<T, D + 1>(offset, Vec<T, D>(normal)));
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		else if (token == "-")
 		{
-			auto a = scalar_function_read<D, T>(input);
+			auto a = scalar_function_read<D, T>(input, arena);
 			auto surf = negate_function(a);
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		else if (token == "add")
 		{
-			auto a = scalar_function_read<D, T>(input);
-			auto b = scalar_function_read<D, T>(input);
+			auto a = scalar_function_read<D, T>(input, arena);
+			auto b = scalar_function_read<D, T>(input, arena);
 			auto surf = add_function(a,b);
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		else if (token == "csg_union")
 		{
-			auto a = scalar_function_read<D,T>(input);
-			auto b = scalar_function_read<D,T>(input);
+			auto a = scalar_function_read<D,T>(input, arena);
+			auto b = scalar_function_read<D,T>(input, arena);
 			auto surf = csg_union(a, b);
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		else if (token == "csg_intersection")
 		{
-			auto a = scalar_function_read<D,T>(input);
-			auto b = scalar_function_read<D,T>(input);
+			auto a = scalar_function_read<D,T>(input, arena);
+			auto b = scalar_function_read<D,T>(input, arena);
 			auto surf = csg_intersection(a, b);
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		else if (token == "csg_difference")
 		{
-			auto a = scalar_function_read<D,T>(input);
-			auto b = scalar_function_read<D,T>(input);
+			auto a = scalar_function_read<D,T>(input, arena);
+			auto b = scalar_function_read<D,T>(input, arena);
 			auto surf = csg_difference(a, b);
-			return scalar_function_delegate(surf);
+			return scalar_function_delegate(arena, surf);
 		}
 		/*
 		else if( token == "if" )
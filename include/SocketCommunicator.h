@@ -0,0 +1,244 @@
+#pragma once
+
+#include "Communicator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include <assert.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+namespace hct
+{
+
+	/*
+	Communicator between processes of one Linux machine, over a full mesh of local (AF_UNIX) stream sockets.
+
+	run(nRanks, f) forks nRanks processes, each one calling f(communicator) then exiting,
+	and returns true if every rank exited normally. It has to be called before any OpenMP parallel region
+	of the calling process (the OpenMP thread pool does not survive fork).
+
+	Messages are framed by a (tag, size) header. Sockets are non blocking : a send to a full socket
+	reads incoming messages into the pending queue while it waits, so two ranks sending to each other never deadlock.
+	*/
+	class SocketCommunicator : public Communicator
+	{
+	public:
+		template<typename FuncT>
+		static inline bool run(int nRanks, FuncT f)
+		{
+			assert(nRanks >= 1);
+			std::vector< std::vector<int> > fds(nRanks, std::vector<int>(nRanks, -1));
+			for (int i = 0; i < nRanks; i++)
+			{
+				for (int j = i + 1; j < nRanks; j++)
+				{
+					int sv[2];
+					if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) { fail("socketpair"); }
+					fds[i][j] = sv[0];
+					fds[j][i] = sv[1];
+				}
+			}
+
+			// buffered output would be written again by each child
+			std::cout.flush();
+			std::cerr.flush();
+			std::fflush(0);
+			std::vector<pid_t> pids(nRanks, -1);
+			for (int r = 0; r < nRanks; r++)
+			{
+				pids[r] = ::fork();
+				if (pids[r] < 0) { fail("fork"); }
+				if (pids[r] == 0)
+				{
+					for (int i = 0; i < nRanks; i++)
+					{
+						for (int j = 0; j < nRanks; j++)
+						{
+							if (i != r && fds[i][j] >= 0) { ::close(fds[i][j]); }
+						}
+					}
+					{
+						SocketCommunicator comm(r, fds[r]);
+						f(static_cast<Communicator&>(comm));
+					}
+					std::cout.flush();
+					std::cerr.flush();
+					std::fflush(0);
+					::_exit(0);
+				}
+			}
+
+			for (auto& row : fds)
+			{
+				for (int fd : row) { if (fd >= 0) { ::close(fd); } }
+			}
+			bool success = true;
+			for (int r = 0; r < nRanks; r++)
+			{
+				int status = 0;
+				while (::waitpid(pids[r], &status, 0) < 0 && errno == EINTR) {}
+				if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				{
+					std::cerr << "SocketCommunicator: rank " << r << " failed" << std::endl;
+					success = false;
+				}
+			}
+			return success;
+		}
+
+		inline ~SocketCommunicator()
+		{
+			for (int fd : m_fds) { if (fd >= 0) { ::close(fd); } }
+		}
+
+		inline int rank() const override { return m_rank; }
+		inline int size() const override { return static_cast<int>(m_fds.size()); }
+
+		inline void send(int dest, int tag, const void* data, size_t bytes) override
+		{
+			assert(dest >= 0 && dest < size());
+			if (dest == m_rank)
+			{
+				m_queue.push(dest, tag, static_cast<const char*>(data), bytes);
+				return;
+			}
+			Header header{ static_cast<int32_t>(tag), static_cast<uint64_t>(bytes) };
+			writeAll(dest, reinterpret_cast<const char*>(&header), sizeof(Header));
+			writeAll(dest, static_cast<const char*>(data), bytes);
+		}
+
+		inline void recv(int source, int tag, std::vector<char>& data) override
+		{
+			assert(source >= 0 && source < size());
+			while (!m_queue.pop(source, tag, data))
+			{
+				if (source == m_rank || m_closed[source])
+				{
+					std::cerr << "SocketCommunicator: rank " << m_rank << " waits for a message (tag " << tag << ") that rank " << source << " will never send" << std::endl;
+					std::abort();
+				}
+				wait(source, -1);
+			}
+		}
+
+	private:
+		struct Header
+		{
+			int32_t m_tag;
+			uint64_t m_bytes;
+		};
+
+		inline SocketCommunicator(int rank, const std::vector<int>& fds)
+			: m_rank(rank)
+			, m_fds(fds)
+			, m_input(fds.size())
+			, m_inputBegin(fds.size(), 0)
+			, m_closed(fds.size(), false)
+		{
+			m_queue.resize(size());
+			for (int fd : m_fds)
+			{
+				if (fd >= 0) { ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK); }
+			}
+		}
+
+		static inline void fail(const char* what)
+		{
+			std::cerr << "SocketCommunicator: " << what << " failed : " << std::strerror(errno) << std::endl;
+			std::abort();
+		}
+
+		inline void writeAll(int dest, const char* data, size_t bytes)
+		{
+			while (bytes > 0)
+			{
+				ssize_t n = ::send(m_fds[dest], data, bytes, MSG_NOSIGNAL);
+				if (n > 0)
+				{
+					data += n;
+					bytes -= static_cast<size_t>(n);
+				}
+				else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { wait(-1, dest); }
+				else if (n < 0 && errno == EINTR) {}
+				else { fail("send"); }
+			}
+		}
+
+		// waits until writeRank's socket is writable or some socket (readRank's only, if given) is readable, and reads available data
+		inline void wait(int readRank, int writeRank)
+		{
+			std::vector<pollfd> polled;
+			std::vector<int> ranks;
+			for (int r = 0; r < size(); r++)
+			{
+				if (r == m_rank) { continue; }
+				short events = 0;
+				if (!m_closed[r] && (readRank < 0 || r == readRank)) { events |= POLLIN; }
+				if (r == writeRank) { events |= POLLOUT; }
+				if (events == 0) { continue; }
+				polled.push_back(pollfd{ m_fds[r], events, 0 });
+				ranks.push_back(r);
+			}
+			if (::poll(polled.data(), polled.size(), -1) < 0)
+			{
+				if (errno == EINTR) { return; }
+				fail("poll");
+			}
+			for (size_t i = 0; i < polled.size(); i++)
+			{
+				if ((polled[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0 && !m_closed[ranks[i]]) { readAvailable(ranks[i]); }
+			}
+		}
+
+		inline void readAvailable(int source)
+		{
+			std::vector<char>& input = m_input[source];
+			char buffer[1 << 16];
+			for (;;)
+			{
+				ssize_t n = ::recv(m_fds[source], buffer, sizeof(buffer), 0);
+				if (n > 0) { input.insert(input.end(), buffer, buffer + n); }
+				else if (n == 0) { m_closed[source] = true; break; }
+				else if (errno == EAGAIN || errno == EWOULDBLOCK) { break; }
+				else if (errno != EINTR) { fail("recv"); }
+			}
+
+			// complete messages go to the queue
+			size_t& begin = m_inputBegin[source];
+			for (;;)
+			{
+				if ((input.size() - begin) < sizeof(Header)) { break; }
+				Header header;
+				std::memcpy(&header, input.data() + begin, sizeof(Header));
+				if ((input.size() - begin - sizeof(Header)) < header.m_bytes) { break; }
+				m_queue.push(source, header.m_tag, input.data() + begin + sizeof(Header), header.m_bytes);
+				begin += sizeof(Header) + header.m_bytes;
+			}
+			if (begin > 0 && (begin * 2) >= input.size())
+			{
+				input.erase(input.begin(), input.begin() + begin);
+				begin = 0;
+			}
+		}
+
+		int m_rank;
+		std::vector<int> m_fds; // socket to each rank, -1 for self
+		std::vector< std::vector<char> > m_input; // bytes received, not yet queued
+		std::vector<size_t> m_inputBegin;
+		std::vector<bool> m_closed;
+		MessageQueue m_queue;
+	};
+
+}
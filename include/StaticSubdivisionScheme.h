@@ -2,6 +2,10 @@
 
 #include "Vec.h"
 #include "GridDimension.h"
+#include "SubdivisionSchemeTraversal.h"
+
+#include <cstddef>
+#include <utility>
 
 namespace hct
 {
@@ -9,14 +13,135 @@ namespace hct
 	// ==================== StaticGrid =======================
 	/* A type holding a list of integers, representing the dimensions of a grid
 	*/
+	template<unsigned int... S> struct StaticGridProduct;
+	template<> struct StaticGridProduct<>
+	{
+		static constexpr size_t value = 1;
+	};
+	template<unsigned int Head, unsigned int... Tail> struct StaticGridProduct<Head, Tail...>
+	{
+		static constexpr size_t value = Head * StaticGridProduct<Tail...>::value;
+	};
+
+	// branch index from grid location, with extents known at compile time. K is the first component to process
+	template<unsigned int D, unsigned int K, unsigned int... S> struct StaticGridBranch;
+	template<unsigned int D, unsigned int K, unsigned int Head>
+	struct StaticGridBranch<D, K, Head>
+	{
+		static inline size_t branch(const Vec<unsigned int, D>& pos)
+		{
+			return pos.Vec<unsigned int, K + 1>::val;
+		}
+	};
+	template<unsigned int D, unsigned int K, unsigned int Head, unsigned int... Tail>
+	struct StaticGridBranch<D, K, Head, Tail...>
+	{
+		static inline size_t branch(const Vec<unsigned int, D>& pos)
+		{
+			return pos.Vec<unsigned int, K + 1>::val + Head * StaticGridBranch<D, K + 1, Tail...>::branch(pos);
+		}
+	};
+
 	template<unsigned int... S>
 	struct StaticGridDim
 	{
 		static constexpr unsigned int D = sizeof...(S);
+		static constexpr size_t GridSize = StaticGridProduct<S...>::value;
+
 		static inline Vec<unsigned int,D> value()
 		{
 			return Vec<unsigned int, D>({ S... });
 		}
+
+		// extent along component K
+		template<unsigned int K>
+		static constexpr unsigned int extent()
+		{
+			const unsigned int extents[D] = { S... };
+			return extents[K];
+		}
+
+		// component 0 varies fastest, same as GridDimension::branch
+		static inline size_t branch(const Vec<unsigned int, D>& pos)
+		{
+			return StaticGridBranch<D, 0, S...>::branch(pos);
+		}
+
+		// i-th component of the location of branch b
+		static constexpr unsigned int locationComponent(size_t b, unsigned int i)
+		{
+			const unsigned int extents[D] = { S... };
+			for (unsigned int j = 0; j < i; j++) { b /= extents[j]; }
+			return b % extents[i];
+		}
+
+		// inverse of branch
+		static inline Vec<unsigned int, D> location(size_t b)
+		{
+			unsigned int coord[D];
+			for (unsigned int i = 0; i < D; i++) { coord[i] = locationComponent(b, i); }
+			return Vec<unsigned int, D>(coord);
+		}
+
+		// location of a branch known at compile time, components are constants
+		template<size_t B>
+		static inline Vec<unsigned int, D> location()
+		{
+			return constantLocation<B>(std::make_index_sequence<D>());
+		}
+
+	private:
+		template<size_t B, size_t... I>
+		static inline Vec<unsigned int, D> constantLocation(std::index_sequence<I...>)
+		{
+			static constexpr unsigned int coord[D] = { locationComponent(B, I)... };
+			return Vec<unsigned int, D>(coord);
+		}
+	};
+
+	// ==================== StaticGridEnum =======================
+	/* Fully unrolled enumeration of a static grid's locations, in increasing branch order.
+	Grids larger than MaxUnrolledGridSize are enumerated with a loop.
+	*/
+	static constexpr size_t MaxUnrolledGridSize = 64;
+
+	template<typename GridDim, size_t B = 0, bool End = (B >= GridDim::GridSize) >
+	struct StaticGridEnumUnrolled
+	{
+		template<typename FuncT>
+		static inline void enumerate(FuncT& f)
+		{
+			f(GridDim::template location<B>());
+			StaticGridEnumUnrolled<GridDim, B + 1>::enumerate(f);
+		}
+	};
+	template<typename GridDim, size_t B>
+	struct StaticGridEnumUnrolled<GridDim, B, true>
+	{
+		template<typename FuncT>
+		static inline void enumerate(FuncT&) {}
+	};
+
+	template<typename GridDim, bool Unroll = (GridDim::GridSize <= MaxUnrolledGridSize) >
+	struct StaticGridEnum
+	{
+		template<typename FuncT>
+		static inline void enumerate(FuncT& f)
+		{
+			StaticGridEnumUnrolled<GridDim>::enumerate(f);
+		}
+	};
+	template<typename GridDim>
+	struct StaticGridEnum<GridDim, false>
+	{
+		template<typename FuncT>
+		static inline void enumerate(FuncT& f)
+		{
+			for (size_t b = 0; b < GridDim::GridSize; b++)
+			{
+				f(GridDim::location(b));
+			}
+		}
 	};
 
 	template<typename... GridTypes>
@@ -69,6 +194,35 @@ namespace hct
 		}
 	};
 
+	/*
+	All levels share the same compile time grid : child loops are unrolled,
+	and branch indices / child counts are constants, whatever the grid passed in.
+	*/
+	template<unsigned int D, size_t NLevels, unsigned int... S>
+	struct SubdivisionSchemeTraversal< D, StaticSubdivisionScheme<NLevels, S...> >
+	{
+		using GridDim = StaticGridDim<S...>;
+		using SubdivisionGrid = GridDimension<D>;
+		using GridLocation = Vec<unsigned int, D>;
+		static constexpr bool IsStatic = true;
+
+		static inline size_t branch(const SubdivisionGrid&, const GridLocation& location)
+		{
+			return GridDim::branch(location);
+		}
+
+		static inline size_t gridSize(const SubdivisionGrid&)
+		{
+			return GridDim::GridSize;
+		}
+
+		template<typename FuncT>
+		static inline void forEachChildLocation(SubdivisionGrid, FuncT f)
+		{
+			StaticGridEnum<GridDim>::enumerate(f);
+		}
+	};
+
 	template<typename T1, typename T2, bool is_valid=(T1::D==T2::D) >
 	struct StaticSubdivisionSchemeCombo {};
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Vec.h"
+#include "GridDimension.h"
+#include "GridEnum.h"
+
+#include <cstddef>
+
+namespace hct
+{
+
+	/*
+	How a tree iterates over the children of a cell and computes child indices,
+	for a given subdivision scheme.
+	The generic version works with grids known at run time only.
+	Subdivision schemes whose grids are known at compile time specialize it
+	(see StaticSubdivisionScheme.h) so that child loops are unrolled and
+	child indices are computed from constants.
+	*/
+	template<unsigned int D, typename SubdivisionSchemeT>
+	struct SubdivisionSchemeTraversal
+	{
+		using SubdivisionGrid = GridDimension<D>;
+		using GridLocation = Vec<unsigned int, D>;
+		static constexpr bool IsStatic = false;
+
+		static inline size_t branch(const SubdivisionGrid& grid, const GridLocation& location)
+		{
+			return grid.branch(location);
+		}
+
+		static inline size_t gridSize(const SubdivisionGrid& grid)
+		{
+			return grid.gridSize();
+		}
+
+		// calls f(location) for each location of grid, in increasing branch order
+		template<typename FuncT>
+		static inline void forEachChildLocation(SubdivisionGrid grid, FuncT f)
+		{
+			ForEachGridLocation(grid, f);
+		}
+	};
+
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeCellPosition.h"
+#include "HyperCubeTreeNeighborCursor.h"
+#include "TreeLevelArray.h"
+#include "LeafArray.h"
+#include "TreeBalance.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	Adaptation of a tree to an error indicator evaluated on cells : one call refines leaves whose indicator is above a threshold,
+	coarsens groups of sibling leaves whose indicators are all below a lower threshold, then restores the level jump balance.
+	Called after each step (or every few steps) of a simulation, it makes the finest leaves follow solution features.
+
+	Thresholds give hysteresis : a leaf is refined when its indicator goes above m_refineThreshold,
+	but only coarsened when it falls below m_coarsenThreshold, so leaves near a threshold do not flip at each call.
+	Refinement stops at m_maxLevel, coarsening at m_minLevel.
+	Coarsening never breaks the balance : siblings are only merged when none of their neighbors
+	is refined or about to be (for a maximum level jump of 1).
+	Field data follow through refinement listeners (see TreeFieldTransfer.h).
+
+	Marking reads the tree only, in one pre-order traversal with a neighbor cursor : indicators, and the neighbors
+	that block coarsening, are read from the cursor's neighborhood and written into leaf arrays.
+	*/
+	template<typename Tree>
+	struct TreeAdaptation
+	{
+		static constexpr unsigned int D = Tree::D;
+		using Cell = HyperCubeTreeCell;
+		using CellPosition = HyperCubeTreeCellPosition<D>;
+		using NbhCursor = HyperCubeTreeNeighborCursor<Tree>;
+		using HCubeComponentValue = typename NbhCursor::HCubeComponentValue;
+
+		enum Mark : int8_t
+		{
+			Coarsen = -1,
+			Keep = 0,
+			Refine = 1
+		};
+
+		struct Parameters
+		{
+			double m_refineThreshold = 0.8;
+			double m_coarsenThreshold = 0.2;
+			size_t m_minLevel = 0;
+			size_t m_maxLevel = 0;
+			size_t m_maxLevelJump = 1; // 0 : no balance enforcement
+		};
+
+		struct Result
+		{
+			size_t m_refined = 0;
+			size_t m_coarsened = 0; // number of coarsened cells (groups of siblings)
+			size_t m_balanced = 0; // refinements added to restore the balance
+		};
+
+		/*
+		Normalized second difference of a field along each axis (Lohner's estimator), maximum over axes, in [0,1].
+		For a cell value u and face neighbor values ul, ur at center distances dl, dr, with gradients gl=(u-ul)/dl, gr=(ur-u)/dr :
+			|gr - gl| / ( |gr| + |gl| + epsilon * (|ur|/dr + |u|/dr + |u|/dl + |ul|/dl) )
+		epsilon filters small ripples. Smooth regions give values close to 0, discontinuities values close to 1.
+		It is evaluated on a neighbor cursor, on any cell : neighbors are cells of the same level or coarser leaves, so field values have
+		to be defined on refined cells too (see TreeFieldTransfer::restrictFields). A missing neighbor (domain boundary) takes the cell's value.
+		*/
+		template<typename T>
+		struct JumpIndicator
+		{
+			inline JumpIndicator(const TreeLevelArray<T>& field, double epsilon = 0.01)
+				: m_field(field), m_epsilon(epsilon) {}
+
+			inline double operator () (const NbhCursor& cursor) const
+			{
+				CellPosition position = cursor.position();
+				double u = m_field[cursor.cell()];
+				double value[D][2], distance[D][2];
+				for (unsigned int a = 0; a < D; a++)
+				{
+					value[a][0] = value[a][1] = u;
+					distance[a][0] = distance[a][1] = 1.0;
+				}
+				cursor.m_nbh.forEachComponent([&](const HCubeComponentValue& nbh, auto comp)
+				{
+					if (!NbhCursor::isFace(comp) || !nbh.m_cell.isTreeCell()) { return; }
+					unsigned int axis = NbhCursor::faceAxis(comp);
+					unsigned int side = NbhCursor::faceSide(comp);
+					value[axis][side] = m_field[nbh.m_cell];
+					distance[axis][side] = std::abs(position.centerDistance(nbh.m_position, axis));
+				});
+
+				double e = 0.0;
+				for (unsigned int a = 0; a < D; a++)
+				{
+					double gl = (u - value[a][0]) / distance[a][0];
+					double gr = (value[a][1] - u) / distance[a][1];
+					double noise = m_epsilon * ((std::abs(value[a][1]) + std::abs(u)) / distance[a][1] + (std::abs(u) + std::abs(value[a][0])) / distance[a][0]);
+					double den = std::abs(gr) + std::abs(gl) + noise;
+					if (den > 0.0) { e = std::max(e, std::abs(gr - gl) / den); }
+				}
+				return e;
+			}
+
+			const TreeLevelArray<T>& m_field;
+			double m_epsilon;
+		};
+
+		/*
+		Refine / coarsen / keep decision of each leaf, from indicator(const NbhCursor&) -> double.
+		Coarsen marks are set on all leaves of a group of siblings or none : the group is merged when every sibling
+		is below m_coarsenThreshold, and so is their parent. Without the parent's check, a feature seen by a cell
+		but by none of its children (a jump across the cell's face that lies beyond its children's neighbors)
+		would make the cell alternate between refinement and coarsening.
+		The indicator is evaluated once per leaf, and once per cell whose children are all leaves.
+		*/
+		template<typename IndicatorT>
+		static inline void mark(const Tree& tree, IndicatorT indicator, const Parameters& params, LeafArray<int8_t>& marks)
+		{
+			assert(params.m_coarsenThreshold <= params.m_refineThreshold);
+			tree.updateLeafIndex();
+			size_t nLeaves = tree.getNumberOfLeaves();
+			size_t maxLevel = std::min(params.m_maxLevel, tree.getNumberOfLevels() - 1);
+			bool checkBalance = (params.m_maxLevelJump > 0);
+
+			// candidates from thresholds and level limits. a coarsening candidate is blocked when its neighbors would be
+			// too fine once its parent is a leaf (conservatively, any refined neighbor, or a same level neighbor to be refined
+			// for a maximum jump of 1, checked once all candidates are known)
+			LeafArray<int8_t> candidate, blocked;
+			LeafArray<double> parentIndicator; // indicator of the parent of each first child, when all siblings are leaves
+			tree.fitLeafArray(&candidate);
+			tree.fitLeafArray(&blocked);
+			tree.fitLeafArray(&parentIndicator);
+			std::vector<size_t> sameLevelPairs; // (coarsening candidate, same level neighbor leaf) pairs
+			tree.preorderParseCells([&](const NbhCursor& cursor)
+			{
+				Cell cell = cursor.cell();
+				if (!tree.isLeaf(cell))
+				{
+					size_t nbChildren = tree.getLevelSubdivisionGrid(cell.level()).gridSize();
+					for (size_t c = 0; c < nbChildren; c++)
+					{
+						if (!tree.isLeaf(tree.child(cell, c))) { return; }
+					}
+					parentIndicator[tree.leafIndex(tree.child(cell, static_cast<size_t>(0)))] = indicator(cursor);
+					return;
+				}
+				size_t i = tree.leafIndex(cell);
+				double e = indicator(cursor);
+				int8_t m = Keep;
+				if (e > params.m_refineThreshold && cell.level() < maxLevel) { m = Refine; }
+				else if (e < params.m_coarsenThreshold && cell.level() > params.m_minLevel) { m = Coarsen; }
+				candidate[i] = m;
+				blocked[i] = 0;
+				if (m != Coarsen || !checkBalance) { return; }
+				cursor.m_nbh.forEachValue([&](const HCubeComponentValue& nbh)
+				{
+					if (!nbh.m_cell.isTreeCell() || nbh.m_cell == cell) { return; }
+					if (!tree.isLeaf(nbh.m_cell)) { blocked[i] = 1; }
+					else if (nbh.m_cell.level() == cell.level() && params.m_maxLevelJump <= 1)
+					{
+						sameLevelPairs.push_back(i);
+						sameLevelPairs.push_back(tree.leafIndex(nbh.m_cell));
+					}
+				});
+			}
+			, NbhCursor());
+			for (size_t k = 0; k < sameLevelPairs.size(); k += 2)
+			{
+				if (candidate[sameLevelPairs[k + 1]] == Refine) { blocked[sameLevelPairs[k]] = 1; }
+			}
+
+			// group decision, taken by the first sibling
+			LeafArray<int8_t> group;
+			tree.fitLeafArray(&group);
+			tree.forEachLeaf([&](size_t i, Cell cell)
+			{
+				group[i] = 0;
+				if (candidate[i] != Coarsen) { return; }
+				Cell parent = tree.parent(cell);
+				if (!(tree.child(parent, static_cast<size_t>(0)) == cell)) { return; }
+				size_t nbChildren = tree.getLevelSubdivisionGrid(parent.level()).gridSize();
+				bool ok = true;
+				for (size_t c = 0; c < nbChildren && ok; c++)
+				{
+					Cell sibling = tree.child(parent, c);
+					ok = tree.isLeaf(sibling) && candidate[tree.leafIndex(sibling)] == Coarsen && !blocked[tree.leafIndex(sibling)];
+				}
+				group[i] = (ok && parentIndicator[i] < params.m_coarsenThreshold) ? 1 : 0;
+			});
+
+			marks.resize(nLeaves);
+			tree.forEachLeaf([&](size_t i, Cell cell)
+			{
+				int8_t m = candidate[i];
+				if (m == Coarsen)
+				{
+					Cell first = tree.child(tree.parent(cell), static_cast<size_t>(0));
+					if (!tree.isLeaf(first) || !group[tree.leafIndex(first)]) { m = Keep; }
+				}
+				marks[i] = m;
+			});
+		}
+
+		// applies marks computed on the current tree
+		static inline Result adapt(Tree& tree, const LeafArray<int8_t>& marks, const Parameters& params)
+		{
+			std::vector<Cell> refine, coarsen;
+			tree.forEachLeaf([&](size_t i, Cell cell)
+			{
+				if (marks[i] == Refine) { refine.push_back(cell); }
+				else if (marks[i] == Coarsen)
+				{
+					Cell parent = tree.parent(cell);
+					if (tree.child(parent, static_cast<size_t>(0)) == cell) { coarsen.push_back(parent); }
+				}
+			});
+
+			Result result;
+			for (Cell cell : refine) { tree.refine(cell); }
+			result.m_refined = refine.size();
+			tree.coarsen(coarsen);
+			result.m_coarsened = coarsen.size();
+			if (params.m_maxLevelJump > 0) { result.m_balanced = balance(tree, params.m_maxLevelJump); }
+			return result;
+		}
+
+		template<typename IndicatorT>
+		static inline Result adapt(Tree& tree, IndicatorT indicator, const Parameters& params)
+		{
+			LeafArray<int8_t> marks;
+			mark(tree, indicator, params, marks);
+			return adapt(tree, marks, params);
+		}
+
+		// adaptation to the jumps of a field
+		template<typename T>
+		static inline Result adapt(Tree& tree, const TreeLevelArray<T>& field, const Parameters& params, double epsilon = 0.01)
+		{
+			return adapt(tree, JumpIndicator<T>(field, epsilon), params);
+		}
+
+	};
+
+	template<typename Tree, typename IndicatorT>
+	static inline typename TreeAdaptation<Tree>::Result adapt(Tree& tree, IndicatorT indicator, const typename TreeAdaptation<Tree>::Parameters& params)
+	{
+		return TreeAdaptation<Tree>::adapt(tree, indicator, params);
+	}
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeCellPosition.h"
+#include "HyperCubeTreeNeighborCursor.h"
+#include "GridEnum.h"
+#include "Vec.h"
+
+#include <cstddef>
+#include <vector>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	Balance enforcement : refines the tree until any two adjacent leaves (sharing a face, an edge or a vertex)
+	differ by at most maxLevelJump levels (maxLevelJump=1 gives the usual 2:1 balance).
+
+	Each violation involves a fine leaf and a coarse neighbor leaf, so only fine leaves need to check their neighbors,
+	and a leaf can only become violating when it is created. The algorithm is a ripple propagation :
+	- one read-only traversal with neighbor cursors finds initially violating leaves, bucketed by level
+	- levels are processed from finest to coarsest. Refining a coarse neighbor creates leaves at a coarser level
+	  than the one being processed, so they are pushed on a later worklist and no level is visited twice.
+	- within a level, neighbor checks are independent and read-only (parallel loop), refinements are applied serially.
+	  A leaf stays in its level's worklist until all its coarse neighbors are fine enough.
+
+	Returns the number of refined cells.
+	*/
+	template<typename Tree>
+	struct TreeBalance
+	{
+		static constexpr unsigned int D = Tree::D;
+		using Cell = HyperCubeTreeCell;
+		using CellPosition = HyperCubeTreeCellPosition<D>;
+		using NbhCursor = HyperCubeTreeNeighborCursor<Tree>;
+		using HCubeComponentValue = typename NbhCursor::HCubeComponentValue;
+		using SubdivisionGrid = typename Tree::SubdivisionGrid;
+		using GridLocation = typename Tree::GridLocation;
+
+		struct LeafItem
+		{
+			Cell m_cell;
+			CellPosition m_position;
+		};
+
+		// neighbor cursor of the cell at position, found by descending from the root
+		static inline NbhCursor locate(const Tree& tree, const CellPosition& position, size_t level)
+		{
+			NbhCursor cursor;
+			for (size_t l = 0; l < level; l++)
+			{
+				SubdivisionGrid grid = tree.getLevelSubdivisionGrid(l);
+				CellPosition childPos = cursor.position().refine(grid);
+				Vec<size_t, D> target = position.m_position / (position.m_resolution / childPos.m_resolution);
+				GridLocation childLocation = target - childPos.m_position;
+				cursor = NbhCursor(tree, cursor, grid, childLocation);
+			}
+			return cursor;
+		}
+
+		// collects neighbors of cursor that are too coarse
+		static inline void coarseNeighbors(const NbhCursor& cursor, size_t maxLevelJump, std::vector<LeafItem>& result)
+		{
+			size_t level = cursor.cell().level();
+			cursor.m_nbh.forEachValue([level, maxLevelJump, &result](const HCubeComponentValue& nbh)
+			{
+				if (nbh.m_cell.isTreeCell() && (nbh.m_cell.level() + maxLevelJump) < level)
+				{
+					result.push_back(LeafItem{ nbh.m_cell, nbh.m_position });
+				}
+			});
+		}
+
+		static inline size_t balance(Tree& tree, size_t maxLevelJump)
+		{
+			assert(maxLevelJump >= 1);
+			size_t nLevels = tree.getNumberOfLevels();
+			std::vector< std::vector<LeafItem> > worklist(nLevels);
+
+			// initial violations
+			std::vector<LeafItem> tooCoarse;
+			tree.parseLeaves([maxLevelJump, &worklist, &tooCoarse](const NbhCursor& cursor)
+			{
+				tooCoarse.clear();
+				coarseNeighbors(cursor, maxLevelJump, tooCoarse);
+				if (!tooCoarse.empty())
+				{
+					worklist[cursor.cell().level()].push_back(LeafItem{ cursor.cell(), cursor.position() });
+				}
+			}, NbhCursor());
+
+			size_t nRefined = 0;
+			for (size_t l = nLevels; l-- > (maxLevelJump + 1); )
+			{
+				std::vector<LeafItem> items;
+				items.swap(worklist[l]);
+				while (!items.empty())
+				{
+					// parallel, read-only : find too coarse neighbors of each leaf
+					std::vector< std::vector<LeafItem> > refineTargets(items.size());
+					const Tree& ctree = tree;
+					long nItems = static_cast<long>(items.size());
+#					pragma omp parallel for schedule(dynamic,64)
+					for (long i = 0; i < nItems; i++)
+					{
+						if (ctree.isLeaf(items[i].m_cell))
+						{
+							coarseNeighbors(locate(ctree, items[i].m_position, l), maxLevelJump, refineTargets[i]);
+						}
+					}
+
+					// serial : refine, new leaves go to coarser levels' worklists
+					std::vector<LeafItem> remaining;
+					for (size_t i = 0; i < items.size(); i++)
+					{
+						if (refineTargets[i].empty()) { continue; }
+						for (const LeafItem& target : refineTargets[i])
+						{
+							if (!tree.isLeaf(target.m_cell)) { continue; } // already refined for another leaf
+							SubdivisionGrid grid = tree.getLevelSubdivisionGrid(target.m_cell.level());
+							tree.refine(target.m_cell);
+							++nRefined;
+							size_t childLevel = target.m_cell.level() + 1;
+							assert(childLevel < l);
+							ForEachGridLocation(grid, [&tree, &worklist, &target, grid, childLevel](GridLocation loc)
+							{
+								worklist[childLevel].push_back(LeafItem{ tree.child(target.m_cell, loc), target.m_position.refine(grid) + loc });
+							});
+						}
+						// a neighbor may need several refinements, check this leaf again
+						remaining.push_back(items[i]);
+					}
+					items.swap(remaining);
+				}
+			}
+
+			return nRefined;
+		}
+	};
+
+	template<typename Tree>
+	static inline size_t balance(Tree& tree, size_t maxLevelJump = 1)
+	{
+		return TreeBalance<Tree>::balance(tree, maxLevelJump);
+	}
+
+}
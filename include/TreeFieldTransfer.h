@@ -0,0 +1,288 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeCellPosition.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "ITreeRefinementListener.h"
+#include "TreeLevelArray.h"
+#include "Vec.h"
+
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <assert.h>
+
+namespace hct
+{
+
+	// access to the scalar components of a field value, for the transfer operators
+	template<typename T>
+	struct TransferValueTraits
+	{
+		using Scalar = T;
+		static constexpr size_t NumberOfComponents = 1;
+		static inline Scalar* components(T* values) { return values; }
+	};
+
+	template<typename T, size_t N>
+	struct TransferValueTraits< std::array<T, N> >
+	{
+		using Scalar = T;
+		static constexpr size_t NumberOfComponents = N;
+		static inline Scalar* components(std::array<T, N>* values) { return values->data(); }
+	};
+
+	/*
+	Conservative transfer of cell fields between levels. Children of a cell have equal volumes.
+
+	Restriction : a parent gets the average of its children.
+	Prolongation : new children get a linear reconstruction of their parent's value,
+	value + sum over axes of slope * (child center - parent center).
+	Each axis' slope is the minmod of the one sided differences with the parent's face neighbors
+	(cells of the parent's level, or coarser leaves), and zero at the domain boundary.
+	Slopes are then scaled down so that no child exceeds the range of the parent and its neighbors (Barth-Jespersen),
+	which keeps prolongation free of new extrema. Child offsets sum to zero along each axis, so the average of the
+	children is the parent's value : prolongation followed by restriction is the identity.
+
+	Both operators work on the contiguous block of a cell's children (a component's loop over the block vectorizes).
+	Registered as a refinement listener, the transfer runs automatically when the tree refines or coarsens a cell.
+	Prolongation reads neighbor values at the parent's level : when only leaves are kept up to date,
+	call restrictFields() before refining so that refined neighbors hold the average of their leaves.
+
+	Scalar fields and std::array fields of floating point values are supported.
+	*/
+	template<typename _Tree>
+	class TreeFieldTransfer : public ITreeRefinementListener
+	{
+	public:
+		using Tree = _Tree;
+		static constexpr unsigned int D = Tree::D;
+		using Cell = HyperCubeTreeCell;
+		using CellPosition = HyperCubeTreeCellPosition<D>;
+		using LocatedCursor = HyperCubeTreeLocatedCursor<Tree>;
+		using SubdivisionGrid = typename Tree::SubdivisionGrid;
+		using GridLocation = typename Tree::GridLocation;
+
+		enum class Prolongation
+		{
+			Constant,		// children get the parent's value
+			LimitedLinear
+		};
+
+		inline TreeFieldTransfer(Tree& tree)
+			: m_tree(tree)
+		{
+			m_tree.addRefinementListener(this);
+		}
+
+		inline ~TreeFieldTransfer()
+		{
+			m_tree.removeRefinementListener(this);
+		}
+
+		TreeFieldTransfer(const TreeFieldTransfer&) = delete;
+		TreeFieldTransfer& operator = (const TreeFieldTransfer&) = delete;
+
+		// array has to be attached to the tree (see HyperCubeTree::addArray)
+		template<typename T>
+		inline void addField(TreeLevelArray<T>* array, Prolongation prolongation = Prolongation::LimitedLinear)
+		{
+			m_fields.push_back(std::unique_ptr<IField>(new Field<T>(array, prolongation)));
+		}
+
+		inline size_t numberOfFields() const { return m_fields.size(); }
+
+		// parent values from children values, for every refined cell, finest levels first
+		inline void restrictFields()
+		{
+			size_t nLevels = m_tree.getNumberOfLevels();
+			for (size_t l = nLevels - 1; l-- > 0;)
+			{
+				int64_t n = m_tree.getLevelSize(l);
+				size_t nbChildren = m_tree.getLevelSubdivisionGrid(l).gridSize();
+#				pragma omp parallel for schedule(static)
+				for (int64_t i = 0; i < n; i++)
+				{
+					Cell cell(l, i);
+					if (m_tree.isLeaf(cell)) { continue; }
+					size_t first = m_tree.child(cell, static_cast<size_t>(0)).index();
+					for (auto& f : m_fields) { f->restrictCell(cell, first, nbChildren); }
+				}
+			}
+		}
+
+		inline void cellRefined(Cell cell) override
+		{
+			if (m_fields.empty()) { return; }
+			Stencil stencil;
+			buildStencil(cell, stencil);
+			for (auto& f : m_fields) { f->prolongCell(cell, stencil); }
+		}
+
+		inline void cellCoarsening(Cell cell) override
+		{
+			size_t first = m_tree.child(cell, static_cast<size_t>(0)).index();
+			size_t nbChildren = m_tree.getLevelSubdivisionGrid(cell.level()).gridSize();
+			for (auto& f : m_fields) { f->restrictCell(cell, first, nbChildren); }
+		}
+
+	private:
+		/*
+		Geometry of a prolongation, shared by all fields :
+		face neighbors of the parent and their center distance along the axis, in parent cell sizes,
+		children offsets from the parent center along each axis (m_offset[a * nbChildren + child]), in parent cell sizes
+		*/
+		struct Stencil
+		{
+			size_t m_firstChild = 0;
+			size_t m_nbChildren = 0;
+			Cell m_neighbor[D][2];
+			bool m_hasNeighbor[D][2];
+			double m_distance[D][2];
+			double m_maxOffset[D];
+			std::vector<double> m_offset;
+		};
+
+		struct IField
+		{
+			virtual ~IField() {}
+			virtual void restrictCell(Cell cell, size_t firstChild, size_t nbChildren) = 0;
+			virtual void prolongCell(Cell cell, const Stencil& stencil) = 0;
+		};
+
+		template<typename T>
+		struct Field : public IField
+		{
+			using Traits = TransferValueTraits<T>;
+			using Scalar = typename Traits::Scalar;
+			static constexpr size_t NC = Traits::NumberOfComponents;
+
+			inline Field(TreeLevelArray<T>* array, Prolongation prolongation)
+				: m_array(array), m_prolongation(prolongation) {}
+
+			inline void restrictCell(Cell cell, size_t firstChild, size_t nbChildren) override
+			{
+				const Scalar* children = Traits::components((*m_array)[cell.level() + 1].data() + firstChild);
+				Scalar* parent = Traits::components(&(*m_array)[cell]);
+				Scalar scale = Scalar(1) / static_cast<Scalar>(nbChildren);
+				for (size_t c = 0; c < NC; c++)
+				{
+					Scalar sum = 0;
+					for (size_t i = 0; i < nbChildren; i++) { sum += children[i * NC + c]; }
+					parent[c] = sum * scale;
+				}
+			}
+
+			inline void prolongCell(Cell cell, const Stencil& stencil) override
+			{
+				const Scalar* parent = Traits::components(&(*m_array)[cell]);
+				Scalar* children = Traits::components((*m_array)[cell.level() + 1].data() + stencil.m_firstChild);
+				size_t nbChildren = stencil.m_nbChildren;
+				for (size_t c = 0; c < NC; c++)
+				{
+					Scalar v = parent[c];
+					for (size_t i = 0; i < nbChildren; i++) { children[i * NC + c] = v; }
+					if (m_prolongation == Prolongation::Constant) { continue; }
+
+					double slope[D];
+					double vmin = v, vmax = v;
+					double deviation = 0.0;
+					for (unsigned int a = 0; a < D; a++)
+					{
+						double s[2] = { 0.0, 0.0 };
+						for (int side = 0; side < 2; side++)
+						{
+							if (!stencil.m_hasNeighbor[a][side]) { continue; }
+							double vn = Traits::components(&(*m_array)[stencil.m_neighbor[a][side]])[c];
+							s[side] = (vn - v) / stencil.m_distance[a][side];
+							vmin = std::min(vmin, vn);
+							vmax = std::max(vmax, vn);
+						}
+						slope[a] = (s[0] * s[1] > 0.0) ? ((std::abs(s[0]) < std::abs(s[1])) ? s[0] : s[1]) : 0.0;
+						deviation += std::abs(slope[a]) * stencil.m_maxOffset[a];
+					}
+					if (deviation <= 0.0) { continue; }
+					double alpha = std::min(1.0, std::min(vmax - v, v - vmin) / deviation);
+					for (unsigned int a = 0; a < D; a++)
+					{
+						Scalar s = static_cast<Scalar>(alpha * slope[a]);
+						const double* offset = stencil.m_offset.data() + a * nbChildren;
+						for (size_t i = 0; i < nbChildren; i++) { children[i * NC + c] += s * static_cast<Scalar>(offset[i]); }
+					}
+				}
+			}
+
+			TreeLevelArray<T>* m_array;
+			Prolongation m_prolongation;
+		};
+
+		// deepest cell containing position, at most at position's level
+		inline Cell locate(const CellPosition& position, size_t level) const
+		{
+			LocatedCursor cursor;
+			for (size_t l = 0; l < level && !m_tree.isLeaf(cursor.cell()); l++)
+			{
+				SubdivisionGrid grid = m_tree.getLevelSubdivisionGrid(l);
+				CellPosition childPos = cursor.position().refine(grid);
+				Vec<size_t, D> target = position.m_position / (position.m_resolution / childPos.m_resolution);
+				GridLocation childLocation = target - childPos.m_position;
+				cursor = LocatedCursor(m_tree, cursor, grid, childLocation);
+			}
+			return cursor.cell();
+		}
+
+		inline void buildStencil(Cell cell, Stencil& stencil) const
+		{
+			size_t level = cell.level();
+			SubdivisionGrid grid = m_tree.getLevelSubdivisionGrid(level);
+			stencil.m_firstChild = m_tree.child(cell, static_cast<size_t>(0)).index();
+			stencil.m_nbChildren = grid.gridSize();
+
+			unsigned int g[D];
+			grid.toArray(g);
+			for (unsigned int a = 0; a < D; a++)
+			{
+				stencil.m_maxOffset[a] = (g[a] - 1) / (2.0 * g[a]);
+			}
+			stencil.m_offset.resize(D * stencil.m_nbChildren);
+			for (size_t i = 0; i < stencil.m_nbChildren; i++)
+			{
+				size_t branch = i;
+				for (unsigned int a = 0; a < D; a++)
+				{
+					stencil.m_offset[a * stencil.m_nbChildren + i] = ((branch % g[a]) + 0.5) / g[a] - 0.5;
+					branch /= g[a];
+				}
+			}
+
+			CellPosition position = m_tree.cellPosition(cell);
+			size_t p[D], r[D];
+			position.m_position.toArray(p);
+			position.m_resolution.toArray(r);
+			for (unsigned int a = 0; a < D; a++)
+			{
+				for (int side = 0; side < 2; side++)
+				{
+					stencil.m_hasNeighbor[a][side] = (side == 0) ? (p[a] > 0) : ((p[a] + 1) < r[a]);
+					if (!stencil.m_hasNeighbor[a][side]) { continue; }
+					size_t q[D];
+					std::copy(p, p + D, q);
+					q[a] = (side == 0) ? (p[a] - 1) : (p[a] + 1);
+					CellPosition neighborPosition(Vec<size_t, D>(q), position.m_resolution);
+					Cell neighbor = locate(neighborPosition, level);
+					stencil.m_neighbor[a][side] = neighbor;
+
+					// center distance along the axis, in parent cell sizes (neighbor may be coarser)
+					stencil.m_distance[a][side] = position.centerDistance(m_tree.cellPosition(neighbor), a);
+				}
+			}
+		}
+
+		Tree& m_tree;
+		std::vector< std::unique_ptr<IField> > m_fields;
+	};
+
+}
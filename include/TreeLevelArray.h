@@ -2,6 +2,7 @@
 
 #include "HyperCubeTreeCell.h"
 #include "ITreeLevelArray.h"
+#include "NumericalValueTraits.h"
 
 #include <cstdlib>
 #include <string>
@@ -63,6 +64,24 @@ namespace hct
 				m_arrays[level].erase( m_arrays[level].begin()+position, m_arrays[level].begin()+position+nElems );
 			}
 			
+			inline void compact(size_t level, const std::vector<bool>& keep) override final
+			{
+				assert( level<m_arrays.size() );
+				assert( keep.size() == m_arrays[level].size() );
+				std::vector<T>& a = m_arrays[level];
+				size_t n = a.size();
+				size_t j = 0;
+				for (size_t i = 0; i < n; i++)
+				{
+					if (keep[i])
+					{
+						if (j != i) { a[j] = a[i]; }
+						++j;
+					}
+				}
+				a.resize(j);
+			}
+
 			inline void fill(const T& value)
 			{
 				for (auto& a : m_arrays) for (auto& x : a) { x = value; }
@@ -70,8 +89,7 @@ namespace hct
 
 			inline std::ostream& printCell(std::ostream& out, HyperCubeTreeCell cell) const override final
 			{
-				out << m_arrays[cell.level()][cell.index()];
-				return out;
+				return NumericalValueTraits<T>::toStream(out, m_arrays[cell.level()][cell.index()]);
 			}
 
 			size_t numberOfComponents() const override final
@@ -62,6 +62,17 @@ namespace hct
 				for (auto a : m_level_arrays) { a->erase(level, position, nElems); }
 			}
 
+			// removes cells of a level whose keep flag is false, in one pass over each array
+			inline void compact(size_t level, const std::vector<bool>& keep)
+			{
+				assert( level < getNumberOfLevels() );
+				assert( keep.size() == m_level_sizes[level] );
+				size_t n = 0;
+				for (bool k : keep) { if (k) { ++n; } }
+				m_level_sizes[level] = n;
+				for (auto a : m_level_arrays) { a->compact(level, keep); }
+			}
+
 			// does not actually add the array, but resizes it so that it fits the level sizes
 			inline void fitArray(ITreeLevelArray* a) const
 			{
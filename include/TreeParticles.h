@@ -0,0 +1,267 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "HyperCubeTreeCell.h"
+#include "HyperCubeTreeCellPosition.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "ITreeRefinementListener.h"
+#include "LeafArray.h"
+#include "Vec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <assert.h>
+
+namespace hct
+{
+
+	struct NoParticleAttribute {};
+
+	/*
+	Particles (a position, a stable id and an attribute each) binned into the leaves of a tree.
+
+	After update(), particles are stored in leaf order : the particles of leaf i are the contiguous range
+	[leafBegin(i), leafEnd(i)), so per-leaf loops read contiguous memory. Particle indices change at each update, ids don't.
+
+	Each particle remembers its leaf, so update() only locates particles that left it :
+	from the old leaf, up to the first ancestor containing the new position, then down to the leaf.
+	Sorting is a stable counting sort on leaf indices : an update costs O(particles + leaves), never a full re-sort.
+
+	The container is a refinement listener of the tree : particles of a refined leaf are moved down to its children
+	at the next update, particles of coarsened cells go to their parent, and cell renumbering by coarsening is followed.
+	Particles leaving the domain are removed by update().
+	*/
+	template<typename _Tree, typename _Attribute = NoParticleAttribute>
+	class TreeParticles : public ITreeRefinementListener
+	{
+	public:
+		using Tree = _Tree;
+		using Attribute = _Attribute;
+		static constexpr unsigned int D = Tree::D;
+		using Cell = HyperCubeTreeCell;
+		using CellPosition = HyperCubeTreeCellPosition<D>;
+		using LocatedCursor = HyperCubeTreeLocatedCursor<Tree>;
+		using GridLocation = typename Tree::GridLocation;
+		using VecD = Vec<double, D>;
+
+		inline TreeParticles(Tree& tree, const VecD& origin, const VecD& domainSize)
+			: m_tree(tree)
+			, m_origin(origin)
+			, m_domainSize(domainSize)
+		{
+			m_tree.addRefinementListener(this);
+		}
+
+		inline ~TreeParticles()
+		{
+			m_tree.removeRefinementListener(this);
+		}
+
+		TreeParticles(const TreeParticles&) = delete;
+		TreeParticles& operator = (const TreeParticles&) = delete;
+
+		// adds a particle, binned at the next update. returns its id
+		inline size_t add(const VecD& position, const Attribute& attribute = Attribute())
+		{
+			m_position.push_back(position);
+			m_attribute.push_back(attribute);
+			m_id.push_back(m_nextId);
+			m_cell.push_back(Tree::rootCell());
+			return m_nextId++;
+		}
+
+		inline size_t size() const { return m_position.size(); }
+
+		inline VecD& position(size_t i) { return m_position[i]; }
+		inline const VecD& position(size_t i) const { return m_position[i]; }
+		inline Attribute& attribute(size_t i) { return m_attribute[i]; }
+		inline const Attribute& attribute(size_t i) const { return m_attribute[i]; }
+		inline size_t id(size_t i) const { return m_id[i]; }
+		inline Cell cell(size_t i) const { return m_cell[i]; }
+
+		// particles of a leaf, valid until the next update or topology change
+		inline size_t leafBegin(size_t leaf) const { return m_leafOffset[leaf]; }
+		inline size_t leafEnd(size_t leaf) const { return m_leafOffset[leaf + 1]; }
+		inline size_t numberOfParticles(size_t leaf) const { return leafEnd(leaf) - leafBegin(leaf); }
+
+		template<typename FuncT>
+		inline void forEachParticle(size_t leaf, FuncT f) const
+		{
+			for (size_t i = leafBegin(leaf); i < leafEnd(leaf); i++) { f(i); }
+		}
+
+		// particles located by the last update (new, moved to another leaf, or on a changed part of the tree)
+		inline size_t numberOfLocatedParticles() const { return m_located; }
+
+		// bins particles after moves, additions or topology changes. returns the number of particles removed (out of the domain)
+		inline size_t update()
+		{
+			m_tree.updateLeafIndex();
+			size_t nLeaves = m_tree.getNumberOfLeaves();
+			if (m_topologyChanged || m_leafPosition.size() != nLeaves)
+			{
+				m_tree.fitLeafArray(&m_leafPosition);
+				m_tree.parseLeaves([this](const LocatedCursor& cursor) { m_leafPosition[m_tree.leafIndex(cursor.cell())] = cursor.position(); }, LocatedCursor());
+				m_topologyChanged = false;
+			}
+
+			int64_t n = size();
+			std::vector<size_t> key(n);
+			size_t located = 0;
+#			pragma omp parallel for schedule(static) reduction(+:located)
+			for (int64_t i = 0; i < n; i++)
+			{
+				double u[D];
+				if (!normalize(m_position[i], u)) { key[i] = nLeaves; continue; }
+				Cell c = m_cell[i];
+				if (m_tree.isLeaf(c) && contains(m_leafPosition[m_tree.leafIndex(c)], u))
+				{
+					key[i] = m_tree.leafIndex(c);
+					continue;
+				}
+				c = locate(c, u);
+				m_cell[i] = c;
+				key[i] = m_tree.leafIndex(c);
+				++located;
+			}
+			m_located = located;
+
+			// stable counting sort on leaf index, removed particles (key nLeaves) at the end
+			m_leafOffset.assign(nLeaves + 3, 0);
+			bool sorted = true;
+			for (int64_t i = 0; i < n; i++)
+			{
+				++m_leafOffset[key[i] + 2];
+				if (i > 0 && key[i] < key[i - 1]) { sorted = false; }
+			}
+			size_t removed = m_leafOffset[nLeaves + 2];
+			for (size_t k = 2; k < nLeaves + 3; k++) { m_leafOffset[k] += m_leafOffset[k - 1]; }
+			if (sorted)
+			{
+				m_leafOffset.erase(m_leafOffset.begin());
+			}
+			else
+			{
+				std::vector<size_t> order(n);
+				for (int64_t i = 0; i < n; i++) { order[m_leafOffset[key[i] + 1]++] = i; }
+				permute(m_position, order);
+				permute(m_attribute, order);
+				permute(m_id, order);
+				permute(m_cell, order);
+			}
+			m_leafOffset.resize(nLeaves + 1);
+			size_t kept = n - removed;
+			m_position.resize(kept);
+			m_attribute.resize(kept);
+			m_id.resize(kept);
+			m_cell.resize(kept);
+			return removed;
+		}
+
+		inline void cellRefined(Cell) override { m_topologyChanged = true; }
+		inline void cellCoarsening(Cell) override { m_topologyChanged = true; }
+
+		inline void levelRenumbered(size_t level, const std::vector<int64_t>& newIndex) override
+		{
+			m_topologyChanged = true;
+			int64_t n = size();
+#			pragma omp parallel for schedule(static)
+			for (int64_t i = 0; i < n; i++)
+			{
+				Cell c = m_cell[i];
+				if (c.level() != level) { continue; }
+				int64_t j = newIndex[c.index()];
+				m_cell[i] = (j >= 0) ? Cell(level, j) : m_tree.parent(c);
+			}
+		}
+
+	private:
+		// position in [0,1)^D, false if out of the domain
+		inline bool normalize(const VecD& x, double* u) const
+		{
+			((x - m_origin) / m_domainSize).toArray(u);
+			for (unsigned int a = 0; a < D; a++)
+			{
+				if (!(u[a] >= 0.0 && u[a] < 1.0)) { return false; }
+			}
+			return true;
+		}
+
+		static inline bool contains(const CellPosition& position, const double* u)
+		{
+			size_t p[D], r[D];
+			position.m_position.toArray(p);
+			position.m_resolution.toArray(r);
+			for (unsigned int a = 0; a < D; a++)
+			{
+				double x = u[a] * r[a];
+				if (x < p[a] || x >= (p[a] + 1)) { return false; }
+			}
+			return true;
+		}
+
+		// leaf containing u, from cell : up to the first ancestor containing u, then down
+		inline Cell locate(Cell cell, const double* u) const
+		{
+			CellPosition position = m_tree.isLeaf(cell) ? m_leafPosition[m_tree.leafIndex(cell)] : m_tree.cellPosition(cell);
+			size_t p[D], r[D];
+			position.m_position.toArray(p);
+			position.m_resolution.toArray(r);
+			while (cell.level() > 0 && !contains(position, u))
+			{
+				cell = m_tree.parent(cell);
+				unsigned int g[D];
+				m_tree.getLevelSubdivisionGrid(cell.level()).toArray(g);
+				for (unsigned int a = 0; a < D; a++)
+				{
+					p[a] /= g[a];
+					r[a] /= g[a];
+				}
+				position = CellPosition(Vec<size_t, D>(p), Vec<size_t, D>(r));
+			}
+			while (!m_tree.isLeaf(cell))
+			{
+				unsigned int g[D], loc[D];
+				m_tree.getLevelSubdivisionGrid(cell.level()).toArray(g);
+				for (unsigned int a = 0; a < D; a++)
+				{
+					r[a] *= g[a];
+					size_t target = static_cast<size_t>(u[a] * r[a]);
+					size_t first = p[a] * g[a];
+					if (target < first) { target = first; }
+					if (target >= first + g[a]) { target = first + g[a] - 1; }
+					loc[a] = static_cast<unsigned int>(target - first);
+					p[a] = target;
+				}
+				cell = m_tree.child(cell, GridLocation(loc));
+			}
+			return cell;
+		}
+
+		template<typename T>
+		static inline void permute(std::vector<T>& values, const std::vector<size_t>& order)
+		{
+			std::vector<T> result(order.size());
+			for (size_t i = 0; i < order.size(); i++) { result[i] = values[order[i]]; }
+			values.swap(result);
+		}
+
+		Tree& m_tree;
+		VecD m_origin;
+		VecD m_domainSize;
+
+		std::vector<VecD> m_position;
+		std::vector<Attribute> m_attribute;
+		std::vector<size_t> m_id;
+		std::vector<Cell> m_cell; // leaf at the last update, or a cell to locate from
+
+		std::vector<size_t> m_leafOffset;
+		LeafArray<CellPosition> m_leafPosition;
+		bool m_topologyChanged = true;
+		size_t m_nextId = 0;
+		size_t m_located = 0;
+	};
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <assert.h>
+
+namespace hct
+{
+
+	/*
+	Disjoint sets over [0;n[, unite() and find() may be called concurrently (lock free).
+	Roots are linked by index, the larger root under the smaller one : parents only decrease,
+	so a compare and swap on a root cannot create a cycle, and the root of a set is its smallest element,
+	whatever the order of unions. find() does path halving, each step also shortening the path for other threads.
+	*/
+	class UnionFind
+	{
+	public:
+		inline explicit UnionFind(size_t n = 0)
+		{
+			reset(n);
+		}
+
+		UnionFind(const UnionFind&) = delete;
+		UnionFind& operator = (const UnionFind&) = delete;
+
+		// n singletons
+		inline void reset(size_t n)
+		{
+			if (n != m_size)
+			{
+				m_parent.reset(n > 0 ? new std::atomic<int>[n] : nullptr);
+				m_size = n;
+			}
+			for (size_t i = 0; i < n; i++)
+			{
+				m_parent[i].store(static_cast<int>(i), std::memory_order_relaxed);
+			}
+		}
+
+		inline size_t size() const
+		{
+			return m_size;
+		}
+
+		// smallest element of the set of x
+		inline int find(int x)
+		{
+			assert(x >= 0 && static_cast<size_t>(x) < m_size);
+			while (true)
+			{
+				int p = m_parent[x].load(std::memory_order_relaxed);
+				int g = m_parent[p].load(std::memory_order_relaxed);
+				if (p == g)
+				{
+					return p;
+				}
+				m_parent[x].compare_exchange_weak(p, g, std::memory_order_relaxed);
+				x = g;
+			}
+		}
+
+		// merges the sets of a and b, returns false if they were already the same set
+		inline bool unite(int a, int b)
+		{
+			while (true)
+			{
+				a = find(a);
+				b = find(b);
+				if (a == b)
+				{
+					return false;
+				}
+				if (a < b)
+				{
+					std::swap(a, b);
+				}
+				// a may have been linked by another thread since find : retry from there
+				int expected = a;
+				if (m_parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel))
+				{
+					return true;
+				}
+			}
+		}
+
+		inline bool same(int a, int b)
+		{
+			while (true)
+			{
+				a = find(a);
+				b = find(b);
+				if (a == b)
+				{
+					return true;
+				}
+				// a is still a root : a and b were distinct sets when b was found
+				if (m_parent[a].load(std::memory_order_acquire) == a)
+				{
+					return false;
+				}
+			}
+		}
+
+	private:
+		std::unique_ptr< std::atomic<int>[] > m_parent;
+		size_t m_size = 0;
+	};
+
+}
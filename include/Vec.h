@@ -47,6 +47,7 @@ namespace hct
 		template<typename T2> inline Vec(const T2*) {}
 
 		template<typename T2> inline void fromArray(const T2*) const {}
+		template<typename T2> inline void toArray(T2*) const {}
 		static inline Vec<T, 0> fromBitfield(size_t) { return Vec<T, 0>(); }
 
 		template<typename StreamT> inline void toStream(StreamT& out,const std::string&) const {}
@@ -170,6 +171,12 @@ namespace hct
 			this->Vec<T, D - 1>::fromArray(coord);
 		}
 
+		template <typename T2> inline void toArray(T2* coord) const
+		{
+			coord[D - 1] = static_cast<T2>( val );
+			this->Vec<T, D - 1>::toArray(coord);
+		}
+
 		// ecriture du vecteur dans un flot texte
 		template<typename StreamT> inline StreamT& toStream(StreamT& out, const std::string& sep = ",") const
 		{
@@ -334,6 +341,12 @@ namespace hct
 	struct NumericalValueTraits< Vec<T, D> >
 	{
 		static constexpr size_t NumberOfComponents = D;
+
+		template<typename StreamT>
+		static inline StreamT& toStream(StreamT& out, const Vec<T, D>& value)
+		{
+			return value.toStream(out, " ");
+		}
 	};
 
 }; // namespace hct
@@ -37,10 +37,9 @@ namespace hct
 			// build connectivity
 			VertexIdArray vertexIds;
 			size_t nVertices = CellVertexConnectivity::compute(tree, vertexIds);
-			std::vector< HyperCubeTreeCell > leaves;
 
 			out << "POINTS " << nVertices << " double\n";
-			tree.parseLeaves( [&out, &leaves](const HCTVertexOwnershipCursor& cursor)
+			tree.parseLeaves( [&out](const HCTVertexOwnershipCursor& cursor)
 			{
 				using HCubeComponentValue = typename HCTVertexOwnershipCursor::HCubeComponentValue;
 				constexpr size_t CellNumberOfVertices = 1 << Tree::D;
@@ -53,22 +52,22 @@ namespace hct
 						out << '\n';
 					}
 				}
-				leaves.push_back( cursor.cell() );
 			}
 			, HCTVertexOwnershipCursor(tree) );
 
 			// write cell connectivity
-			size_t numberOfCells = leaves.size();
+			size_t numberOfCells = tree.getNumberOfLeaves();
 			out << "CELLS " << numberOfCells << ' ' << numberOfCells*(CellNumberOfVertices+1) << '\n';
-			for (auto cell : leaves)
+			tree.forEachLeaf( [&out, &vertexIds](size_t, HyperCubeTreeCell cell)
 			{
+				constexpr size_t CellNumberOfVertices = 1 << Tree::D;
 				out << CellNumberOfVertices;
 				for (size_t i = 0; i < CellNumberOfVertices; i++)
 				{
 					out << ' ' << vertexIds[cell][i];
 				}
 				out << '\n';
-			}
+			});
 
 			out << "CELL_TYPES " << numberOfCells << '\n';
 			int cellType = -1;
@@ -87,9 +86,9 @@ namespace hct
 			{
 				ITreeLevelArray* iarray = tree.array(a);
 				out << "SCALARS " << iarray->name() << " float "<< iarray->numberOfComponents()<<"\nLOOKUP_TABLE default\n";
-				tree.parseLeaves([&out,iarray](const typename Tree::DefaultTreeCursor & cursor)
+				tree.forEachLeaf([&out,iarray](size_t, HyperCubeTreeCell cell)
 				{
-					iarray->printCell(out,cursor.cell());
+					iarray->printCell(out,cell);
 					out << '\n';
 				});
 			}
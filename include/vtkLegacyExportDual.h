@@ -38,18 +38,14 @@ namespace hct
 			out << "ASCII\n";
 			out << "DATASET UNSTRUCTURED_GRID\n";
 
-			size_t nLeaves = 0;
-			tree.parseLeaves( [&nLeaves](const DefaultTreeCursor&) { ++nLeaves; } );
+			size_t nLeaves = tree.getNumberOfLeaves();
 
 			out << "POINTS " << nLeaves << " double\n";
 
-			TreeLevelArray<int64_t> leafIndex;
-			tree.fitArray(&leafIndex);
-			leafIndex.fill(-1);
 			size_t leafCounter = 0;
-			tree.parseLeaves( [&out, &leafCounter, &leafIndex](const HyperCubeTreeLocatedCursor& cursor)
+			tree.parseLeaves( [&out, &leafCounter, &tree](const HyperCubeTreeLocatedCursor& cursor)
 			{
-				leafIndex[cursor.cell()] = leafCounter;
+				assert(tree.leafIndex(cursor.cell()) == leafCounter);
 				++leafCounter;
 				cursor.position().normalize().toStream(out, " ");
 				out << '\n';
@@ -83,7 +79,7 @@ namespace hct
 
 			size_t cellCounter = 0;
 			DualMesh::parseDualCells( tree,
-				[&out,&leafIndex,&cellCounter](const DuallCell& dual)
+				[&out,&tree,&cellCounter](const DuallCell& dual)
 				{
 					constexpr size_t CellNumberOfVertices = 1 << Tree::D;
 					if (!dual.m_center.boundary())
@@ -93,8 +89,7 @@ namespace hct
 						for (size_t i = 0; i < CellNumberOfVertices; i++)
 						{
 							assert(dual.m_vertices[i].m_cell.isTreeCell());
-							assert(leafIndex[dual.m_vertices[i].m_cell] != -1);
-							out << ' ' << leafIndex[dual.m_vertices[i].m_cell];
+							out << ' ' << tree.leafIndex(dual.m_vertices[i].m_cell);
 						}
 						out << '\n';
 					}
@@ -119,14 +114,11 @@ namespace hct
 			{
 				ITreeLevelArray* iarray = tree.array(a);
 				out << "SCALARS " << iarray->name() << " float "<< iarray->numberOfComponents()<<"\nLOOKUP_TABLE default\n";
-				size_t vertexCounter = 0;
-				tree.parseLeaves([&out,&vertexCounter,iarray](const typename Tree::DefaultTreeCursor & cursor)
+				tree.forEachLeaf([&out,iarray](size_t, HyperCubeTreeCell cell)
 				{
-					++vertexCounter;
-					iarray->printCell(out,cursor.cell());
+					iarray->printCell(out,cell);
 					out << '\n';
 				});
-				assert(vertexCounter == nLeaves);
 			}
 		}
 	}
@@ -0,0 +1,68 @@
+#include "MappedFile.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace hctreader
+{
+
+  MappedFile::MappedFile() : m_data(0), m_size(0) {}
+
+  MappedFile::~MappedFile()
+  {
+    close();
+  }
+
+  void MappedFile::close()
+  {
+    if( m_data != 0 ) munmap( m_data, m_size );
+    m_data = 0;
+    m_size = 0;
+  }
+
+  bool MappedFile::map(int fd, size_t size, bool writable, const char* fileName)
+  {
+    m_size = size;
+    if( size == 0 ) // nothing to map, data() stays null
+      {
+	::close(fd);
+	return true;
+      }
+    void* data = mmap( 0, size, writable ? (PROT_READ|PROT_WRITE) : PROT_READ, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0 );
+    ::close(fd);
+    if( data == MAP_FAILED )
+      {
+	m_size = 0;
+	m_error = std::string("cannot map ") + fileName;
+	return false;
+      }
+    m_data = static_cast<char*>(data);
+    return true;
+  }
+
+  bool MappedFile::open(const char* fileName)
+  {
+    close();
+    m_error.clear();
+    int fd = ::open( fileName, O_RDONLY );
+    if( fd < 0 ) { m_error = std::string("cannot open ") + fileName; return false; }
+    struct stat st;
+    if( fstat(fd,&st) != 0 ) { ::close(fd); m_error = std::string("cannot stat ") + fileName; return false; }
+    if( ! map( fd, st.st_size, false, fileName ) ) return false;
+    if( m_data != 0 ) madvise( m_data, m_size, MADV_SEQUENTIAL );
+    return true;
+  }
+
+  bool MappedFile::create(const char* fileName, size_t size)
+  {
+    close();
+    m_error.clear();
+    int fd = ::open( fileName, O_RDWR|O_CREAT|O_TRUNC, 0644 );
+    if( fd < 0 ) { m_error = std::string("cannot create ") + fileName; return false; }
+    if( ftruncate( fd, size ) != 0 ) { ::close(fd); m_error = std::string("cannot resize ") + fileName; return false; }
+    return map( fd, size, true, fileName );
+  }
+
+}; // namespace hctreader
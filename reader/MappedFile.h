@@ -0,0 +1,41 @@
+#ifndef __MAPPED_FILE_H
+#define __MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace hctreader
+{
+
+  /*
+   * Memory mapped file, read only (open) or read write with a given size (create).
+   * The mapping is released when the object is destroyed.
+   */
+  class MappedFile
+  {
+  public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    bool open(const char* fileName);
+    bool create(const char* fileName, size_t size);
+    void close();
+
+    inline const char* data() const { return m_data; }
+    inline char* data() { return m_data; }
+    inline size_t size() const { return m_size; }
+    inline const std::string& error() const { return m_error; }
+
+  private:
+    bool map(int fd, size_t size, bool writable, const char* fileName);
+
+    char* m_data;
+    size_t m_size;
+    std::string m_error;
+  };
+
+}
+
+#endif //__MAPPED_FILE_H
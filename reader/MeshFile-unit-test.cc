@@ -0,0 +1,111 @@
+#include "MeshFile.h"
+#include "readMesh.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <assert.h>
+using namespace std;
+using namespace hct;
+using namespace hctreader;
+
+// writes a small mesh : nc cells (cell 1 is not an hexahedron), bytes removed from the end, vertex of cell 0 changed
+static void writeMesh(const string& fileName, int nc, int np, size_t truncate, int badVertex)
+{
+  vector<char> buf;
+  auto put = [&buf](const void* p, size_t n) { buf.insert(buf.end(), (const char*)p, (const char*)p + n); };
+  put(&nc,sizeof(int));
+  put(&np,sizeof(int));
+  for(int i=0;i<nc;i++)
+    {
+      int ncp = (i==1) ? 4 : 8;
+      put(&ncp,sizeof(int));
+      for(int j=0;j<ncp;j++)
+	{
+	  int v = (i+j) % np;
+	  if( i==0 && j==0 && badVertex!=0 ) v = badVertex;
+	  put(&v,sizeof(int));
+	}
+    }
+  for(int i=0;i<np;i++) { Vec3f p( {float(i),float(2*i),float(3*i)} ); put(&p,sizeof(Vec3f)); }
+  for(int i=0;i<nc;i++) { float s = 0.5f*i; put(&s,sizeof(float)); }
+  buf.resize( buf.size() - truncate );
+  ofstream fic(fileName.c_str(), ios::binary);
+  fic.write(buf.data(), buf.size());
+}
+
+static void checkMesh(const string& fileName, int nc, int np)
+{
+  MeshFile file;
+  bool ok = file.open(fileName.c_str());
+  assert(ok);
+  assert(file.nCells()==nc && file.nPoints()==np);
+  vector< PointIds<3> > indices(nc);
+  ok = file.readCells(indices.data());
+  assert(ok);
+  for(int i=0;i<nc;i++)
+    {
+      for(int j=0;j<8;j++) assert( indices[i].nodes[j] == ((i==1) ? -1 : (i+j)%np) );
+      assert( file.scalars()[i] == 0.5f*i );
+    }
+  for(int i=0;i<np;i++) assert( file.points()[i].val == float(3*i) );
+  // decoding a range of cells
+  if( nc > MeshFile::ChunkSize )
+    {
+      int count = nc - MeshFile::ChunkSize;
+      vector< PointIds<3> > range(count);
+      ok = file.readCells(MeshFile::ChunkSize, count, range.data());
+      assert(ok);
+      assert( std::memcmp( range.data(), indices.data()+MeshFile::ChunkSize, count*sizeof(PointIds<3>) ) == 0 );
+    }
+  cout<<fileName<<" : "<<nc<<" cells, "<<np<<" points Ok"<<endl;
+}
+
+int main(int argc, char* argv[])
+{
+  string fileName = "MeshFile-unit-test.bin";
+
+  writeMesh(fileName, 10000, 777, 0, 0);
+  checkMesh(fileName, 10000, 777);
+
+  MeshFile file;
+  writeMesh(fileName, 100, 50, 1, 0);
+  bool ok = file.open(fileName.c_str());
+  assert( ! ok );
+  cout<<"truncated file : "<<file.error()<<endl;
+
+  writeMesh(fileName, 100, 50, 0, 50);
+  ok = file.open(fileName.c_str());
+  assert( ok );
+  vector< PointIds<3> > indices(100);
+  ok = file.readCells(indices.data());
+  assert( ! ok );
+  cout<<"bad vertex : "<<file.error()<<endl;
+
+  ok = file.open("does-not-exist.bin");
+  assert( ! ok );
+  cout<<"missing file : "<<file.error()<<endl;
+
+  // optional .bin file : mapped reader must give the same mesh as readMesh
+  if( argc >= 2 )
+    {
+      int nc=0, np=0;
+      PointIds<3>* ids=0; Vec3f* points=0; float* scalars=0;
+      ok = readMesh(argv[1],nc,np,ids,points,scalars);
+      assert( ok );
+      ok = file.open(argv[1]);
+      assert( ok );
+      vector< PointIds<3> > ids2(nc);
+      ok = file.readCells(ids2.data());
+      assert( ok );
+      assert( std::memcmp(ids, ids2.data(), nc*sizeof(PointIds<3>)) == 0 );
+      assert( std::memcmp(points, file.points(), np*sizeof(Vec3f)) == 0 );
+      assert( std::memcmp(scalars, file.scalars(), nc*sizeof(float)) == 0 );
+      cout<<argv[1]<<" : "<<nc<<" cells, "<<np<<" points Ok"<<endl;
+      delete [] ids; delete [] points; delete [] scalars;
+    }
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include "MeshFile.h"
+
+#include <cstring>
+#include <algorithm>
+#include <assert.h>
+
+namespace hctreader
+{
+
+  using namespace hct;
+
+  static inline int readInt(const char* p)
+  {
+    int n;
+    std::memcpy( &n, p, sizeof(int) );
+    return n;
+  }
+
+  MeshFile::MeshFile()
+    : m_nCells(0), m_nPoints(0), m_points(0), m_scalars(0) {}
+
+  MeshFile::~MeshFile()
+  {
+    close();
+  }
+
+  bool MeshFile::fail(const std::string& message)
+  {
+    close();
+    m_error = message;
+    return false;
+  }
+
+  void MeshFile::close()
+  {
+    m_file.close();
+    m_nCells = 0;
+    m_nPoints = 0;
+    m_chunkOffset.clear();
+    m_points = 0;
+    m_scalars = 0;
+  }
+
+  bool MeshFile::open(const char* fileName)
+  {
+    close();
+    m_error.clear();
+
+    if( ! m_file.open(fileName) ) return fail( m_file.error() );
+    const char* data = m_file.data();
+    size_t size = m_file.size();
+    if( size < 2*sizeof(int) ) return fail("truncated header");
+
+    m_nCells = readInt( data );
+    m_nPoints = readInt( data + sizeof(int) );
+    if( m_nCells < 0 || m_nPoints < 0 ) return fail("negative number of cells or points");
+
+    // prefix pass over variable size cell records
+    size_t tail = size_t(m_nPoints)*sizeof(Vec3f) + size_t(m_nCells)*sizeof(float);
+    size_t offset = 2*sizeof(int);
+    m_chunkOffset.reserve( m_nCells/ChunkSize + 1 );
+    for(int i=0;i<m_nCells;i++)
+      {
+	if( i % ChunkSize == 0 ) m_chunkOffset.push_back( offset );
+	if( offset + sizeof(int) > size ) return fail("truncated cell records");
+	int ncp = readInt( data + offset );
+	if( ncp < 0 ) return fail("negative cell size");
+	offset += sizeof(int) + size_t(ncp)*sizeof(int);
+      }
+    if( offset > size || (size - offset) < tail ) return fail("truncated points or scalars");
+
+    // offsets are multiples of sizeof(int) and the mapping is page aligned
+    m_points = reinterpret_cast<const Vec3f*>( data + offset );
+    m_scalars = reinterpret_cast<const float*>( data + offset + size_t(m_nPoints)*sizeof(Vec3f) );
+    return true;
+  }
+
+  bool MeshFile::readCells(PointIds<3>* indices)
+  {
+    return readCells(0, m_nCells, indices);
+  }
+
+  bool MeshFile::readCells(int first, int count, PointIds<3>* indices)
+  {
+    assert( first % ChunkSize == 0 );
+    assert( first >= 0 && count >= 0 && (first+count) <= m_nCells );
+    const int firstChunk = first / ChunkSize;
+    const int endChunk = (first + count + ChunkSize - 1) / ChunkSize;
+    long nBadVertices = 0;
+#   pragma omp parallel for schedule(dynamic) reduction(+:nBadVertices)
+    for(int c=firstChunk;c<endChunk;c++)
+      {
+	const char* p = m_file.data() + m_chunkOffset[c];
+	int end = std::min( (c+1)*int(ChunkSize), first+count );
+	for(int i=c*ChunkSize;i<end;i++)
+	  {
+	    PointIds<3>& ids = indices[i-first];
+	    int ncp = readInt(p);
+	    p += sizeof(int);
+	    if( ncp == PointIds<3>::Size )
+	      {
+		std::memcpy( &ids, p, sizeof(PointIds<3>) );
+		for(int j=0;j<PointIds<3>::Size;j++)
+		  {
+		    if( ids.nodes[j] < 0 || ids.nodes[j] >= m_nPoints ) ++nBadVertices;
+		  }
+	      }
+	    else // on saute la maille foireuse
+	      {
+		ids = PointIds<3>(-1);
+	      }
+	    p += size_t(ncp)*sizeof(int);
+	  }
+      }
+    if( nBadVertices > 0 )
+      {
+	m_error = "vertex index out of range";
+	return false;
+      }
+    return true;
+  }
+
+}; // namespace hctreader
@@ -0,0 +1,65 @@
+#ifndef __MESH_FILE_H
+#define __MESH_FILE_H
+
+#include "Vec.h"
+#include "PointIds.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace hctreader
+{
+
+  /*
+   * Memory mapped .bin mesh file :
+   * int nCells, int nPoints,
+   * nCells records { int n, int vertices[n] } (hexahedra have 8 vertices, other cells are skipped),
+   * nPoints Vec3f points, nCells float scalars.
+   *
+   * open() maps the file and runs a prefix pass over cell records, which checks record sizes
+   * and remembers the offset of one record every ChunkSize cells, so that cells can then be decoded in parallel.
+   * Points and scalars are views on the mapped file, valid until the MeshFile is closed.
+   */
+  class MeshFile
+  {
+  public:
+    enum { ChunkSize = 4096 };
+
+    MeshFile();
+    ~MeshFile();
+    MeshFile(const MeshFile&) = delete;
+    MeshFile& operator = (const MeshFile&) = delete;
+
+    // returns false, with an error message, if the file cannot be mapped or is inconsistent
+    bool open(const char* fileName);
+    void close();
+
+    // decodes cell vertices, in parallel. Skipped cells get -1 vertices.
+    // returns false if a vertex index is out of [0;nPoints[
+    bool readCells(hct::PointIds<3>* indices);
+    // same for cells [first;first+count[, first must be a multiple of ChunkSize
+    bool readCells(int first, int count, hct::PointIds<3>* indices);
+
+    inline int nCells() const { return m_nCells; }
+    inline int nPoints() const { return m_nPoints; }
+    inline const hct::Vec3f* points() const { return m_points; }
+    inline const float* scalars() const { return m_scalars; }
+    inline const std::string& error() const { return m_error; }
+
+  private:
+    bool fail(const std::string& message);
+
+    MappedFile m_file;
+    int m_nCells;
+    int m_nPoints;
+    std::vector<size_t> m_chunkOffset;
+    const hct::Vec3f* m_points;
+    const float* m_scalars;
+    std::string m_error;
+  };
+
+}
+
+#endif //__MESH_FILE_H
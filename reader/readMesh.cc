@@ -1,8 +1,7 @@
-#include "Vec.h"
-#include "PointIds.h"
+#include "readMesh.h"
+#include "MeshFile.h"
 
-#include <fstream>
-#include <string>
+#include <cstring>
 
 namespace hctreader
 {
@@ -15,39 +14,24 @@ namespace hctreader
 			      Vec3f*& points,
 			      float*& scalars)
   {
-    std::ifstream fic(fileName);
-    if( !fic.good() ) return false;
-
-    // lecture du nombre de mailles et nombre de points
-    fic.read( (char*)&nc, sizeof(int) ); // nombre de mailles
-    fic.read( (char*)&np, sizeof(int) ); // nombre de points
+    MeshFile file;
+    if( ! file.open(fileName) ) return false;
 
+    nc = file.nCells();
+    np = file.nPoints();
     indices = new PointIds<3>[nc];
-    points = new Vec3f[np];
-    scalars = new float[nc];
-
-    // lecture du maillage
-    for(int i=0;i<nc;i++)
+    if( ! file.readCells(indices) )
       {
-	int ncp;
-	fic.read( (char*)&ncp , sizeof(int) );
-	if(ncp==PointIds<3>::Size) // on verifie que c'est un tetra
-	  {
-	    fic.read( (char*)(indices+i) , sizeof(PointIds<3>) );
-	  }
-	else // on saute la maille foireuse
-	  {
-	    for(int j=0;j<8;j++) indices[i].nodes[j] = -1;
-	    fic.ignore(ncp*sizeof(int));
-	  }
+	delete [] indices;
+	indices = 0;
+	return false;
       }
-    fic.read( (char*)points , np*sizeof(Vec3f) );
-    fic.read( (char*)scalars , nc*sizeof(float) );
 
-    fic.close();
+    points = new Vec3f[np];
+    scalars = new float[nc];
+    std::memcpy( points, file.points(), np*sizeof(Vec3f) );
+    std::memcpy( scalars, file.scalars(), nc*sizeof(float) );
     return true;
   }
 
 }; // namespace hct
-
-
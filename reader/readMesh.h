@@ -10,6 +10,7 @@
 namespace hctreader
 {
 
+  // reads a .bin mesh into newly allocated arrays (see MeshFile), returns false if the file is missing or inconsistent
   bool readMesh(const char* fileName,
 			      int& nc, int& np,
 			      hct::PointIds<3>*& indices,
@@ -0,0 +1,88 @@
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "StaticSubdivisionScheme.h"
+#include "ScalarFunction.h"
+#include "TreeRefineImplicitSurface.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "HyperCubeTreeNeighborCursor.h"
+
+#include <iostream>
+#include <chrono>
+
+/*
+Times refinement, leaf traversal and neighbor traversal of the same octree built with a static and a generic subdivision scheme.
+Not a unit test (see TestStaticTreeTraversal for the checks) : meant to be run from an optimized build.
+*/
+
+using hct::Vec3d;
+
+static constexpr size_t NLevels = 7;
+using StaticScheme = hct::StaticSubdivisionScheme< NLevels, 2, 2, 2 >;
+using StaticTree = hct::HyperCubeTree< 3, StaticScheme >;
+using SimpleScheme = hct::SimpleSubdivisionScheme<3>;
+using SimpleTree = hct::HyperCubeTree< 3, SimpleScheme >;
+
+template<typename Tree>
+static void benchmarkRefinement(Tree& tree, const char* name)
+{
+	auto T0 = std::chrono::high_resolution_clock::now();
+	auto sphereA = hct::csg_sphere(Vec3d({ 0.0,0.0,0.0 }), 1.0);
+	auto sphereB = hct::csg_sphere(Vec3d({ 0.5,0.5,0.5 }), 0.5);
+	hct::tree_refine_implicit_surface(tree, hct::csg_difference(sphereA, sphereB), NLevels + 1);
+	auto T1 = std::chrono::high_resolution_clock::now();
+	std::cout << name << " : " << tree.getNumberOfLeaves() << " leaves, refinement = "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(T1 - T0).count() << " uSec" << std::endl;
+}
+
+template<typename Tree>
+static void benchmarkTraversal(const Tree& tree, const char* name)
+{
+	using TreeCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+	using NbhTreeCursor = hct::HyperCubeTreeNeighborCursor<Tree>;
+	static constexpr int NRuns = 10;
+
+	auto T0 = std::chrono::high_resolution_clock::now();
+	size_t sum = 0;
+	for (int r = 0; r < NRuns; r++)
+	{
+		tree.parseLeaves([&sum](const TreeCursor& cursor)
+		{
+			sum += cursor.position().m_position.reduce_add();
+		}, TreeCursor());
+	}
+	auto T1 = std::chrono::high_resolution_clock::now();
+	size_t nbNeighbors = 0;
+	for (int r = 0; r < NRuns; r++)
+	{
+		tree.parseLeaves([&nbNeighbors](const NbhTreeCursor& cursor)
+		{
+			cursor.m_nbh.forEachValue([&nbNeighbors](const typename NbhTreeCursor::HCubeComponentValue& v)
+			{
+				if (v.m_cell.isTreeCell()) { ++nbNeighbors; }
+			});
+		}, NbhTreeCursor());
+	}
+	auto T2 = std::chrono::high_resolution_clock::now();
+
+	auto leavesUsec = std::chrono::duration_cast<std::chrono::microseconds>(T1 - T0);
+	auto nbhUsec = std::chrono::duration_cast<std::chrono::microseconds>(T2 - T1);
+	std::cout << name << " : leaf traversal = " << leavesUsec.count() / NRuns << " uSec"
+		<< ", neighbor traversal = " << nbhUsec.count() / NRuns << " uSec"
+		<< " (checksum " << sum << ", neighbors " << nbNeighbors << ")" << std::endl;
+}
+
+int main()
+{
+	SimpleScheme simpleScheme;
+	for (size_t i = 0; i < NLevels; i++) { simpleScheme.addLevelSubdivision({ 2,2,2 }); }
+
+	StaticTree staticTree( (StaticScheme()) );
+	SimpleTree simpleTree( simpleScheme );
+
+	benchmarkRefinement(staticTree, "static");
+	benchmarkRefinement(simpleTree, "simple");
+	benchmarkTraversal(simpleTree, "simple");
+	benchmarkTraversal(staticTree, "static");
+
+	return 0;
+}
@@ -0,0 +1,216 @@
+#include "TestTrees.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "HyperCubeTreeNeighborCursor.h"
+#include "DistributedHyperCubeTree.h"
+#include "Communicator.h"
+#include "SocketCommunicator.h"
+#include "HyperCubeTreeGhostLayer.h"
+#include "TreeLevelArray.h"
+#include "LeafArray.h"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <assert.h>
+
+using hct::Vec3d;
+using Tree = test_trees::Tree<3>;
+using DistributedTree = hct::DistributedHyperCubeTree<Tree>;
+using LocatedCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+using NbhCursor = hct::HyperCubeTreeNeighborCursor<Tree>;
+
+static void testCommunicator(hct::Communicator& comm)
+{
+	int me = comm.rank();
+	int n = comm.size();
+
+	// large messages in both directions, larger than socket buffers
+	std::vector< std::vector<char> > sendBuffers(n), recvBuffers;
+	for (int r = 0; r < n; r++) { sendBuffers[r].assign(1 << 21, static_cast<char>(me * 16 + r)); }
+	comm.allToAll(sendBuffers, recvBuffers, 1);
+	for (int r = 0; r < n; r++)
+	{
+		assert(recvBuffers[r].size() == (1 << 21));
+		assert(recvBuffers[r].front() == static_cast<char>(r * 16 + me) && recvBuffers[r].back() == recvBuffers[r].front());
+	}
+
+	// messages with different tags are matched by tag
+	int next = (me + 1) % n;
+	int previous = (me + n - 1) % n;
+	int a = me, b = 100 + me;
+	comm.send(next, 2, &a, sizeof(int));
+	comm.send(next, 3, &b, sizeof(int));
+	std::vector<char> data;
+	comm.recv(previous, 3, data);
+	assert(data.size() == sizeof(int) && *reinterpret_cast<int*>(data.data()) == 100 + previous);
+	comm.recv(previous, 2, data);
+	assert(data.size() == sizeof(int) && *reinterpret_cast<int*>(data.data()) == previous);
+
+	std::vector<int> all;
+	comm.allGather(std::vector<int>(me + 1, me), all, 4);
+	assert(all.size() == static_cast<size_t>(n * (n + 1) / 2));
+	assert(comm.allReduceSum(me, 5) == n * (n - 1) / 2);
+	comm.barrier(6);
+}
+
+// value attached to a cell, checked after transfers
+static double cellValue(const hct::HyperCubeTreeCellPosition<3>& position)
+{
+	Vec3d c = (Vec3d(position.m_position) + 0.5) / Vec3d(position.m_resolution);
+	double x[3];
+	c.toArray(x);
+	return x[0] + 10.0 * x[1] + 100.0 * x[2];
+}
+
+static bool nearSphere(const hct::HyperCubeTreeCellPosition<3>& position)
+{
+	Vec3d size = Vec3d(1.0) / Vec3d(position.m_resolution);
+	Vec3d c = (Vec3d(position.m_position) + 0.5) * size;
+	double d = std::sqrt((c - Vec3d({ 0.3,0.4,0.5 })).length2());
+	return std::abs(d - 0.25) < 0.5 * std::sqrt(size.length2());
+}
+
+// refines owned leaves along a sphere, down to maxLevel
+static void refineOwned(DistributedTree& dtree, size_t maxLevel)
+{
+	for (;;)
+	{
+		std::vector<hct::HyperCubeTreeCell> refine;
+		dtree.parseOwnedLeaves([&refine, maxLevel](const LocatedCursor& cursor)
+		{
+			if (cursor.cell().level() < maxLevel && nearSphere(cursor.position())) { refine.push_back(cursor.cell()); }
+		}
+		, LocatedCursor());
+		if (refine.empty()) { break; }
+		for (auto cell : refine) { dtree.tree().refine(cell); }
+	}
+}
+
+// center of a leaf, as a key : leaves don't overlap
+static double leafKey(const hct::HyperCubeTreeCellPosition<3>& position)
+{
+	return cellValue(position);
+}
+
+/*
+owned leaves hold their value, ghost leaves received their owner's value, neighbors of owned leaves are owned or ghost leaves,
+and ghost leaves are the ghost layer of the same partition of the whole tree
+*/
+static void checkDistributedTree(DistributedTree& dtree, hct::TreeLevelArray<double>& value, const Tree& reference)
+{
+	const Tree& tree = dtree.tree();
+	int me = dtree.communicator().rank();
+	dtree.exchange(value);
+	assert(dtree.globalNumberOfLeaves() == reference.getNumberOfLeaves());
+
+	hct::LeafArray<char> ghost;
+	tree.fitLeafArray(&ghost);
+	ghost.fill(0);
+	for (auto cell : dtree.ghostLeaves())
+	{
+		assert(tree.isLeaf(cell));
+		ghost[tree.leafIndex(cell)] = 1;
+	}
+	std::vector<double> ghostKeys;
+	tree.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		if (cursor.cell().level() < dtree.topLevel()) { return; }
+		bool owned = dtree.isOwned(dtree.rootAt(cursor.position()));
+		bool isGhost = ghost[tree.leafIndex(cursor.cell())] != 0;
+		assert(!(owned && isGhost));
+		if (owned || isGhost) { assert(value[cursor.cell()] == cellValue(cursor.position())); }
+		if (isGhost) { ghostKeys.push_back(leafKey(cursor.position())); }
+	}
+	, LocatedCursor());
+	assert(ghostKeys.size() == dtree.ghostLeaves().size());
+
+	dtree.parseOwnedLeaves([&](const NbhCursor& cursor)
+	{
+		cursor.m_nbh.forEachValue([&](const NbhCursor::HCubeComponentValue& nbh)
+		{
+			if (!nbh.m_cell.isTreeCell() || !tree.isLeaf(nbh.m_cell)) { return; }
+			assert(dtree.isOwned(dtree.rootAt(nbh.m_position)) || ghost[tree.leafIndex(nbh.m_cell)] != 0);
+		});
+	}
+	, NbhCursor());
+
+	// ghost layer of the whole tree, partitioned by root owners
+	hct::LeafArray<unsigned int> parts;
+	reference.fitLeafArray(&parts);
+	std::vector<hct::HyperCubeTreeCellPosition<3> > positions(reference.getNumberOfLeaves());
+	reference.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		size_t leaf = reference.leafIndex(cursor.cell());
+		parts[leaf] = static_cast<unsigned int>(dtree.owner(dtree.rootAt(cursor.position())));
+		positions[leaf] = cursor.position();
+	}
+	, LocatedCursor());
+	hct::HyperCubeTreeGhostLayer<Tree> layer;
+	layer.build(reference, parts, dtree.communicator().size(), dtree.ghostWidth());
+	std::vector<double> expectedKeys;
+	for (size_t leaf : layer.ghostLeaves(me)) { expectedKeys.push_back(leafKey(positions[leaf])); }
+	std::sort(ghostKeys.begin(), ghostKeys.end());
+	std::sort(expectedKeys.begin(), expectedKeys.end());
+	assert(ghostKeys == expectedKeys);
+
+	std::cout << "rank " << me << ", width " << dtree.ghostWidth() << " : " << dtree.numberOfOwnedLeaves() << " owned leaves, "
+		<< dtree.ghostRoots().size() << " ghost roots, " << dtree.ghostLeaves().size() << " ghost leaves, "
+		<< tree.getNumberOfLeaves() << " local leaves" << std::endl;
+}
+
+static void testDistributedTree(hct::Communicator& comm, unsigned int width)
+{
+	hct::SimpleSubdivisionScheme<3> octree = test_trees::octree(5);
+
+	// reference tree, from the same refinement on a whole tree
+	Tree reference(octree);
+	for (;;)
+	{
+		std::vector<hct::HyperCubeTreeCell> refine;
+		reference.parseLeaves([&refine](const LocatedCursor& cursor)
+		{
+			if (cursor.cell().level() < 5 && (cursor.cell().level() < 2 || nearSphere(cursor.position()))) { refine.push_back(cursor.cell()); }
+		}
+		, LocatedCursor());
+		if (refine.empty()) { break; }
+		for (auto cell : refine) { reference.refine(cell); }
+	}
+
+	hct::TreeLevelArray<double> value;
+	value.setName("value");
+	DistributedTree dtree(comm, octree, 2, width);
+	assert(dtree.numberOfRoots() == 64);
+	dtree.addArray(&value);
+	refineOwned(dtree, 5);
+	dtree.updateGhosts();
+	dtree.parseOwnedLeaves([&value](const LocatedCursor& cursor) { value[cursor.cell()] = cellValue(cursor.position()); }, LocatedCursor());
+	checkDistributedTree(dtree, value, reference);
+
+	// values follow migrated subtrees
+	dtree.rebalance();
+	checkDistributedTree(dtree, value, reference);
+	std::vector<int> reversed(dtree.numberOfRoots());
+	for (size_t r = 0; r < dtree.numberOfRoots(); r++) { reversed[r] = comm.size() - 1 - dtree.owner(r); }
+	dtree.migrate(reversed);
+	checkDistributedTree(dtree, value, reference);
+}
+
+int main()
+{
+	std::cout << "serial :" << std::endl;
+	hct::SerialCommunicator serial;
+	testCommunicator(serial);
+	testDistributedTree(serial, 1);
+
+	std::cout << "4 processes :" << std::endl;
+	bool success = hct::SocketCommunicator::run(4, [](hct::Communicator& comm)
+	{
+		testCommunicator(comm);
+		testDistributedTree(comm, 1);
+		testDistributedTree(comm, 2);
+	});
+	assert(success);
+
+	return success ? 0 : 1;
+}
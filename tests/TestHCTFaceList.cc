@@ -0,0 +1,145 @@
+#include "TestTrees.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "HyperCubeTreeFaceList.h"
+#include "LeafArray.h"
+
+#include <iostream>
+#include <set>
+#include <tuple>
+#include <cmath>
+#include <assert.h>
+
+using hct::Vec3d;
+
+/*
+checks a face list against leaf boxes :
+- each leaf's faces cover its whole surface, and boundary faces cover the domain surface
+- the two leaves of a face touch along the face axis, on the side given by the orientation
+- no face is listed twice
+*/
+template<typename Tree>
+static void checkFaceList(const Tree& tree, const typename hct::HyperCubeTreeFaceList<Tree>::VecD& domain)
+{
+	static constexpr unsigned int D = Tree::D;
+	using FaceList = hct::HyperCubeTreeFaceList<Tree>;
+	using VecD = typename FaceList::VecD;
+	using TreeCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+
+	FaceList faces;
+	faces.build(tree, domain);
+	std::cout << tree.getNumberOfLeaves() << " leaves, " << faces.numberOfInteriorFaces() << " interior faces, "
+		<< faces.numberOfBoundaryFaces() << " boundary faces" << std::endl;
+
+	hct::LeafArray<VecD> lo, hi;
+	hct::LeafArray<size_t> level;
+	tree.fitLeafArray(&lo);
+	tree.fitLeafArray(&hi);
+	tree.fitLeafArray(&level);
+	tree.parseLeaves([&](const TreeCursor& cursor)
+	{
+		size_t leaf = tree.leafIndex(cursor.cell());
+		VecD size = domain / VecD(cursor.position().m_resolution);
+		lo[leaf] = VecD(cursor.position().m_position) * size;
+		hi[leaf] = lo[leaf] + size;
+		level[leaf] = cursor.cell().level();
+	}
+	, TreeCursor());
+
+	size_t nLeaves = tree.getNumberOfLeaves();
+	std::vector<double> leafArea(nLeaves, 0.0);
+	double boundaryArea = 0.0;
+	std::set< std::tuple<size_t, size_t, unsigned int> > pairs;
+	for (size_t f = 0; f < faces.size(); f++)
+	{
+		size_t l = faces.left(f);
+		size_t r = faces.right(f);
+		unsigned int a = faces.axis(f);
+		int o = faces.orientation(f);
+		assert(l < nLeaves);
+		assert(o == 1 || o == -1);
+		leafArea[l] += faces.area(f);
+		double llo[D], lhi[D];
+		lo[l].toArray(llo);
+		hi[l].toArray(lhi);
+		if (f >= faces.numberOfInteriorFaces())
+		{
+			assert(r == FaceList::NoLeaf);
+			double d[D];
+			domain.toArray(d);
+			assert(o > 0 ? std::abs(lhi[a] - d[a]) < 1.e-12 : std::abs(llo[a]) < 1.e-12);
+			boundaryArea += faces.area(f);
+			continue;
+		}
+		assert(r < nLeaves);
+		assert(faces.levelDifference(f) == level[l] - level[r]);
+		leafArea[r] += faces.area(f);
+		bool inserted = pairs.insert(std::make_tuple(std::min(l, r), std::max(l, r), a)).second;
+		assert(inserted);
+		double rlo[D], rhi[D];
+		lo[r].toArray(rlo);
+		hi[r].toArray(rhi);
+		assert(o > 0 ? std::abs(lhi[a] - rlo[a]) < 1.e-12 : std::abs(llo[a] - rhi[a]) < 1.e-12);
+		for (unsigned int i = 0; i < D; i++)
+		{
+			// the owning leaf's face lies within the neighbor's face
+			if (i != a) { assert(llo[i] >= rlo[i] - 1.e-12 && lhi[i] <= rhi[i] + 1.e-12); }
+		}
+	}
+	for (size_t i = 0; i < nLeaves; i++)
+	{
+		VecD size = hi[i] - lo[i];
+		double surface = 0.0;
+		double s[D];
+		size.toArray(s);
+		for (unsigned int a = 0; a < D; a++) { surface += 2.0 * size.reduce_mul() / s[a]; }
+		assert(std::abs(leafArea[i] - surface) < 1.e-9 * surface);
+	}
+	double domainSurface = 0.0;
+	double d[D];
+	domain.toArray(d);
+	for (unsigned int a = 0; a < D; a++) { domainSurface += 2.0 * domain.reduce_mul() / d[a]; }
+	assert(std::abs(boundaryArea - domainSurface) < 1.e-9 * domainSurface);
+}
+
+int main()
+{
+	{
+		std::cout << "2D, uniform 4x4 : ";
+		using Tree = test_trees::Tree<2>;
+		Tree tree(test_trees::subdivisions<2>({ { 2,2 }, { 2,2 } }));
+		test_trees::refineUniform(tree);
+		hct::HyperCubeTreeFaceList<Tree> faces;
+		faces.build(tree);
+		assert(faces.numberOfInteriorFaces() == 2 * 4 * 3);
+		assert(faces.numberOfBoundaryFaces() == 4 * 4);
+		for (size_t f = 0; f < faces.size(); f++)
+		{
+			assert(faces.levelDifference(f) == 0);
+			assert(std::abs(faces.area(f) - 0.25) < 1.e-15);
+		}
+		checkFaceList(tree, hct::Vec2d({ 2.0, 1.0 }));
+	}
+
+	{
+		std::cout << "2D, coarse/fine : ";
+		test_trees::Tree<2> tree(test_trees::subdivisions<2>({ { 2,3 }, { 3,2 }, { 2,2 } }));
+		test_trees::refineCoarseFine(tree);
+		checkFaceList(tree, hct::Vec2d({ 1.0, 1.0 }));
+	}
+
+	{
+		std::cout << "3D, unbalanced octree : ";
+		test_trees::Tree<3> tree(test_trees::octree(6));
+		test_trees::refineSphere(tree, 7);
+		checkFaceList(tree, Vec3d({ 1.0, 2.0, 3.0 }));
+	}
+
+	{
+		std::cout << "3D, mixed subdivisions : ";
+		test_trees::Tree<3> tree(test_trees::mixed());
+		test_trees::refineShell(tree, 5);
+		checkFaceList(tree, Vec3d(1.0));
+	}
+
+	return 0;
+}
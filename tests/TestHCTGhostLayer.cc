@@ -0,0 +1,162 @@
+#include "TestTrees.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "HyperCubeTreeGhostLayer.h"
+#include "LeafArray.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+/*
+checks ghost layers against leaf boxes : adjacency is closed box intersection,
+ghost distances are checked with a brute force breadth first search, sends match receives.
+*/
+template<typename Tree>
+static void checkGhostLayer(const Tree& tree, unsigned int nPartitions, unsigned int width)
+{
+	static constexpr unsigned int D = Tree::D;
+	using GhostLayer = hct::HyperCubeTreeGhostLayer<Tree>;
+	using VecD = hct::Vec<double, D>;
+	using TreeCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+
+	// contiguous ranges of leaves, in leaf order
+	size_t nLeaves = tree.getNumberOfLeaves();
+	hct::LeafArray<unsigned int> partition;
+	tree.fitLeafArray(&partition);
+	for (size_t i = 0; i < nLeaves; i++) { partition[i] = static_cast<unsigned int>((i * nPartitions) / nLeaves); }
+
+	GhostLayer ghosts;
+	ghosts.build(tree, partition, nPartitions, width);
+	size_t nGhosts = 0;
+	for (unsigned int p = 0; p < nPartitions; p++) { nGhosts += ghosts.ghostLeaves(p).size(); }
+	std::cout << nLeaves << " leaves, " << nPartitions << " partitions, width " << width << " : " << nGhosts << " ghost leaves" << std::endl;
+
+	hct::LeafArray<VecD> lo, hi;
+	tree.fitLeafArray(&lo);
+	tree.fitLeafArray(&hi);
+	tree.parseLeaves([&](const TreeCursor& cursor)
+	{
+		size_t leaf = tree.leafIndex(cursor.cell());
+		VecD size = VecD(1.0) / VecD(cursor.position().m_resolution);
+		lo[leaf] = VecD(cursor.position().m_position) * size;
+		hi[leaf] = lo[leaf] + size;
+	}
+	, TreeCursor());
+
+	// brute force adjacency
+	for (size_t i = 0; i < nLeaves; i++)
+	{
+		std::vector<size_t> expected;
+		double ilo[D], ihi[D];
+		lo[i].toArray(ilo);
+		hi[i].toArray(ihi);
+		for (size_t j = 0; j < nLeaves; j++)
+		{
+			if (j == i) { continue; }
+			double jlo[D], jhi[D];
+			lo[j].toArray(jlo);
+			hi[j].toArray(jhi);
+			bool touch = true;
+			for (unsigned int a = 0; a < D; a++)
+			{
+				touch = touch && (jlo[a] <= ihi[a] + 1.e-12) && (ilo[a] <= jhi[a] + 1.e-12);
+			}
+			if (touch) { expected.push_back(j); }
+		}
+		std::vector<size_t> adjacent(ghosts.adjacentLeavesBegin(i), ghosts.adjacentLeavesEnd(i));
+		assert(adjacent == expected);
+	}
+
+	for (unsigned int p = 0; p < nPartitions; p++)
+	{
+		// brute force breadth first search
+		std::vector<unsigned int> distance(nLeaves, width + 1);
+		for (size_t leaf : ghosts.ownedLeaves(p)) { assert(partition[leaf] == p); distance[leaf] = 0; }
+		for (unsigned int d = 1; d <= width; d++)
+		{
+			for (size_t i = 0; i < nLeaves; i++)
+			{
+				if (distance[i] != d - 1) { continue; }
+				for (const size_t* n = ghosts.adjacentLeavesBegin(i); n != ghosts.adjacentLeavesEnd(i); ++n)
+				{
+					if (distance[*n] > d) { distance[*n] = d; }
+				}
+			}
+		}
+		size_t nExpected = 0;
+		for (size_t i = 0; i < nLeaves; i++) { if (distance[i] >= 1 && distance[i] <= width) { ++nExpected; } }
+		const std::vector<size_t>& g = ghosts.ghostLeaves(p);
+		assert(g.size() == nExpected);
+		for (size_t i = 0; i < g.size(); i++)
+		{
+			assert(partition[g[i]] != p);
+			assert(ghosts.ghostDistance(p)[i] == distance[g[i]]);
+			if (i > 0) { assert(partition[g[i - 1]] < partition[g[i]] || (partition[g[i - 1]] == partition[g[i]] && g[i - 1] < g[i])); }
+		}
+
+		// receives cover ghost leaves, each one matches a send of its owner
+		size_t nReceived = 0;
+		for (const auto& r : ghosts.receives(p))
+		{
+			assert(r.m_offset == nReceived);
+			nReceived += r.m_leaves.size();
+			const auto& sends = ghosts.sends(r.m_partition);
+			auto s = std::find_if(sends.begin(), sends.end(), [p](const typename GhostLayer::Exchange& e) { return e.m_partition == p; });
+			assert(s != sends.end());
+			assert(s->m_leaves == r.m_leaves);
+			for (size_t leaf : r.m_leaves) { assert(partition[leaf] == r.m_partition); }
+		}
+		assert(nReceived == g.size());
+		for (size_t i = 1; i < ghosts.sends(p).size(); i++) { assert(ghosts.sends(p)[i - 1].m_partition < ghosts.sends(p)[i].m_partition); }
+	}
+}
+
+int main()
+{
+	{
+		std::cout << "2D, uniform 4x4 : ";
+		using Tree = test_trees::Tree<2>;
+		Tree tree(test_trees::subdivisions<2>({ { 2,1 }, { 2,4 } }));
+		test_trees::refineUniform(tree);
+
+		// left and right halves, ghosts are columns of leaves
+		hct::LeafArray<unsigned int> partition;
+		tree.fitLeafArray(&partition);
+		for (size_t i = 0; i < 16; i++) { partition[i] = (i < 8) ? 0 : 1; }
+		hct::HyperCubeTreeGhostLayer<Tree> ghosts;
+		ghosts.build(tree, partition, 2, 1);
+		assert(ghosts.ghostLeaves(0).size() == 4 && ghosts.ghostLeaves(1).size() == 4);
+		ghosts.build(tree, partition, 2, 2);
+		assert(ghosts.ghostLeaves(0).size() == 8 && ghosts.ghostLeaves(1).size() == 8);
+		ghosts.build(tree, partition, 2, 3);
+		assert(ghosts.ghostLeaves(0).size() == 8 && ghosts.receives(0).size() == 1 && ghosts.sends(0).size() == 1);
+		checkGhostLayer(tree, 2, 1);
+	}
+
+	{
+		std::cout << "2D, coarse/fine : ";
+		test_trees::Tree<2> tree(test_trees::subdivisions<2>({ { 2,3 }, { 3,2 }, { 2,2 } }));
+		test_trees::refineCoarseFine(tree);
+		checkGhostLayer(tree, 3, 1);
+		checkGhostLayer(tree, 3, 2);
+	}
+
+	{
+		std::cout << "3D, unbalanced octree : ";
+		test_trees::Tree<3> tree(test_trees::octree(4));
+		test_trees::refineSphere(tree, 5);
+		checkGhostLayer(tree, 4, 1);
+		checkGhostLayer(tree, 7, 2);
+	}
+
+	{
+		std::cout << "3D, mixed subdivisions : ";
+		test_trees::Tree<3> tree(test_trees::subdivisions<3>({ { 2,2,4 }, { 3,3,3 }, { 3,1,3 } }));
+		test_trees::refineShell(tree, 4);
+		checkGhostLayer(tree, 5, 1);
+		checkGhostLayer(tree, 5, 3);
+	}
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "GridDimension.h"
+#include "CellVertexConnectivity.h"
+#include "ScalarFunction.h"
+#include "TreeRefineImplicitSurface.h"
+#include "TreeBalance.h"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <assert.h>
+
+using hct::Vec3d;
+
+// checks that each hanging vertex is the interpolation of its master vertices
+template<typename Tree>
+static size_t testHangingVertices(const Tree& tree)
+{
+	static constexpr unsigned int D = Tree::D;
+	using CellVertexConnectivity = hct::CellVertexConnectivity<Tree>;
+	using HCTVertexOwnershipCursor = typename CellVertexConnectivity::HCTVertexOwnershipCursor;
+	using VecF = hct::Vec<double, D>;
+
+	typename CellVertexConnectivity::VertexIdArray vertexIds;
+	typename CellVertexConnectivity::HangingVertexConstraints constraints;
+
+	size_t nVertices = CellVertexConnectivity::compute(tree, vertexIds, constraints);
+
+	std::vector<VecF> vertexPos(nVertices);
+	tree.parseLeaves([&vertexIds, &vertexPos](const HCTVertexOwnershipCursor& cursor)
+	{
+		for (size_t v = 0; v < CellVertexConnectivity::CellNumberOfVertices; v++)
+		{
+			vertexPos[vertexIds[cursor.cell()][v]] = cursor.vertexPosition(v).normalize();
+		}
+	}, HCTVertexOwnershipCursor(tree));
+
+	assert(constraints.m_offset.size() == constraints.size() + 1);
+	assert(constraints.m_master.size() == constraints.m_weight.size());
+	std::vector<bool> isHanging(nVertices, false);
+	for (size_t i = 0; i < constraints.size(); i++)
+	{
+		size_t vertex = constraints.m_vertex[i];
+		assert(!isHanging[vertex]);
+		isHanging[vertex] = true;
+		double weightSum = 0.0;
+		VecF p(0.0);
+		for (size_t j = constraints.m_offset[i]; j < constraints.m_offset[i + 1]; j++)
+		{
+			assert(constraints.m_master[j] != vertex);
+			assert(constraints.m_weight[j] > 0.0);
+			weightSum += constraints.m_weight[j];
+			p += vertexPos[constraints.m_master[j]] * constraints.m_weight[j];
+		}
+		size_t nMasters = constraints.m_offset[i + 1] - constraints.m_offset[i];
+		assert(nMasters == 2 || nMasters == 4 || nMasters == 8);
+		assert(std::abs(weightSum - 1.0) < 1.e-12);
+		assert(((p - vertexPos[vertex]).abs() < VecF(1.e-12)).reduce_and());
+	}
+
+	std::cout << "vertices = " << nVertices << ", hanging vertices = " << constraints.size()
+		<< ", constraint entries = " << constraints.m_master.size() << std::endl;
+	return constraints.size();
+}
+
+int main()
+{
+	{
+		// 2 hanging vertices, in the middle of edges shared with the coarse siblings
+		using Tree = hct::HyperCubeTree< 2, hct::SimpleSubdivisionScheme<2> >;
+		hct::SimpleSubdivisionScheme<2> subdivisions;
+		subdivisions.addLevelSubdivision({ 2,2 });
+		subdivisions.addLevelSubdivision({ 2,2 });
+		Tree tree(subdivisions);
+		tree.refine(tree.rootCell());
+		tree.refine(tree.child(tree.rootCell(), 0));
+		assert(testHangingVertices(tree) == 2);
+	}
+
+	{
+		// a conforming tree has no hanging vertices
+		using Tree = hct::HyperCubeTree< 3, hct::SimpleSubdivisionScheme<3> >;
+		hct::SimpleSubdivisionScheme<3> subdivisions;
+		subdivisions.addLevelSubdivision({ 3,3,3 });
+		Tree tree(subdivisions);
+		tree.refine(tree.rootCell());
+		assert(testHangingVertices(tree) == 0);
+	}
+
+	{
+		// 3x3x3 refinement of a corner cell : 3 faces with 4 hanging vertices, 9 edges with 2 hanging vertices
+		using Tree = hct::HyperCubeTree< 3, hct::SimpleSubdivisionScheme<3> >;
+		hct::SimpleSubdivisionScheme<3> subdivisions;
+		subdivisions.addLevelSubdivision({ 2,2,2 });
+		subdivisions.addLevelSubdivision({ 3,3,3 });
+		Tree tree(subdivisions);
+		tree.refine(tree.rootCell());
+		tree.refine(tree.child(tree.rootCell(), 0));
+		assert(testHangingVertices(tree) == 3 * 4 + 9 * 2);
+	}
+
+	{
+		using Tree = hct::HyperCubeTree< 3, hct::SimpleSubdivisionScheme<3> >;
+		hct::SimpleSubdivisionScheme<3> subdivisions;
+		subdivisions.addLevelSubdivision({ 4,4,5 });
+		subdivisions.addLevelSubdivision({ 2,2,2 });
+		subdivisions.addLevelSubdivision({ 3,3,3 });
+		subdivisions.addLevelSubdivision({ 2,2,2 });
+		Tree tree(subdivisions);
+		auto sphereA = hct::csg_sphere(Vec3d({ 0.0,0.0,0.0 }), 1.0);
+		auto sphereB = hct::csg_sphere(Vec3d({ 0.5,0.5,0.5 }), 0.5);
+		auto shape = hct::csg_difference(sphereA, sphereB);
+		hct::tree_refine_implicit_surface(tree, shape, subdivisions.getNumberOfLevelSubdivisions() + 1);
+		testHangingVertices(tree);
+		hct::balance(tree);
+		testHangingVertices(tree);
+	}
+
+	return 0;
+}
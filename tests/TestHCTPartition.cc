@@ -0,0 +1,133 @@
+#include "TestTrees.h"
+#include "HyperCubeTreePartition.h"
+#include "LeafArray.h"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <assert.h>
+
+/*
+checks that parts cover leaves in order, that their weights are balanced up to one leaf,
+and that each part's subtree roots cover exactly its leaf range.
+*/
+template<typename Tree>
+static void checkPartition(const Tree& tree, unsigned int nParts, const hct::LeafArray<double>& weights)
+{
+	using Partition = hct::HyperCubeTreePartition<Tree>;
+	using Cell = hct::HyperCubeTreeCell;
+
+	Partition partition;
+	partition.build(tree, nParts, weights);
+
+	size_t nLeaves = tree.getNumberOfLeaves();
+	double total = 0.0, maxWeight = 0.0;
+	for (size_t i = 0; i < nLeaves; i++) { total += weights[i]; maxWeight = std::max(maxWeight, weights[i]); }
+	size_t nRoots = 0;
+	for (unsigned int p = 0; p < nParts; p++) { nRoots += partition.roots(p).size(); }
+	std::cout << nLeaves << " leaves, " << nParts << " parts, imbalance " << partition.imbalance() << ", " << nRoots
+		<< " subtree roots" << std::endl;
+
+	assert(partition.numberOfParts() == nParts);
+	assert(partition.beginLeaf(0) == 0 && partition.endLeaf(nParts - 1) == nLeaves);
+	double sum = 0.0;
+	for (unsigned int p = 0; p < nParts; p++)
+	{
+		assert(partition.beginLeaf(p) <= partition.endLeaf(p));
+		double w = 0.0;
+		for (size_t i = partition.beginLeaf(p); i < partition.endLeaf(p); i++)
+		{
+			w += weights[i];
+			assert(partition.partOf(i) == p);
+		}
+		assert(std::abs(w - partition.weight(p)) < 1.e-9 * total);
+		sum += w;
+
+		// each cut is within half a leaf of its target
+		if (p > 0)
+		{
+			double target = total * p / nParts;
+			assert(std::abs(sum - w - target) <= maxWeight * 0.5 + 1.e-9 * total || partition.beginLeaf(p) == partition.endLeaf(p - 1));
+		}
+
+		// subtree roots, in leaf order, exactly cover the range
+		size_t next = partition.beginLeaf(p);
+		for (Cell root : partition.roots(p))
+		{
+			std::vector<size_t> leaves;
+			tree.preorderParseCells([&tree, &leaves](const typename Tree::DefaultTreeCursor& cursor)
+			{
+				if (tree.isLeaf(cursor.cell())) { leaves.push_back(tree.leafIndex(cursor.cell())); }
+			}
+			, typename Tree::DefaultTreeCursor(root));
+			for (size_t leaf : leaves) { assert(leaf == next); ++next; }
+		}
+		assert(next == partition.endLeaf(p));
+
+		// roots are maximal : at most (grid size - 1) per level on each side
+		size_t maxRoots = 1;
+		for (size_t l = 0; (l + 1) < tree.getNumberOfLevels(); l++) { maxRoots += 2 * (tree.getLevelSubdivisionGrid(l).gridSize() - 1); }
+		assert(partition.roots(p).size() <= maxRoots);
+	}
+
+	hct::LeafArray<unsigned int> parts;
+	partition.leafParts(parts);
+	assert(parts.size() == nLeaves);
+	for (size_t i = 0; i < nLeaves; i++) { assert(parts[i] == partition.partOf(i)); }
+}
+
+int main()
+{
+	{
+		std::cout << "2D, uniform 4x4 : ";
+		using Tree = test_trees::Tree<2>;
+		Tree tree(test_trees::subdivisions<2>({ { 2,2 }, { 2,2 } }));
+		test_trees::refineUniform(tree);
+
+		// quadrants
+		hct::HyperCubeTreePartition<Tree> partition;
+		partition.build(tree, 4);
+		for (unsigned int p = 0; p < 4; p++)
+		{
+			assert(partition.beginLeaf(p) == 4 * p);
+			assert(partition.roots(p).size() == 1 && partition.roots(p)[0] == tree.child(tree.rootCell(), p));
+		}
+		assert(partition.imbalance() == 1.0);
+
+		// one part : the root
+		partition.build(tree, 1);
+		assert(partition.roots(0).size() == 1 && partition.roots(0)[0] == tree.rootCell());
+
+		// more parts than leaves
+		hct::LeafArray<double> weights;
+		tree.fitLeafArray(&weights);
+		weights.fill(1.0);
+		checkPartition(tree, 20, weights);
+	}
+
+	{
+		std::cout << "3D, unbalanced octree, level weights : ";
+		test_trees::Tree<3> tree(test_trees::octree(6));
+		test_trees::refineSphere(tree, 7);
+
+		// subcycling cost : twice the work per level
+		hct::LeafArray<double> weights;
+		tree.fitLeafArray(&weights);
+		tree.forEachLeaf([&weights](size_t leaf, hct::HyperCubeTreeCell cell) { weights[leaf] = std::pow(2.0, cell.level()); });
+		checkPartition(tree, 7, weights);
+		checkPartition(tree, 64, weights);
+	}
+
+	{
+		std::cout << "3D, mixed subdivisions, one heavy leaf : ";
+		test_trees::Tree<3> tree(test_trees::mixed());
+		test_trees::refineShell(tree, 5);
+		hct::LeafArray<double> weights;
+		tree.fitLeafArray(&weights);
+		weights.fill(1.0);
+		weights[weights.size() / 3] = weights.size() / 2.0;
+		checkPartition(tree, 9, weights);
+	}
+
+	return 0;
+}
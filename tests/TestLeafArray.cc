@@ -0,0 +1,77 @@
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "LeafArray.h"
+#include "TreeLevelArray.h"
+
+#include <iostream>
+#include <numeric>
+
+int main()
+{
+	hct::SimpleSubdivisionScheme<2> subdivisions;
+	subdivisions.addLevelSubdivision( {2,3} );
+	subdivisions.addLevelSubdivision( {2,2} );
+	subdivisions.addLevelSubdivision( {3,3} );
+
+	using Tree = hct::HyperCubeTree< 2, hct::SimpleSubdivisionScheme<2> >;
+	using TreeCursor = hct::HyperCubeTreeCursor<Tree>;
+	Tree tree(subdivisions);
+
+	std::cout << "root only : " << tree.getNumberOfLeaves() << " leaves" << std::endl;
+	assert(tree.getNumberOfLeaves() == 1);
+	assert(tree.leafCell(0) == tree.rootCell());
+
+	tree.refine(tree.rootCell());
+	tree.refine(tree.child(tree.rootCell(), 1));
+	tree.refine(tree.child(tree.rootCell(), 4));
+	tree.refine(tree.child(tree.child(tree.rootCell(), 4), 3));
+
+	size_t nLeaves = tree.getNumberOfLeaves();
+	std::cout << "refined tree : " << nLeaves << " leaves" << std::endl;
+	assert(nLeaves == (6 - 2) + (4 - 1) + 4 + 9);
+
+	// leaf numbering must follow parseLeaves order, and be a bijection
+	size_t counter = 0;
+	tree.parseLeaves([&tree, &counter](const TreeCursor& cursor)
+	{
+		assert(tree.leafIndex(cursor.cell()) == counter);
+		assert(tree.leafCell(counter) == cursor.cell());
+		++counter;
+	});
+	assert(counter == nLeaves);
+
+	// round trip between per-level array and leaf array
+	hct::TreeLevelArray<double> levelValues;
+	tree.addArray(&levelValues);
+	levelValues.fill(-1.0);
+	tree.parseLeaves([&levelValues](const TreeCursor& cursor)
+	{
+		levelValues[cursor.cell()] = cursor.cell().level() * 100.0 + cursor.cell().index();
+	});
+
+	hct::LeafArray<double> leafValues;
+	leafValues.setName("leafValues");
+	leafValues.gather(tree, levelValues);
+	assert(leafValues.size() == nLeaves);
+	tree.forEachLeaf([&tree, &leafValues, &levelValues](size_t i, hct::HyperCubeTreeCell cell)
+	{
+		assert(leafValues[i] == levelValues[cell]);
+		assert(leafValues.at(tree, cell) == levelValues[cell]);
+	});
+
+	for (auto& x : leafValues) { x *= 2.0; }
+	leafValues.scatter(tree, levelValues);
+	double sum = std::accumulate(leafValues.begin(), leafValues.end(), 0.0);
+	double levelSum = 0.0;
+	tree.parseLeaves([&levelSum, &levelValues](const TreeCursor& cursor) { levelSum += levelValues[cursor.cell()]; });
+	std::cout << "sum of leaf values = " << sum << std::endl;
+	assert(sum == levelSum);
+
+	// numbering is refreshed after a topology change
+	tree.refine(tree.leafCell(0));
+	assert(tree.getNumberOfLeaves() == nLeaves + 3);
+	tree.fitLeafArray(&leafValues);
+	assert(leafValues.size() == nLeaves + 3);
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include "MonotonicArena.h"
+#include "HyperCubeTreeContext.h"
+#include "ScalarFunction.h"
+#include "ScalarFunctionInput.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdint>
+
+struct Counted
+{
+	inline Counted(int& counter, int v) : m_counter(counter), m_value(v) { ++m_counter; }
+	inline ~Counted() { --m_counter; }
+	int& m_counter;
+	int m_value;
+};
+
+struct alignas(64) Aligned
+{
+	double x[3];
+};
+
+int main()
+{
+	int alive = 0;
+	{
+		hct::MonotonicArena arena(256);
+		for (int i = 0; i < 100; i++)
+		{
+			Counted* c = arena.create<Counted>(alive, i);
+			assert(c->m_value == i);
+		}
+		Aligned* a = arena.create<Aligned>();
+		assert(reinterpret_cast<uintptr_t>(a) % 64 == 0);
+		void* big = arena.allocate(10000);
+		assert(big != nullptr);
+		std::cout << "alive=" << alive << ", blocks=" << arena.numberOfBlocks() << ", bytes=" << arena.allocatedBytes() << std::endl;
+		assert(alive == 100);
+
+		// moving the arena keeps objects alive
+		hct::MonotonicArena other(std::move(arena));
+		assert(arena.numberOfBlocks() == 0);
+		assert(alive == 100);
+		other.release();
+		assert(alive == 0);
+		other.create<Counted>(alive, 0);
+		assert(alive == 1);
+	}
+	assert(alive == 0);
+
+	// functions read in an arena
+	{
+		std::istringstream input("csg_difference sphere 0.0 0.0 0.0 1.0 sphere 0.5 0.5 0.5 0.5");
+		hct::MonotonicArena arena;
+		auto f = hct::scalar_function_read<3, double>(input, &arena);
+		assert(!f.m_f_owner);
+		double v = f(hct::Vec3d(0.5)).value();
+		std::cout << "f(0.5,0.5,0.5) = " << v << ", arena bytes=" << arena.allocatedBytes() << std::endl;
+		assert(v == 0.5);
+	}
+
+	// batch of contexts, each released in one shot
+	for (int i = 0; i < 10; i++)
+	{
+		hct::HyperCubeTreeContext<2> context;
+		hct::SimpleSubdivisionScheme<2> subdivisions;
+		subdivisions.addLevelSubdivision({ 2,2 });
+		subdivisions.addLevelSubdivision({ 2,2 });
+		auto& tree = context.createTree(subdivisions);
+		tree.refine(tree.rootCell());
+		auto& field = context.addScalarField("values");
+		field.fill(1.0);
+		assert(context.findScalarField("values") == &field);
+		hct::HyperCubeTreeContext<2> moved(std::move(context));
+		assert(!context.hasTree());
+		assert(moved.tree().getNumberOfLeaves() == 4);
+	}
+
+	return 0;
+}
@@ -0,0 +1,51 @@
+#include "RadixSort.h"
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <assert.h>
+
+// radix sort must give the same result as a stable comparison sort on keys
+template<typename KeyT>
+static void testRadixSort(size_t n, KeyT maxKey)
+{
+	std::mt19937_64 rng(n);
+	std::uniform_int_distribution<KeyT> dist(0, maxKey);
+	std::vector<KeyT> keys(n);
+	std::vector<int> values(n);
+	std::vector< std::pair<KeyT,int> > reference(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		keys[i] = dist(rng);
+		values[i] = static_cast<int>(i);
+		reference[i] = std::make_pair(keys[i], values[i]);
+	}
+	std::stable_sort(reference.begin(), reference.end(), [](const std::pair<KeyT,int>& a, const std::pair<KeyT,int>& b) { return a.first < b.first; });
+
+	hct::radixSort(keys, values, hct::radixSortKeyBits(uint64_t(maxKey) + 1));
+	for (size_t i = 0; i < n; i++)
+	{
+		assert(keys[i] == reference[i].first);
+		assert(values[i] == reference[i].second);
+	}
+	std::cout << "radix sort of " << n << " keys in [0;" << uint64_t(maxKey) << "] Ok" << std::endl;
+}
+
+int main()
+{
+	assert(hct::radixSortKeyBits(1) == 0);
+	assert(hct::radixSortKeyBits(2) == 1);
+	assert(hct::radixSortKeyBits(256) == 8);
+	assert(hct::radixSortKeyBits(257) == 9);
+
+	testRadixSort<uint64_t>(0, 100);
+	testRadixSort<uint64_t>(1000, 10);
+	testRadixSort<uint32_t>(100000, 5000);
+	testRadixSort<uint64_t>(300000, (uint64_t(1) << 40) - 1);
+	testRadixSort<uint64_t>(200000, UINT64_MAX - 1);
+
+	return 0;
+}
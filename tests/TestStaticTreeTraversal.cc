@@ -0,0 +1,119 @@
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "StaticSubdivisionScheme.h"
+#include "GridDimension.h"
+#include "GridEnum.h"
+#include "ScalarFunction.h"
+#include "TreeRefineImplicitSurface.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "HyperCubeTreeNeighborCursor.h"
+
+#include <iostream>
+#include <vector>
+#include <assert.h>
+
+using hct::Vec3d;
+
+static constexpr size_t NLevels = 4;
+using StaticScheme = hct::StaticSubdivisionScheme< NLevels, 2, 2, 2 >;
+using StaticTree = hct::HyperCubeTree< 3, StaticScheme >;
+using SimpleScheme = hct::SimpleSubdivisionScheme<3>;
+using SimpleTree = hct::HyperCubeTree< 3, SimpleScheme >;
+using CellPosition = hct::HyperCubeTreeCellPosition<3>;
+
+// static branch computation and enumeration must match the generic ones
+template<unsigned int... S>
+static void checkStaticGrid()
+{
+	using GridDim = hct::StaticGridDim<S...>;
+	using Traversal = hct::SubdivisionSchemeTraversal< GridDim::D, hct::StaticSubdivisionScheme<1, S...> >;
+	hct::GridDimension<GridDim::D> grid = GridDim::value();
+	assert(GridDim::GridSize == grid.gridSize());
+	size_t count = 0;
+	Traversal::forEachChildLocation(grid, [&count, grid](hct::Vec<unsigned int, GridDim::D> loc)
+	{
+		assert(GridDim::branch(loc) == count);
+		assert(grid.branch(loc) == count);
+		assert((GridDim::location(count) == loc).reduce_and());
+		++count;
+	});
+	assert(count == grid.gridSize());
+	std::cout << "static grid "; grid.toStream(std::cout); std::cout << " : " << count << " locations Ok" << std::endl;
+}
+
+template<typename Tree>
+static std::vector<CellPosition> buildTree(Tree& tree)
+{
+	auto sphereA = hct::csg_sphere(Vec3d({ 0.0,0.0,0.0 }), 1.0);
+	auto sphereB = hct::csg_sphere(Vec3d({ 0.5,0.5,0.5 }), 0.5);
+	auto shape = hct::csg_difference(sphereA, sphereB);
+	hct::tree_refine_implicit_surface(tree, shape, NLevels + 1);
+
+	std::vector<CellPosition> leaves;
+	tree.parseLeaves([&leaves](const hct::HyperCubeTreeLocatedCursor<Tree>& cursor)
+	{
+		leaves.push_back(cursor.position());
+	}, hct::HyperCubeTreeLocatedCursor<Tree>() );
+	return leaves;
+}
+
+// neighborhoods of all leaves, in traversal order
+template<typename Tree>
+static void collectNeighbors(const Tree& tree, std::vector<hct::HyperCubeTreeCell>& cells, std::vector<CellPosition>& positions)
+{
+	using NbhTreeCursor = hct::HyperCubeTreeNeighborCursor<Tree>;
+	tree.parseLeaves([&cells, &positions](const NbhTreeCursor& cursor)
+	{
+		cursor.m_nbh.forEachValue([&cells, &positions](const typename NbhTreeCursor::HCubeComponentValue& v)
+		{
+			cells.push_back(v.m_cell);
+			positions.push_back(v.m_position);
+		});
+	}, NbhTreeCursor());
+}
+
+int main()
+{
+	checkStaticGrid<2, 2, 2>();
+	checkStaticGrid<3, 3, 3>();
+	checkStaticGrid<1, 2, 3>();
+	checkStaticGrid<4, 4, 20>();
+	checkStaticGrid<2, 3>();
+
+	SimpleScheme simpleScheme;
+	for (size_t i = 0; i < NLevels; i++) { simpleScheme.addLevelSubdivision({ 2,2,2 }); }
+
+	StaticTree staticTree( (StaticScheme()) );
+	SimpleTree simpleTree( simpleScheme );
+
+	std::vector<CellPosition> staticLeaves = buildTree(staticTree);
+	std::vector<CellPosition> simpleLeaves = buildTree(simpleTree);
+
+	// both trees must be identical, with leaves visited in the same order
+	std::cout << "leaves : static = " << staticLeaves.size() << ", simple = " << simpleLeaves.size() << std::endl;
+	assert(staticLeaves.size() == simpleLeaves.size());
+	assert(staticTree.getNumberOfLeaves() == simpleTree.getNumberOfLeaves());
+	for (size_t i = 0; i < staticLeaves.size(); i++)
+	{
+		assert(staticLeaves[i] == simpleLeaves[i]);
+		assert(staticTree.leafCell(i) == simpleTree.leafCell(i));
+	}
+
+	// static neighbor digging must find the same neighbors as the generic one
+	std::vector<hct::HyperCubeTreeCell> staticCells, simpleCells;
+	std::vector<CellPosition> staticPositions, simplePositions;
+	collectNeighbors(staticTree, staticCells, staticPositions);
+	collectNeighbors(simpleTree, simpleCells, simplePositions);
+	assert(staticCells.size() == simpleCells.size());
+	size_t nbNeighbors = 0;
+	for (size_t i = 0; i < staticCells.size(); i++)
+	{
+		assert(staticCells[i] == simpleCells[i]);
+		assert((staticPositions[i].m_position == simplePositions[i].m_position).reduce_and());
+		assert((staticPositions[i].m_resolution == simplePositions[i].m_resolution).reduce_and());
+		if (staticCells[i].isTreeCell()) { ++nbNeighbors; }
+	}
+	std::cout << "neighbors : " << nbNeighbors << " Ok" << std::endl;
+
+	return 0;
+}
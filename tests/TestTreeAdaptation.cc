@@ -0,0 +1,148 @@
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "HyperCubeTreeNeighborCursor.h"
+#include "TreeLevelArray.h"
+#include "TreeFieldTransfer.h"
+#include "TreeAdaptation.h"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <assert.h>
+
+using hct::Vec2d;
+using Tree = hct::HyperCubeTree< 2, hct::SimpleSubdivisionScheme<2> >;
+using LocatedCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+using NbhCursor = hct::HyperCubeTreeNeighborCursor<Tree>;
+using Adaptation = hct::TreeAdaptation<Tree>;
+
+static constexpr size_t MaxLevel = 7;
+
+static double distanceToFront(const hct::HyperCubeTreeCellPosition<2>& position, double radius)
+{
+	Vec2d c = (Vec2d(position.m_position) + 0.5) / Vec2d(position.m_resolution);
+	double x[2];
+	c.toArray(x);
+	return std::sqrt((x[0] - 0.5) * (x[0] - 0.5) + (x[1] - 0.5) * (x[1] - 0.5)) - radius;
+}
+
+// a sharp circular front, sampled at cell centers (refined cells too)
+static void sampleFront(const Tree& tree, hct::TreeLevelArray<double>& phi, double radius)
+{
+	tree.preorderParseCells([&](const LocatedCursor& cursor)
+	{
+		phi[cursor.cell()] = (distanceToFront(cursor.position(), radius) < 0.0) ? 1.0 : 0.0;
+	}
+	, LocatedCursor());
+}
+
+static size_t maxLevelJump(const Tree& tree)
+{
+	size_t maxJump = 0;
+	tree.parseLeaves([&maxJump](const NbhCursor& cursor)
+	{
+		size_t level = cursor.cell().level();
+		cursor.m_nbh.forEachValue([level, &maxJump](const NbhCursor::HCubeComponentValue& v)
+		{
+			if (v.m_cell.isTreeCell() && v.m_cell.level() < level) { maxJump = std::max(maxJump, level - v.m_cell.level()); }
+		});
+	}, NbhCursor());
+	return maxJump;
+}
+
+static double integral(const Tree& tree, const hct::TreeLevelArray<double>& q)
+{
+	double sum = 0.0;
+	tree.parseLeaves([&](const LocatedCursor& cursor) { sum += q[cursor.cell()] / static_cast<double>(cursor.position().m_resolution.reduce_mul()); }, LocatedCursor());
+	return sum;
+}
+
+// adapts until the tree does not change any more, returns the number of calls
+static size_t adaptToFront(Tree& tree, hct::TreeLevelArray<double>& phi, double radius, const Adaptation::Parameters& params)
+{
+	for (size_t n = 1; ; n++)
+	{
+		sampleFront(tree, phi, radius);
+		Adaptation::Result r = Adaptation::adapt(tree, phi, params);
+		assert(maxLevelJump(tree) <= params.m_maxLevelJump);
+		if (r.m_refined == 0 && r.m_coarsened == 0 && r.m_balanced == 0) { return n; }
+		assert(n < 4 * MaxLevel);
+	}
+}
+
+// leaves crossed by the front are at the finest level, leaves far from it are coarse
+static void checkFront(const Tree& tree, double radius, const Adaptation::Parameters& params)
+{
+	size_t nFine = 0;
+	tree.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		double size = 1.0 / static_cast<double>(cursor.position().m_resolution.reduce_max());
+		double d = std::abs(distanceToFront(cursor.position(), radius));
+		if (d < 0.5 * size) { assert(cursor.cell().level() == params.m_maxLevel); }
+		if (d > 0.3) { assert(cursor.cell().level() <= params.m_minLevel + 1); }
+		if (cursor.cell().level() == params.m_maxLevel) { ++nFine; }
+	}
+	, LocatedCursor());
+	std::cout << "radius " << radius << " : " << tree.getNumberOfLeaves() << " leaves, " << nFine << " at level " << params.m_maxLevel << std::endl;
+}
+
+int main()
+{
+	hct::SimpleSubdivisionScheme<2> subdivisions;
+	for (size_t i = 0; i < MaxLevel; i++) { subdivisions.addLevelSubdivision({ 2,2 }); }
+	Tree tree(subdivisions);
+
+	// phi drives adaptation, q is only transferred : its integral must never change
+	hct::TreeLevelArray<double> phi, q;
+	tree.addArray(&phi);
+	tree.addArray(&q);
+	hct::TreeFieldTransfer<Tree> transfer(tree);
+	transfer.addField(&q);
+
+	Adaptation::Parameters params;
+	params.m_minLevel = 2;
+	params.m_maxLevel = MaxLevel;
+	params.m_maxLevelJump = 1;
+
+	tree.refine(Tree::rootCell());
+	for (size_t i = 0; i < 4; i++) { tree.refine(hct::HyperCubeTreeCell(1, i)); }
+	tree.parseLeaves([&q](const LocatedCursor& cursor)
+	{
+		Vec2d c = (Vec2d(cursor.position().m_position) + 0.5) / Vec2d(cursor.position().m_resolution);
+		q[cursor.cell()] = 1.0 + c.reduce_add();
+	}
+	, LocatedCursor());
+	transfer.restrictFields();
+	double q0 = integral(tree, q);
+
+	// hysteresis : an indicator between the thresholds keeps the leaf
+	{
+		hct::LeafArray<int8_t> marks;
+		Adaptation::mark(tree, [](const NbhCursor&) { return 0.5; }, params, marks);
+		for (size_t i = 0; i < marks.size(); i++) { assert(marks[i] == Adaptation::Keep); }
+	}
+
+	// the front expands, the fine region follows it and coarsens behind
+	size_t firstLeafCount = 0;
+	for (double radius = 0.2; radius < 0.41; radius += 0.05)
+	{
+		transfer.restrictFields();
+		size_t n = adaptToFront(tree, phi, radius, params);
+		checkFront(tree, radius, params);
+		std::cout << "\tadapted in " << n << " calls, integral of q = " << integral(tree, q) << std::endl;
+		assert(std::abs(integral(tree, q) - q0) < 1e-12);
+		if (firstLeafCount == 0) { firstLeafCount = tree.getNumberOfLeaves(); }
+	}
+	assert(tree.getNumberOfLeaves() < 4 * firstLeafCount);
+	assert(tree.checkArraySizes());
+
+	// front gone : back to the minimum level
+	sampleFront(tree, phi, 2.0);
+	for (size_t i = 0; i < MaxLevel; i++) { Adaptation::adapt(tree, phi, params); }
+	std::cout << "no front : " << tree.getNumberOfLeaves() << " leaves" << std::endl;
+	assert(tree.getNumberOfLeaves() == 16);
+	assert(std::abs(integral(tree, q) - q0) < 1e-12);
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+#include "TestTrees.h"
+#include "HyperCubeTreeNeighborCursor.h"
+#include "TreeBalance.h"
+
+#include <iostream>
+#include <assert.h>
+
+// returns the largest level difference between a leaf and its neighbor leaves
+template<typename Tree>
+static size_t maxLevelJump(const Tree& tree)
+{
+	using NbhTreeCursor = hct::HyperCubeTreeNeighborCursor<Tree>;
+	size_t maxJump = 0;
+	tree.parseLeaves([&maxJump](const NbhTreeCursor& cursor)
+	{
+		size_t level = cursor.cell().level();
+		cursor.m_nbh.forEachValue([level, &maxJump](const typename NbhTreeCursor::HCubeComponentValue& v)
+		{
+			if (v.m_cell.isTreeCell() && v.m_cell.level() < level && (level - v.m_cell.level()) > maxJump)
+			{
+				maxJump = level - v.m_cell.level();
+			}
+		});
+	}, NbhTreeCursor());
+	return maxJump;
+}
+
+static void testTreeBalance(hct::SimpleSubdivisionScheme<3> subdivisions, size_t jump)
+{
+	using Tree = test_trees::Tree<3>;
+
+	std::cout << "-----------------------\n";
+	subdivisions.toStream(std::cout);
+
+	Tree tree(subdivisions);
+	test_trees::refineShell(tree, subdivisions.getNumberOfLevelSubdivisions() + 1);
+
+	size_t nLeaves = tree.getNumberOfLeaves();
+	size_t initialJump = maxLevelJump(tree);
+	std::cout << "before balance : leaves = " << nLeaves << ", max level jump = " << initialJump << std::endl;
+
+	size_t nRefined = hct::balance(tree, jump);
+
+	size_t finalJump = maxLevelJump(tree);
+	std::cout << "balance(" << jump << ") : refined = " << nRefined << ", leaves = " << tree.getNumberOfLeaves()
+		<< ", max level jump = " << finalJump << std::endl;
+
+	assert(finalJump <= jump);
+	assert(tree.checkArraySizes());
+	assert((nRefined == 0) == (initialJump <= jump));
+	assert(tree.getNumberOfLeaves() >= nLeaves);
+
+	// balancing a balanced tree does nothing
+	nRefined = hct::balance(tree, jump);
+	assert(nRefined == 0);
+}
+
+int main()
+{
+	hct::SimpleSubdivisionScheme<3> octree = test_trees::octree(6);
+	testTreeBalance(octree, 1);
+	testTreeBalance(octree, 2);
+	testTreeBalance(octree, 5);
+
+	testTreeBalance(test_trees::subdivisions<3>({ { 2,2,4 }, { 3,3,3 }, { 2,2,2 }, { 3,3,3 }, { 2,2,2 } }), 1);
+
+	return 0;
+}
@@ -0,0 +1,210 @@
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "TreeLevelArray.h"
+#include "TreeFieldTransfer.h"
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <assert.h>
+
+using hct::Vec2d;
+using Tree = hct::HyperCubeTree< 2, hct::SimpleSubdivisionScheme<2> >;
+using LocatedCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+using Transfer = hct::TreeFieldTransfer<Tree>;
+
+static double linear(const hct::HyperCubeTreeCellPosition<2>& position)
+{
+	Vec2d c = (Vec2d(position.m_position) + 0.5) / Vec2d(position.m_resolution);
+	double x[2];
+	c.toArray(x);
+	return 1.0 + x[0] + 2.0 * x[1];
+}
+
+static double step(const hct::HyperCubeTreeCellPosition<2>& position)
+{
+	Vec2d c = (Vec2d(position.m_position) + 0.5) / Vec2d(position.m_resolution);
+	double x[2];
+	c.toArray(x);
+	return (x[0] < 0.5) ? 1.0 : 0.0;
+}
+
+// parent links and positions agree with a located traversal
+static void checkTopology(const Tree& tree)
+{
+	assert(tree.checkArraySizes());
+	tree.preorderParseCells([&tree](const LocatedCursor& cursor)
+	{
+		assert(tree.cellPosition(cursor.cell()) == cursor.position());
+		if (!tree.isLeaf(cursor.cell()))
+		{
+			assert(tree.parent(tree.child(cursor.cell(), static_cast<size_t>(0))) == cursor.cell());
+		}
+	}
+	, LocatedCursor());
+}
+
+static void testTransfer()
+{
+	hct::SimpleSubdivisionScheme<2> subdivisions;
+	subdivisions.addLevelSubdivision({ 2,2 });
+	subdivisions.addLevelSubdivision({ 3,2 });
+	subdivisions.addLevelSubdivision({ 2,2 });
+	subdivisions.addLevelSubdivision({ 2,3 });
+
+	Tree tree(subdivisions);
+	hct::TreeLevelArray<double> u, s;
+	hct::TreeLevelArray< std::array<double, 2> > w;
+	tree.addArray(&u);
+	tree.addArray(&s);
+	tree.addArray(&w);
+	Transfer transfer(tree);
+	transfer.addField(&u);
+	transfer.addField(&s);
+	transfer.addField(&w, Transfer::Prolongation::Constant);
+	assert(transfer.numberOfFields() == 3);
+
+	// a uniform level 2, values set on leaves only
+	tree.refine(Tree::rootCell());
+	for (size_t i = 0; i < 4; i++) { tree.refine(hct::HyperCubeTreeCell(1, i)); }
+	tree.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		u[cursor.cell()] = linear(cursor.position());
+		s[cursor.cell()] = step(cursor.position());
+		w[cursor.cell()] = { { 3.0, linear(cursor.position()) } };
+	}
+	, LocatedCursor());
+	transfer.restrictFields();
+	assert(std::abs(u[Tree::rootCell()] - 2.5) < 1e-12);
+	checkTopology(tree);
+
+	// refine every leaf : the linear field is reproduced exactly by interior leaves,
+	// boundary leaves get a zero slope across the boundary, all children average to their parent
+	std::vector<hct::HyperCubeTreeCell> leaves;
+	tree.parseLeaves([&leaves](const LocatedCursor& cursor) { leaves.push_back(cursor.cell()); }, LocatedCursor());
+	for (auto cell : leaves) { tree.refine(cell); }
+	checkTopology(tree);
+	size_t nExact = 0;
+	tree.preorderParseCells([&](const LocatedCursor& cursor)
+	{
+		hct::HyperCubeTreeCell cell = cursor.cell();
+		if (cell.level() != 3) { return; }
+		hct::HyperCubeTreeCell parent = tree.parent(cell);
+		hct::HyperCubeTreeCellPosition<2> pp = tree.cellPosition(parent);
+		bool interior = !pp.boundary() && ((pp.m_position + 1) < pp.m_resolution).reduce_and();
+		if (interior)
+		{
+			assert(std::abs(u[cell] - linear(cursor.position())) < 1e-12);
+			++nExact;
+		}
+		assert(w[cell][0] == 3.0 && w[cell][1] == w[parent][1]);
+		assert(s[cell] >= 0.0 && s[cell] <= 1.0);
+	}
+	, LocatedCursor());
+	assert(nExact == 8 * 4);
+	for (auto cell : leaves)
+	{
+		double su = 0.0, ss = 0.0;
+		for (size_t i = 0; i < 4; i++)
+		{
+			su += u[tree.child(cell, i)];
+			ss += s[tree.child(cell, i)];
+		}
+		assert(std::abs(su / 4.0 - u[cell]) < 1e-12);
+		assert(std::abs(ss / 4.0 - s[cell]) < 1e-12);
+	}
+
+	// modify leaves, coarsen some of them : parents get the average of their children, indices of other cells shift
+	tree.parseLeaves([&](const LocatedCursor& cursor) { u[cursor.cell()] += cursor.position().m_position.reduce_add(); }, LocatedCursor());
+	std::vector<hct::HyperCubeTreeCell> coarsen = { leaves[1], leaves[6], leaves[7] };
+	std::vector<double> expected;
+	for (auto cell : coarsen)
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < 4; i++) { sum += u[tree.child(cell, i)]; }
+		expected.push_back(sum / 4.0);
+	}
+	size_t nLeaves = tree.getNumberOfLeaves();
+	tree.coarsen(coarsen);
+	assert(tree.getNumberOfLeaves() == nLeaves - 3 * 3);
+	checkTopology(tree);
+	for (size_t i = 0; i < coarsen.size(); i++)
+	{
+		assert(tree.isLeaf(coarsen[i]));
+		assert(std::abs(u[coarsen[i]] - expected[i]) < 1e-12);
+	}
+
+	// nested coarsening in one call, down to the root's children
+	std::vector<hct::HyperCubeTreeCell> all;
+	tree.preorderParseCells([&](const LocatedCursor& cursor)
+	{
+		if (cursor.cell().level() >= 1 && !tree.isLeaf(cursor.cell())) { all.push_back(cursor.cell()); }
+	}
+	, LocatedCursor());
+	transfer.restrictFields();
+	std::vector<double> top;
+	for (size_t i = 0; i < 4; i++) { top.push_back(u[hct::HyperCubeTreeCell(1, i)]); }
+	tree.coarsen(all);
+	assert(tree.getNumberOfLeaves() == 4);
+	assert(tree.getLevelSize(2) == 0 && tree.getLevelSize(3) == 0);
+	checkTopology(tree);
+	for (size_t i = 0; i < 4; i++) { assert(std::abs(u[hct::HyperCubeTreeCell(1, i)] - top[i]) < 1e-12); }
+
+	std::cout << "transfer : " << nExact << " exact interior children, coarsening ok" << std::endl;
+}
+
+// refining along a discontinuity : no new extrema, total integral preserved
+static void testDiscontinuity()
+{
+	hct::SimpleSubdivisionScheme<2> subdivisions;
+	for (int i = 0; i < 6; i++) { subdivisions.addLevelSubdivision({ 2,2 }); }
+	Tree tree(subdivisions);
+	hct::TreeLevelArray<double> u;
+	tree.addArray(&u);
+	Transfer transfer(tree);
+	transfer.addField(&u);
+
+	u[Tree::rootCell()] = 0.0;
+	for (size_t level = 0; level < 6; level++)
+	{
+		std::vector<hct::HyperCubeTreeCell> refine;
+		tree.parseLeaves([&](const LocatedCursor& cursor)
+		{
+			Vec2d size = Vec2d(1.0) / Vec2d(cursor.position().m_resolution);
+			Vec2d c = (Vec2d(cursor.position().m_position) + 0.5) * size;
+			double x[2];
+			c.toArray(x);
+			if (level < 3 || std::abs(std::sqrt((x[0] - 0.4) * (x[0] - 0.4) + (x[1] - 0.5) * (x[1] - 0.5)) - 0.3) < size.reduce_max())
+			{
+				refine.push_back(cursor.cell());
+			}
+			if (level == 3) { u[cursor.cell()] = (x[0] < 0.4) ? 1.0 : 0.0; }
+		}
+		, LocatedCursor());
+		if (level == 3) { transfer.restrictFields(); }
+		for (auto cell : refine) { tree.refine(cell); }
+	}
+
+	double integral = 0.0, umin = 1.0, umax = 0.0;
+	tree.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		double v = u[cursor.cell()];
+		integral += v / static_cast<double>(cursor.position().m_resolution.reduce_mul());
+		umin = std::min(umin, v);
+		umax = std::max(umax, v);
+	}
+	, LocatedCursor());
+	std::cout << "discontinuity : " << tree.getNumberOfLeaves() << " leaves, integral = " << integral << ", range = [" << umin << ',' << umax << ']' << std::endl;
+	assert(std::abs(integral - u[Tree::rootCell()]) < 1e-12);
+	assert(umin >= 0.0 && umax <= 1.0);
+	checkTopology(tree);
+}
+
+int main()
+{
+	testTransfer();
+	testDiscontinuity();
+	return 0;
+}
@@ -32,12 +32,13 @@ int main(int argc, char* argv[])
 
 	std::cout << "read tree from " << inputFileName << std::endl;
 	std::cout.flush();
-	std::vector< hct::TreeLevelArray<double> * > scalars;
-	std::vector< hct::TreeLevelArray<hct::Vec<double,3> > * > vectors;
-	Tree *tree = hct::read_tree<3,double>(input,scalars,vectors);
+	auto context = hct::read_tree<3,double>(input);
+	Tree* tree = &context.tree();
 
 	assert(tree->checkArraySizes());
+	assert(tree->getNumberOfArrays() == context.scalars().size() + context.vectors().size());
 	tree->toStream(std::cout);
+	std::cout << "context arena size : " << context.allocatedBytes() << " bytes" << std::endl;
 
 	return 0;
 }
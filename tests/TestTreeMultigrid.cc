@@ -0,0 +1,114 @@
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "TreeMultigrid.h"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <assert.h>
+
+static const double Pi = 3.14159265358979323846;
+
+// refines leaves near a circle, then a few levels everywhere it is not
+template<typename Tree>
+static void refineAroundCircle(Tree& tree, size_t uniformLevel, size_t maxLevel)
+{
+	using LocatedCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+	using VecD = hct::Vec<double, Tree::D>;
+	for (;;)
+	{
+		std::vector<hct::HyperCubeTreeCell> refine;
+		tree.parseLeaves([&](const LocatedCursor& cursor)
+		{
+			size_t level = cursor.cell().level();
+			VecD size = VecD(1.0) / VecD(cursor.position().m_resolution);
+			VecD c = (VecD(cursor.position().m_position) + 0.5) * size;
+			double d = std::sqrt((c - VecD(0.5)).length2()) - 0.3;
+			if (level < uniformLevel || (level < maxLevel && std::abs(d) < std::sqrt(size.length2()))) { refine.push_back(cursor.cell()); }
+		}
+		, LocatedCursor());
+		if (refine.empty()) { break; }
+		for (auto cell : refine) { tree.refine(cell); }
+	}
+}
+
+// solves laplacian(u) = f for a known u, checks the convergence rate and the error
+template<typename Tree, typename ExactT>
+static void testPoisson(const Tree& tree, typename hct::TreeMultigrid<Tree>::Boundary boundary, ExactT exact, double waveNumber2, double maxRate, const char* name)
+{
+	using LocatedCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+	using VecD = hct::Vec<double, Tree::D>;
+	using Multigrid = hct::TreeMultigrid<Tree>;
+
+	Multigrid mg(tree, VecD(1.0), boundary);
+	tree.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		VecD c = (VecD(cursor.position().m_position) + 0.5) / VecD(cursor.position().m_resolution);
+		mg.rightHandSide()[cursor.cell()] = -waveNumber2 * exact(c);
+		mg.solution()[cursor.cell()] = 0.0;
+	}
+	, LocatedCursor());
+
+	double r0 = mg.residualNorm();
+	size_t nCycles = mg.solve(1e-9 * r0, 50);
+	double r = mg.residualNorm();
+	double rate = std::pow(r / r0, 1.0 / nCycles);
+
+	double error = 0.0;
+	tree.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		VecD c = (VecD(cursor.position().m_position) + 0.5) / VecD(cursor.position().m_resolution);
+		error = std::max(error, std::abs(mg.solution()[cursor.cell()] - exact(c)));
+	}
+	, LocatedCursor());
+
+	std::cout << name << " : " << tree.getNumberOfLeaves() << " leaves, " << nCycles << " cycles, rate = " << rate
+		<< ", max error = " << error << std::endl;
+	assert(r <= 1e-9 * r0);
+	assert(rate < maxRate);
+	assert(error < 0.01);
+}
+
+int main()
+{
+	using Tree2 = hct::HyperCubeTree< 2, hct::SimpleSubdivisionScheme<2> >;
+	using Multigrid2 = hct::TreeMultigrid<Tree2>;
+	using Vec2d = hct::Vec<double, 2>;
+	auto sin2 = [](const Vec2d& x) { double c[2]; x.toArray(c); return std::sin(Pi * c[0]) * std::sin(Pi * c[1]); };
+	auto cos2 = [](const Vec2d& x) { double c[2]; x.toArray(c); return std::cos(Pi * c[0]) * std::cos(Pi * c[1]); };
+
+	{
+		hct::SimpleSubdivisionScheme<2> subdivisions;
+		for (int i = 0; i < 8; i++) { subdivisions.addLevelSubdivision({ 2,2 }); }
+		Tree2 tree(subdivisions);
+		refineAroundCircle(tree, 5, 8);
+		testPoisson(tree, Multigrid2::Boundary::Dirichlet, sin2, 2.0 * Pi * Pi, 0.3, "2D adaptive, Dirichlet");
+		testPoisson(tree, Multigrid2::Boundary::Neumann, cos2, 2.0 * Pi * Pi, 0.3, "2D adaptive, Neumann");
+	}
+
+	// anisotropic subdivisions : cells of intermediate levels are stretched, point relaxation is less efficient
+	{
+		hct::SimpleSubdivisionScheme<2> subdivisions;
+		subdivisions.addLevelSubdivision({ 3,2 });
+		for (int i = 0; i < 4; i++) { subdivisions.addLevelSubdivision({ 2,2 }); }
+		subdivisions.addLevelSubdivision({ 2,3 });
+		subdivisions.addLevelSubdivision({ 2,2 });
+		Tree2 tree(subdivisions);
+		refineAroundCircle(tree, 4, 7);
+		testPoisson(tree, Multigrid2::Boundary::Dirichlet, sin2, 2.0 * Pi * Pi, 0.7, "2D anisotropic, Dirichlet");
+	}
+
+	{
+		using Tree3 = hct::HyperCubeTree< 3, hct::SimpleSubdivisionScheme<3> >;
+		using Vec3d = hct::Vec<double, 3>;
+		hct::SimpleSubdivisionScheme<3> subdivisions;
+		for (int i = 0; i < 5; i++) { subdivisions.addLevelSubdivision({ 2,2,2 }); }
+		Tree3 tree(subdivisions);
+		refineAroundCircle(tree, 3, 5);
+		auto sin3 = [](const Vec3d& x) { double c[3]; x.toArray(c); return std::sin(Pi * c[0]) * std::sin(Pi * c[1]) * std::sin(Pi * c[2]); };
+		testPoisson(tree, hct::TreeMultigrid<Tree3>::Boundary::Dirichlet, sin3, 3.0 * Pi * Pi, 0.3, "3D adaptive, Dirichlet");
+	}
+
+	return 0;
+}
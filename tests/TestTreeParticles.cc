@@ -0,0 +1,152 @@
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "HyperCubeTreeLocatedCursor.h"
+#include "TreeParticles.h"
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <assert.h>
+
+using hct::Vec2d;
+using Tree = hct::HyperCubeTree< 2, hct::SimpleSubdivisionScheme<2> >;
+using LocatedCursor = hct::HyperCubeTreeLocatedCursor<Tree>;
+using Particles = hct::TreeParticles<Tree, double>;
+
+static const Vec2d Origin({ -1.0, 0.0 });
+static const Vec2d Size({ 2.0, 1.0 });
+
+static bool inside(const hct::HyperCubeTreeCellPosition<2>& position, const Vec2d& x)
+{
+	Vec2d lo = Origin + Size * Vec2d(position.m_position) / Vec2d(position.m_resolution);
+	Vec2d hi = Origin + Size * (Vec2d(position.m_position) + 1.0) / Vec2d(position.m_resolution);
+	return (x >= lo).reduce_and() && (x < hi).reduce_and();
+}
+
+// every particle lies in its leaf, leaf ranges cover the container in leaf order, ids are unique
+static void checkBinning(const Tree& tree, const Particles& particles)
+{
+	size_t n = 0;
+	tree.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		size_t leaf = tree.leafIndex(cursor.cell());
+		assert(particles.leafBegin(leaf) == n);
+		particles.forEachParticle(leaf, [&](size_t i)
+		{
+			assert(particles.cell(i) == cursor.cell());
+			assert(inside(cursor.position(), particles.position(i)));
+		});
+		n = particles.leafEnd(leaf);
+	}
+	, LocatedCursor());
+	assert(n == particles.size());
+
+	std::vector<bool> seen(particles.size() * 4, false);
+	for (size_t i = 0; i < particles.size(); i++)
+	{
+		size_t id = particles.id(i);
+		assert(id < seen.size() && !seen[id]);
+		seen[id] = true;
+		// attribute follows its particle
+		assert(particles.attribute(i) == static_cast<double>(id));
+	}
+}
+
+// refines leaves within a distance of a point
+static void refineAround(Tree& tree, const Vec2d& center, double radius, size_t maxLevel)
+{
+	std::vector<hct::HyperCubeTreeCell> refine;
+	tree.parseLeaves([&](const LocatedCursor& cursor)
+	{
+		Vec2d c = Origin + Size * (Vec2d(cursor.position().m_position) + 0.5) / Vec2d(cursor.position().m_resolution);
+		if (cursor.cell().level() < maxLevel && ((c - center) * (c - center)).reduce_add() < radius * radius) { refine.push_back(cursor.cell()); }
+	}
+	, LocatedCursor());
+	for (auto cell : refine) { tree.refine(cell); }
+}
+
+int main()
+{
+	hct::SimpleSubdivisionScheme<2> subdivisions;
+	subdivisions.addLevelSubdivision({ 4,2 });
+	for (size_t i = 0; i < 5; i++) { subdivisions.addLevelSubdivision({ 2,2 }); }
+	subdivisions.addLevelSubdivision({ 3,3 });
+	Tree tree(subdivisions);
+	Particles particles(tree, Origin, Size);
+
+	tree.refine(Tree::rootCell());
+	for (size_t l = 0; l < 5; l++) { refineAround(tree, Vec2d({ 0.0, 0.5 }), 0.4, 6); }
+
+	const size_t N = 20000;
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> ux(-1.0, 1.0), uy(0.0, 1.0);
+	for (size_t i = 0; i < N; i++)
+	{
+		size_t id = particles.add(Vec2d({ ux(rng), uy(rng) }));
+		particles.attribute(i) = static_cast<double>(id);
+	}
+	size_t removed = particles.update();
+	assert(removed == 0);
+	assert(particles.numberOfLocatedParticles() == N);
+	checkBinning(tree, particles);
+	std::cout << tree.getNumberOfLeaves() << " leaves, " << particles.size() << " particles" << std::endl;
+
+	// small moves : most particles stay in their leaf, the others are located from it
+	std::normal_distribution<double> step(0.0, 0.002);
+	for (size_t s = 0; s < 5; s++)
+	{
+		for (size_t i = 0; i < particles.size(); i++) { particles.position(i) += Vec2d(step(rng), step(rng)); }
+		removed = particles.update();
+		checkBinning(tree, particles);
+		std::cout << "step " << s << " : " << particles.numberOfLocatedParticles() << " particles changed leaf, " << removed << " left the domain" << std::endl;
+		assert(particles.numberOfLocatedParticles() < particles.size() / 4);
+	}
+
+	// refinement : particles of refined leaves go down to the children
+	refineAround(tree, Vec2d({ 0.5, 0.5 }), 0.3, 7);
+	removed = particles.update();
+	assert(removed == 0);
+	checkBinning(tree, particles);
+	std::cout << "refined : " << tree.getNumberOfLeaves() << " leaves, " << particles.numberOfLocatedParticles() << " particles located" << std::endl;
+
+	// coarsening (nested, several levels at once) : particles go up to the coarsened cells, other cells are renumbered
+	std::vector<hct::HyperCubeTreeCell> coarsen;
+	tree.preorderParseCells([&](const LocatedCursor& cursor)
+	{
+		Vec2d c = Origin + Size * (Vec2d(cursor.position().m_position) + 0.5) / Vec2d(cursor.position().m_resolution);
+		if (cursor.cell().level() >= 2 && !tree.isLeaf(cursor.cell()) && c.reduce_add() < 0.5) { coarsen.push_back(cursor.cell()); }
+	}
+	, LocatedCursor());
+	size_t nLeaves = tree.getNumberOfLeaves();
+	size_t nParticles = particles.size();
+	tree.coarsen(coarsen);
+	removed = particles.update();
+	assert(removed == 0);
+	checkBinning(tree, particles);
+	std::cout << "coarsened : " << nLeaves << " -> " << tree.getNumberOfLeaves() << " leaves" << std::endl;
+	assert(particles.size() == nParticles);
+
+	// particles leaving the domain are removed
+	size_t n = particles.size();
+	size_t out = 0;
+	for (size_t i = 0; i < particles.size(); i++)
+	{
+		if (particles.position(i).reduce_add() > 1.0)
+		{
+			particles.position(i) += Vec2d({ 1.0, 0.0 });
+			++out;
+		}
+	}
+	removed = particles.update();
+	assert(removed == out);
+	assert(particles.size() == n - out);
+	checkBinning(tree, particles);
+	std::cout << out << " particles removed, " << particles.size() << " left" << std::endl;
+
+	// nothing moved : no location, no reordering
+	particles.update();
+	assert(particles.numberOfLocatedParticles() == 0);
+
+	return 0;
+}
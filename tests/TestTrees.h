@@ -0,0 +1,72 @@
+#pragma once
+
+#include "HyperCubeTree.h"
+#include "SimpleSubdivisionScheme.h"
+#include "ScalarFunction.h"
+#include "TreeRefineImplicitSurface.h"
+
+#include <initializer_list>
+
+/*
+Trees shared by the unit tests : subdivision schemes and refinements of a tree built from them.
+*/
+namespace test_trees
+{
+	template<unsigned int D>
+	using Tree = hct::HyperCubeTree< D, hct::SimpleSubdivisionScheme<D> >;
+
+	// one level per grid, coarsest first
+	template<unsigned int D>
+	inline hct::SimpleSubdivisionScheme<D> subdivisions(std::initializer_list< std::initializer_list<unsigned int> > grids)
+	{
+		hct::SimpleSubdivisionScheme<D> scheme;
+		for (const auto& grid : grids) { scheme.addLevelSubdivision(grid); }
+		return scheme;
+	}
+
+	inline hct::SimpleSubdivisionScheme<3> octree(size_t nLevels)
+	{
+		hct::SimpleSubdivisionScheme<3> scheme;
+		for (size_t i = 0; i < nLevels; i++) { scheme.addLevelSubdivision({ 2,2,2 }); }
+		return scheme;
+	}
+
+	// mixed subdivisions, with an anisotropic first level and a flat last one
+	inline hct::SimpleSubdivisionScheme<3> mixed()
+	{
+		return subdivisions<3>({ { 2,2,4 }, { 3,3,3 }, { 2,2,2 }, { 3,1,3 } });
+	}
+
+	// root and its children refined : a uniform grid at level 2
+	template<typename TreeT>
+	inline void refineUniform(TreeT& tree)
+	{
+		tree.refine(tree.rootCell());
+		size_t n = tree.getLevelSubdivisionGrid(0).gridSize();
+		for (size_t i = 0; i < n; i++) { tree.refine(tree.child(tree.rootCell(), i)); }
+	}
+
+	// needs a 2x3, 3x2 scheme : a fine column next to coarse leaves, three levels meeting
+	template<typename TreeT>
+	inline void refineCoarseFine(TreeT& tree)
+	{
+		tree.refine(tree.rootCell());
+		tree.refine(tree.child(tree.rootCell(), 1));
+		tree.refine(tree.child(tree.child(tree.rootCell(), 1), 4));
+	}
+
+	// unbalanced : fine leaves around a sphere off the domain center
+	template<typename TreeT>
+	inline void refineSphere(TreeT& tree, size_t maxLevel)
+	{
+		hct::tree_refine_implicit_surface(tree, hct::csg_sphere(hct::Vec3d({ 0.3,0.4,0.5 }), 0.25), maxLevel);
+	}
+
+	// a spherical shell cut by a sphere, with large level jumps where both surfaces meet
+	template<typename TreeT>
+	inline void refineShell(TreeT& tree, size_t maxLevel)
+	{
+		auto shape = hct::csg_difference(hct::csg_sphere(hct::Vec3d({ 0.0,0.0,0.0 }), 1.0), hct::csg_sphere(hct::Vec3d({ 0.5,0.5,0.5 }), 0.5));
+		hct::tree_refine_implicit_surface(tree, shape, maxLevel);
+	}
+}
@@ -0,0 +1,75 @@
+#include "UnionFind.h"
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <utility>
+#include <assert.h>
+
+// sets are the connected components of a random graph, compared with a sequential labelling
+static void testUnionFind(int n, int nEdges)
+{
+	std::mt19937 rng(n);
+	std::uniform_int_distribution<int> dist(0, n - 1);
+	std::vector< std::pair<int,int> > edges(nEdges);
+	for (auto& e : edges)
+	{
+		e = std::make_pair(dist(rng), dist(rng));
+	}
+
+	// reference : repeated min label propagation until nothing changes
+	std::vector<int> label(n);
+	for (int i = 0; i < n; i++) label[i] = i;
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (const auto& e : edges)
+		{
+			int m = std::min(label[e.first], label[e.second]);
+			if (label[e.first] != m || label[e.second] != m)
+			{
+				label[e.first] = label[e.second] = m;
+				changed = true;
+			}
+		}
+	}
+
+	hct::UnionFind sets(n);
+#	pragma omp parallel for
+	for (int i = 0; i < nEdges; i++)
+	{
+		sets.unite(edges[i].first, edges[i].second);
+	}
+	for (int i = 0; i < n; i++)
+	{
+		// root of a set is its smallest element, like the propagated label
+		assert(sets.find(i) == label[i]);
+	}
+	for (const auto& e : edges)
+	{
+		assert(sets.same(e.first, e.second));
+		assert(!sets.unite(e.first, e.second));
+	}
+	std::cout << "union find of " << n << " elements, " << nEdges << " unions Ok" << std::endl;
+}
+
+int main()
+{
+	hct::UnionFind sets(4);
+	assert(sets.size() == 4);
+	assert(sets.unite(3, 1));
+	assert(sets.find(3) == 1);
+	assert(!sets.same(0, 3));
+	assert(sets.unite(2, 0));
+	assert(sets.unite(3, 2));
+	for (int i = 0; i < 4; i++) assert(sets.find(i) == 0);
+	sets.reset(4);
+	assert(!sets.same(0, 3));
+
+	testUnionFind(10, 5);
+	testUnionFind(1000, 500);
+	testUnionFind(100000, 80000);
+	testUnionFind(100000, 200000);
+	return 0;
+}